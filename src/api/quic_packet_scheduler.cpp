@@ -444,6 +444,30 @@ void StreamFrameScheduler::writeStreamsHelper(PacketBuilderInterface& builder,
     }
 }
 
+bool StreamFrameScheduler::writeKeyframeStreams(PacketBuilderInterface& builder,
+    uint64_t& connWritableBytes) {
+    bool wroteStream = false;
+    for (auto streamId : conn_.streamManager->mediaStreams()) {
+        if (builder.remainingSpaceInPkt() == 0) {
+            break;
+        }
+        auto stream = conn_.streamManager->findStream(streamId);
+        if (!stream || stream->isControl || !stream->hasWritableData() ||
+            !stream->hasUnsentKeyframeData()) {
+            continue;
+        }
+        auto remainingSpaceBefore = builder.remainingSpaceInPkt();
+        bool written = writeSingleStream(builder, *stream, connWritableBytes);
+        if (builder.remainingSpaceInPkt() < remainingSpaceBefore) {
+            wroteStream = true;
+        }
+        if (!written) {
+            break;
+        }
+    }
+    return wroteStream;
+}
+
 void StreamFrameScheduler::writeStreams(PacketBuilderInterface& builder) {
     //DCHECK(conn_.streamManager->hasWritable());
     uint64_t connWritableBytes = getSendConnFlowControlBytesWire(conn_);
@@ -458,6 +482,13 @@ void StreamFrameScheduler::writeStreams(PacketBuilderInterface& builder) {
             conn_.transportSettings.streamFramePerPacket);
     }
     auto& writeQueue = conn_.streamManager->writeQueue();
+    // A stream's write offset only moves once the packet is sent, so a stream
+    // written by the keyframe pass must not be visited again in this packet.
+    if (!writeQueue.empty() && !conn_.streamManager->mediaStreams().empty() &&
+        isCongestionLimitingWrites(conn_) &&
+        writeKeyframeStreams(builder, connWritableBytes)) {
+        return;
+    }
     if (!writeQueue.empty()) {
         writeStreamsHelper(
             builder,
@@ -795,21 +826,13 @@ SchedulingResult CloningScheduler::scheduleFramesForPacket(PacketBuilderInterfac
     // independent header builder.
     auto header = builder.getPacketHeader();
     std::move(builder).releaseOutputBuffer();
+    auto builderPnSpace = header.getPacketNumberSpace();
     // Look for an outstanding packet that's no larger than the writableBytes
-    for (auto& outstandingPacket : conn_.outstandings.packets) {
+    // in the builder's packet number space.
+    for (auto& outstandingPacket : conn_.outstandings.packets[builderPnSpace]) {
         if (outstandingPacket.declaredLost || outstandingPacket.isDSRPacket) {
             continue;
         }
-        auto opPnSpace = outstandingPacket.packet.header.getPacketNumberSpace();
-        // Reusing the RegularQuicPacketBuilder throughout loop bodies will lead to
-        // frames belong to different original packets being written into the same
-        // clone packet. So re-create a RegularQuicPacketBuilder every time.
-        // TODO: We can avoid the copy & rebuild of the header by creating an
-        // independent header builder.
-        auto builderPnSpace = builder.getPacketHeader().getPacketNumberSpace();
-        if (opPnSpace != builderPnSpace) {
-            continue;
-        }
         size_t prevSize = 0;
         if (conn_.transportSettings.dataPathType == DataPathType::ContinuousMemory) {
             ScopedBufAccessor scopedBufAccessor(conn_.bufAccessor);
@@ -829,8 +852,8 @@ SchedulingResult CloningScheduler::scheduleFramesForPacket(PacketBuilderInterfac
         }
         // If the packet is already a clone that has been processed, we don't clone
         // it again.
-        if (outstandingPacket.associatedEvent && conn_.outstandings.packetEvents.count(
-                *outstandingPacket.associatedEvent) == 0) {
+        if (outstandingPacket.associatedEvent &&
+            !conn_.outstandings.cloneGroups.isPending(*outstandingPacket.associatedEvent)) {
             continue;
         }
         // I think this only fail if udpSendPacketLen somehow shrinks in the middle
@@ -109,6 +109,17 @@ class StreamFrameScheduler {
       uint64_t& connWritableBytes,
       bool streamPerPacket);
 
+  /**
+   * Write the streams that still have keyframe data buffered, ahead of the
+   * priority order. Only used when the congestion window cannot fit all the
+   * buffered data.
+   *
+   * Return: true if anything was written into the packet.
+   */
+  bool writeKeyframeStreams(
+      PacketBuilderInterface& builder,
+      uint64_t& connWritableBytes);
+
   /**
    * Helper function to write either stream data if stream is not flow
    * controlled or a blocked frame otherwise.
@@ -176,6 +176,14 @@ public:
          */
         virtual void onAppRateLimited() noexcept {}
 
+        /**
+         * Invoked when the congestion controller changes the bitrate the app
+         * should send at, in bits per second. Only the controllers which are
+         * rate based for real-time media, e.g. CongestionControlType::Media,
+         * set one.
+         */
+        virtual void onTargetBitrateChange(uint64_t /*bitsPerSecond*/) noexcept {}
+
         /**
          * Invoked when we receive a KnobFrame from the peer
          */
@@ -235,6 +243,10 @@ public:
         folly::Optional<PacketNum> largestPacketAckedByPeer;
         folly::Optional<PacketNum> largestPacketSent;
         bool usedZeroRtt{false};
+        // Bytes this connection holds in stream and datagram buffers.
+        uint64_t bytesBuffered{0};
+        // Buffer memory in use on the shard as a fraction of its limit.
+        double shardMemoryPressure{0};
         // State from congestion control module, if one is installed.
         folly::Optional<CongestionController::State> maybeCCState;
     };
@@ -782,6 +794,18 @@ public:
      */
     virtual folly::Expected<StreamId, LocalErrorCode> createUnidirectionalStream(bool replaySafe = true) = 0;
 
+    /**
+     * Creates numStreams bidirectional streams at once and returns their ids
+     * in increasing order. If fewer than numStreams streams can be opened,
+     * no stream is created and STREAM_LIMIT_EXCEEDED is returned.
+     */
+    virtual folly::Expected<std::vector<StreamId>, LocalErrorCode> createBidirectionalStreams(uint64_t numStreams) = 0;
+
+    /**
+     * Same as createBidirectionalStreams(), but for unidirectional streams.
+     */
+    virtual folly::Expected<std::vector<StreamId>, LocalErrorCode> createUnidirectionalStreams(uint64_t numStreams) = 0;
+
     /**
      *  Create a bidirectional stream group.
      */
@@ -1074,6 +1098,17 @@ public:
     using WriteResult = folly::Expected<folly::Unit, LocalErrorCode>;
     virtual WriteResult writeChain(StreamId id, Buf data, bool eof, ByteEventCallback* cb = nullptr) = 0;
 
+    /**
+     * Same as writeChain, and tags the data with what kind of media it is.
+     * While the congestion window cannot fit all the buffered data, streams
+     * with unsent keyframe data are written ahead of the priority order, and
+     * a stream whose buffered data is all droppable and unsent is reset with
+     * the error code given to setStreamDroppableErrorCode. Keep droppable frames on
+     * streams of their own, as the reset also abandons what was sent before.
+     */
+    virtual WriteResult writeMediaChain(StreamId id, Buf data, MediaDataType type, bool eof,
+        ByteEventCallback* cb = nullptr) = 0;
+
     /**
      * Write a data representation in the form of BufferMeta to the given stream.
      */
@@ -1299,6 +1334,51 @@ public:
      */
     [[nodiscard]] virtual QuicConnectionStats getConnectionsStats() const = 0;
 
+    using BandwidthEstimate = quic::BandwidthEstimate;
+
+    /**
+     * Callback class for bandwidth estimates
+     */
+    class BandwidthEstimateCallback {
+    public:
+        virtual ~BandwidthEstimateCallback() = default;
+
+        /**
+         * Invoked with the estimate over the last interval, after the ACKs
+         * closing it are processed.
+         */
+        virtual void onBandwidthEstimate(const BandwidthEstimate& estimate) noexcept = 0;
+    };
+
+    /**
+     * Subscribe to bandwidth estimates, e.g. to choose a rendition from. The
+     * estimates come from the ACKs the transport processes anyway, no probing
+     * traffic is sent, and at most one is delivered per interval, which is at
+     * least kMinBandwidthEstimateInterval. Pass nullptr to unsubscribe.
+     */
+    virtual folly::Expected<folly::Unit, LocalErrorCode> setBandwidthEstimateCallback(
+        BandwidthEstimateCallback* cb, std::chrono::milliseconds interval = kDefaultBandwidthEstimateInterval) = 0;
+
+    using CongestionStateSnapshot = quic::CongestionStateSnapshot;
+
+    /**
+     * The congestion controller, pacer and RTT state of the connection, for a
+     * connection rebuilt on another shard to go on at the same rate rather
+     * than from slow start. It is plain values, so it can be handed to the
+     * other shard's evb. A connection moved with detachEventBase() and
+     * attachEventBase() keeps its state and doesn't need it. None if the
+     * congestion controller doesn't support snapshots: only Cubic, BBR and
+     * BBR2 do.
+     */
+    [[nodiscard]] virtual folly::Optional<CongestionStateSnapshot> getCongestionStateSnapshot() const = 0;
+
+    /**
+     * Goes on from snapshot, taken with getCongestionStateSnapshot() from a
+     * connection with the same congestion controller type.
+     */
+    virtual folly::Expected<folly::Unit, LocalErrorCode> restoreCongestionState(
+        const CongestionStateSnapshot& snapshot) = 0;
+
     /**
      * ===== Datagram API =====
      *
@@ -1354,6 +1434,23 @@ public:
     setStreamGroupRetransmissionPolicy(StreamGroupId groupId,
         std::optional<QuicStreamGroupRetransmissionPolicy> policy) noexcept = 0;
 
+    /**
+     * Sets a deadline on the data of a stream, expiry from now. Once it has
+     * passed, lost data on the stream is not retransmitted; instead the stream
+     * is reset with errorCode so the peer can skip ahead. Passing folly::none
+     * clears the deadline.
+     */
+    virtual folly::Expected<folly::Unit, LocalErrorCode> setStreamExpiry(StreamId id,
+        folly::Optional<std::chrono::microseconds> expiry,
+        ApplicationErrorCode errorCode = GenericApplicationErrorCode::NO_ERROR) = 0;
+
+    /**
+     * Sets the error code a stream is reset with when its unsent droppable
+     * data is discarded, see writeMediaChain.
+     */
+    virtual folly::Expected<folly::Unit, LocalErrorCode> setStreamDroppableErrorCode(StreamId id,
+        ApplicationErrorCode errorCode) = 0;
+
 protected:
     /**
      * Returns the SocketObserverList or nullptr if not available.
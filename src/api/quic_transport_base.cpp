@@ -10,17 +10,22 @@
 #include <folly/Chrono.h>
 #include <folly/ScopeGuard.h>
 #include "loop_detector_callback.h"
+#include "congestion_control/congestion_controller_calls.h"
+#include "congestion_control/congestion_control_functions.h"
 #include "quic_transport_function.h"
 #include "common/TimeUtil.h"
+#include "congestion_control/congestion_hint_cache.h"
 #include "congestion_control/pacer.h"
 #include "congestion_control/tokenless_pacer.h"
 
 #include "logging/qlogger_constants.h"
 #include "loss/quic_loss_functions.h"
+#include "state/ack_handlers.h"
 #include "state/quic_pacing_functions.h"
 #include "state/quic_state_function.h"
 #include "state/quic_stream_function.h"
 #include "state/quic_stream_utilities.h"
+#include "state/shard_memory_accountant.h"
 #include "state/simple_frame_functions.h"
 #include "state/stream/stream_send_handlers.h"
 
@@ -33,13 +38,7 @@ QuicTransportBase::QuicTransportBase(
     bool useConnectionEndWithErrorCallback)
     : socket_(std::move(socket)),
       useConnectionEndWithErrorCallback_(useConnectionEndWithErrorCallback),
-      lossTimeout_(this),
-      ackTimeout_(this),
-      pathValidationTimeout_(this),
-      idleTimeout_(this),
-      keepaliveTimeout_(this),
-      drainTimeout_(this),
-      pingTimeout_(this),
+      timeouts_(this),
       readLooper_(new FunctionLooper(
           evb ? &qEvb_ : nullptr,
           [this]() { invokeReadDataAndCallbacks(); },
@@ -147,6 +146,9 @@ const folly::SocketAddress& QuicTransportBase::getLocalAddress() const {
 
 QuicTransportBase::~QuicTransportBase() {
   resetConnectionCallbacks();
+  if (conn_) {
+    releaseShardMemoryAccounting(*conn_);
+  }
 
   // closeImpl and closeUdpSocket should have been triggered by destructor of
   // derived class to ensure that observers are properly notified
@@ -195,8 +197,8 @@ void QuicTransportBase::closeNow(folly::Optional<QuicError> errorCode) {
   // the drain timeout may have been scheduled by a previous close, in which
   // case, our close would not take effect. This cancels the drain timeout in
   // this case and expires the timeout.
-  if (drainTimeout_.isScheduled()) {
-    drainTimeout_.cancelTimeout();
+  if (timeouts_.isScheduled(TimeoutType::Drain)) {
+    timeouts_.cancel(TimeoutType::Drain);
     drainTimeoutExpired();
   }
 }
@@ -288,6 +290,8 @@ void QuicTransportBase::closeImpl(
          conn_->dsrPacketCount});
   }
 
+  recordCongestionHint(*conn_);
+
   // TODO: truncate the error code string to be 1MSS only.
   closeState_ = CloseState::CLOSED;
   updatePacingOnClose(*conn_);
@@ -341,11 +345,11 @@ void QuicTransportBase::closeImpl(
     }
   }
   cancelLossTimeout();
-  ackTimeout_.cancelTimeout();
-  pathValidationTimeout_.cancelTimeout();
-  idleTimeout_.cancelTimeout();
-  keepaliveTimeout_.cancelTimeout();
-  pingTimeout_.cancelTimeout();
+  timeouts_.cancel(TimeoutType::Ack);
+  timeouts_.cancel(TimeoutType::PathValidation);
+  timeouts_.cancel(TimeoutType::Idle);
+  timeouts_.cancel(TimeoutType::Keepalive);
+  timeouts_.cancel(TimeoutType::Ping);
 
   //VLOG(10) << "Stopping read looper due to immediate close " << *this;
   readLooper_->stop();
@@ -412,9 +416,9 @@ void QuicTransportBase::closeImpl(
       drainConnection && !isReset && !isAbandon && !isInvalidMigration;
   if (drainConnection) {
     // We ever drain once, and the object ever gets created once.
-    //DCHECK(!drainTimeout_.isScheduled());
-    getEventBase()->timer().scheduleTimeout(
-        &drainTimeout_,
+    //DCHECK(!timeouts_.isScheduled(TimeoutType::Drain));
+    timeouts_.schedule(
+        TimeoutType::Drain,
         folly::chrono::ceil<std::chrono::milliseconds>(
             kDrainFactor * calculatePTO(*conn_)));
   } else {
@@ -624,6 +628,9 @@ QuicSocket::TransportInfo QuicTransportBase::getTransportInfo() const {
       conn_->ackStates.appDataAckState.largestAckedByPeer;
   transportInfo.largestPacketSent = conn_->lossState.largestSent;
   transportInfo.usedZeroRtt = conn_->usedZeroRtt;
+  transportInfo.bytesBuffered = connectionBufferedBytes(*conn_);
+  transportInfo.shardMemoryPressure =
+      ShardMemoryAccountant::getThreadLocalInstance().pressure();
   transportInfo.maybeCCState = maybeCCState;
   return transportInfo;
 }
@@ -649,9 +656,12 @@ uint64_t QuicTransportBase::bufferSpaceAvailable() const {
   auto bytesBuffered = conn_->flowControlState.sumCurStreamBufferLen;
   auto totalBufferSpaceAvailable =
       conn_->transportSettings.totalBufferSpaceAvailable;
-  return bytesBuffered > totalBufferSpaceAvailable
+  auto connBufferSpaceAvailable = bytesBuffered > totalBufferSpaceAvailable
       ? 0
       : totalBufferSpaceAvailable - bytesBuffered;
+  return std::min(
+      connBufferSpaceAvailable,
+      ShardMemoryAccountant::getThreadLocalInstance().writeHeadroom());
 }
 
 folly::Expected<QuicSocket::FlowControlState, LocalErrorCode>
@@ -1268,6 +1278,8 @@ folly::Expected<std::pair<Buf, bool>, LocalErrorCode> QuicTransportBase::read(
   }
   FOLLY_MAYBE_UNUSED auto self = sharedGuard();
   SCOPE_EXIT {
+    // What the app read no longer counts against the shard.
+    updateShardMemoryAccounting(*conn_);
     updateReadLooper();
     updatePeekLooper(); // read can affect "peek" API
     updateWriteLooper(true);
@@ -1370,6 +1382,7 @@ folly::
   }
   FOLLY_MAYBE_UNUSED auto self = sharedGuard();
   SCOPE_EXIT {
+    updateShardMemoryAccounting(*conn_);
     updatePeekLooper();
     updateReadLooper(); // consume may affect "read" API
     updateWriteLooper(true);
@@ -1439,12 +1452,12 @@ void QuicTransportBase::handlePingCallbacks() {
   if (!conn_->pendingEvents.cancelPingTimeout) {
     return; // nothing to cancel
   }
-  if (!pingTimeout_.isScheduled()) {
+  if (!timeouts_.isScheduled(TimeoutType::Ping)) {
     // set cancelpingTimeOut to false, delayed acks
     conn_->pendingEvents.cancelPingTimeout = false;
     return; // nothing to do, as timeout has already fired
   }
-  pingTimeout_.cancelTimeout();
+  timeouts_.cancel(TimeoutType::Ping);
   if (pingCallback_ != nullptr) {
     pingCallback_->pingAcknowledged();
   }
@@ -1535,6 +1548,22 @@ void QuicTransportBase::handleKnobCallbacks() {
   conn_->pendingEvents.knobs.clear();
 }
 
+void QuicTransportBase::handleTargetBitrateCallbacks() {
+  if (auto targetBitrate = conn_->pendingEvents.targetBitrate) {
+    conn_->pendingEvents.targetBitrate.reset();
+    connCallback_->onTargetBitrateChange(*targetBitrate);
+  }
+}
+
+void QuicTransportBase::handleBandwidthEstimateCallbacks() {
+  if (auto estimate = conn_->pendingEvents.bandwidthEstimate) {
+    conn_->pendingEvents.bandwidthEstimate.reset();
+    if (bandwidthEstimateCallback_) {
+      bandwidthEstimateCallback_->onBandwidthEstimate(*estimate);
+    }
+  }
+}
+
 void QuicTransportBase::handleAckEventCallbacks() {
   auto& lastProcessedAckEvents = conn_->lastProcessedAckEvents;
   if (lastProcessedAckEvents.empty()) {
@@ -1555,6 +1584,9 @@ void QuicTransportBase::handleAckEventCallbacks() {
               observer->acksProcessed(observed, event);
             });
   }
+  for (auto& ackEvent : lastProcessedAckEvents) {
+    recycleAckEvent(*conn_, ackEvent);
+  }
   lastProcessedAckEvents.clear();
 }
 
@@ -1783,10 +1815,12 @@ void QuicTransportBase::handleConnWritable() {
 
 void QuicTransportBase::cleanupAckEventState() {
   // if there's no bytes in flight, clear any memory allocated for AckEvents
-  if (conn_->outstandings.packets.empty()) {
+  if (conn_->outstandings.empty()) {
     std::vector<AckEvent> empty;
     conn_->lastProcessedAckEvents.swap(empty);
-  } // memory allocated for vector will be freed
+    std::vector<std::vector<AckEvent::AckPacket>> emptyRecycled;
+    conn_->recycledAckedPackets.swap(emptyRecycled);
+  } // memory allocated for vectors will be freed
 }
 
 void QuicTransportBase::processCallbacksAfterNetworkData() {
@@ -1816,6 +1850,16 @@ void QuicTransportBase::processCallbacksAfterNetworkData() {
     return;
   }
 
+  handleTargetBitrateCallbacks();
+  if (closeState_ != CloseState::OPEN) {
+    return;
+  }
+
+  handleBandwidthEstimateCallbacks();
+  if (closeState_ != CloseState::OPEN) {
+    return;
+  }
+
   handleAckEventCallbacks();
   if (closeState_ != CloseState::OPEN) {
     return;
@@ -1856,6 +1900,7 @@ void QuicTransportBase::onNetworkData(
   FOLLY_MAYBE_UNUSED auto self = sharedGuard();
   SCOPE_EXIT {
     checkForClosedStream();
+    updateShardMemoryAccounting(*conn_);
     updateReadLooper();
     updatePeekLooper();
     updateWriteLooper(true);
@@ -1959,8 +2004,8 @@ void QuicTransportBase::setIdleTimer() {
   if (closeState_ == CloseState::CLOSED) {
     return;
   }
-  idleTimeout_.cancelTimeout();
-  keepaliveTimeout_.cancelTimeout();
+  timeouts_.cancel(TimeoutType::Idle);
+  timeouts_.cancel(TimeoutType::Keepalive);
   auto localIdleTimeout = conn_->transportSettings.idleTimeout;
   // The local idle timeout being zero means it is disabled.
   if (localIdleTimeout == 0ms) {
@@ -1969,13 +2014,12 @@ void QuicTransportBase::setIdleTimer() {
   auto peerIdleTimeout =
       conn_->peerIdleTimeout > 0ms ? conn_->peerIdleTimeout : localIdleTimeout;
   auto idleTimeout = timeMin(localIdleTimeout, peerIdleTimeout);
-  getEventBase()->timer().scheduleTimeout(&idleTimeout_, idleTimeout);
+  timeouts_.schedule(TimeoutType::Idle, idleTimeout);
   auto idleTimeoutCount = idleTimeout.count();
   if (conn_->transportSettings.enableKeepalive) {
     std::chrono::milliseconds keepaliveTimeout = std::chrono::milliseconds(
         idleTimeoutCount - static_cast<int64_t>(idleTimeoutCount * .15));
-    getEventBase()->timer().scheduleTimeout(
-        &keepaliveTimeout_, keepaliveTimeout);
+    timeouts_.schedule(TimeoutType::Keepalive, keepaliveTimeout);
   }
 }
 
@@ -2004,29 +2048,53 @@ QuicTransportBase::createStreamInternal(
   }
   if (streamResult) {
     const StreamId streamId = streamResult.value()->id;
-
-    if (getSocketObserverContainer() &&
-        getSocketObserverContainer()
-            ->hasObserversForEvent<
-                SocketObserverInterface::Events::streamEvents>()) {
-      getSocketObserverContainer()
-          ->invokeInterfaceMethod<
-              SocketObserverInterface::Events::streamEvents>(
-              [event = SocketObserverInterface::StreamOpenEvent(
-                   streamId,
-                   getStreamInitiator(streamId),
-                   getStreamDirectionality(streamId))](
-                  auto observer, auto observed) {
-                observer->streamOpened(observed, event);
-              });
-    }
-
+    notifyStreamOpened(streamId);
     return streamId;
   } else {
     return folly::makeUnexpected(streamResult.error());
   }
 }
 
+folly::Expected<std::vector<StreamId>, LocalErrorCode>
+QuicTransportBase::createStreamsInternal(
+    bool bidirectional,
+    uint64_t numStreams) {
+  if (closeState_ != CloseState::OPEN) {
+    return folly::makeUnexpected(LocalErrorCode::CONNECTION_CLOSED);
+  }
+  auto streamsResult = bidirectional
+      ? conn_->streamManager->createNextBidirectionalStreams(numStreams)
+      : conn_->streamManager->createNextUnidirectionalStreams(numStreams);
+  if (streamsResult.hasError()) {
+    return folly::makeUnexpected(streamsResult.error());
+  }
+  std::vector<StreamId> streamIds;
+  streamIds.reserve(streamsResult->size());
+  for (const auto stream : streamsResult.value()) {
+    streamIds.push_back(stream->id);
+    notifyStreamOpened(stream->id);
+  }
+  return streamIds;
+}
+
+void QuicTransportBase::notifyStreamOpened(StreamId streamId) {
+  if (getSocketObserverContainer() &&
+      getSocketObserverContainer()
+          ->hasObserversForEvent<
+              SocketObserverInterface::Events::streamEvents>()) {
+    getSocketObserverContainer()
+        ->invokeInterfaceMethod<
+            SocketObserverInterface::Events::streamEvents>(
+            [event = SocketObserverInterface::StreamOpenEvent(
+                 streamId,
+                 getStreamInitiator(streamId),
+                 getStreamDirectionality(streamId))](
+                auto observer, auto observed) {
+              observer->streamOpened(observed, event);
+            });
+  }
+}
+
 folly::Expected<StreamId, LocalErrorCode>
 QuicTransportBase::createBidirectionalStream(bool /*replaySafe*/) {
   return createStreamInternal(true);
@@ -2037,6 +2105,16 @@ QuicTransportBase::createUnidirectionalStream(bool /*replaySafe*/) {
   return createStreamInternal(false);
 }
 
+folly::Expected<std::vector<StreamId>, LocalErrorCode>
+QuicTransportBase::createBidirectionalStreams(uint64_t numStreams) {
+  return createStreamsInternal(true, numStreams);
+}
+
+folly::Expected<std::vector<StreamId>, LocalErrorCode>
+QuicTransportBase::createUnidirectionalStreams(uint64_t numStreams) {
+  return createStreamsInternal(false, numStreams);
+}
+
 folly::Expected<StreamGroupId, LocalErrorCode>
 QuicTransportBase::createBidirectionalStreamGroup() {
   if (closeState_ != CloseState::OPEN) {
@@ -2208,6 +2286,25 @@ QuicSocket::WriteResult QuicTransportBase::writeChain(
     Buf data,
     bool eof,
     ByteEventCallback* cb) {
+  return writeChainInternal(
+      id, std::move(data), eof, cb, MediaDataType::Unspecified);
+}
+
+QuicSocket::WriteResult QuicTransportBase::writeMediaChain(
+    StreamId id,
+    Buf data,
+    MediaDataType type,
+    bool eof,
+    ByteEventCallback* cb) {
+  return writeChainInternal(id, std::move(data), eof, cb, type);
+}
+
+QuicSocket::WriteResult QuicTransportBase::writeChainInternal(
+    StreamId id,
+    Buf data,
+    bool eof,
+    ByteEventCallback* cb,
+    MediaDataType type) {
   if (isReceivingStream(conn_->nodeType, id)) {
     return folly::makeUnexpected(LocalErrorCode::INVALID_OPERATION);
   }
@@ -2241,7 +2338,8 @@ QuicSocket::WriteResult QuicTransportBase::writeChain(
       wasAppLimitedOrIdle = conn_->congestionController->isAppLimited();
       wasAppLimitedOrIdle |= conn_->streamManager->isAppIdle();
     }
-    writeDataToQuicStream(*stream, std::move(data), eof);
+    writeDataToQuicStream(*stream, std::move(data), eof, type);
+    updateShardMemoryAccounting(*conn_);
     // If we were previously app limited restart pacing with the current rate.
     if (wasAppLimitedOrIdle && conn_->pacer) {
       conn_->pacer->reset();
@@ -2541,6 +2639,8 @@ void QuicTransportBase::checkForClosedStream() {
   if (closeState_ == CloseState::CLOSED) {
     return;
   }
+  // Streams that can be removed are reaped together once the scan is done.
+  std::vector<StreamId> streamsToRemove;
   auto itr = conn_->streamManager->closedStreams().begin();
   while (itr != conn_->streamManager->closedStreams().end()) {
     const auto& streamId = *itr;
@@ -2594,8 +2694,7 @@ void QuicTransportBase::checkForClosedStream() {
       conn_->qLogger->addTransportStateUpdate(
           getClosingStream(folly::to<std::string>(*itr)));
     }
-    conn_->streamManager->removeClosedStream(*itr);
-    maybeSendStreamLimitUpdates(*conn_);
+    streamsToRemove.push_back(*itr);
     if (readCbIt != readCallbacks_.end()) {
       readCallbacks_.erase(readCbIt);
     }
@@ -2605,6 +2704,11 @@ void QuicTransportBase::checkForClosedStream() {
     itr = conn_->streamManager->closedStreams().erase(itr);
   } // while
 
+  if (!streamsToRemove.empty()) {
+    conn_->streamManager->removeClosedStreams(streamsToRemove);
+    maybeSendStreamLimitUpdates(*conn_);
+  }
+
   if (closeState_ == CloseState::GRACEFUL_CLOSING &&
       conn_->streamManager->streamCount() == 0) {
     closeImpl(folly::none);
@@ -2622,6 +2726,42 @@ folly::Expected<folly::Unit, LocalErrorCode> QuicTransportBase::setPingCallback(
   return folly::unit;
 }
 
+folly::Expected<folly::Unit, LocalErrorCode>
+QuicTransportBase::setBandwidthEstimateCallback(
+    BandwidthEstimateCallback* cb,
+    std::chrono::milliseconds interval) {
+  if (closeState_ != CloseState::OPEN) {
+    return folly::makeUnexpected(LocalErrorCode::CONNECTION_CLOSED);
+  }
+  bandwidthEstimateCallback_ = cb;
+  conn_->bandwidthEstimateState = BandwidthEstimateState();
+  conn_->pendingEvents.bandwidthEstimate.reset();
+  if (cb) {
+    conn_->bandwidthEstimateState.interval =
+        std::max(interval, kMinBandwidthEstimateInterval);
+  }
+  return folly::unit;
+}
+
+folly::Optional<CongestionStateSnapshot>
+QuicTransportBase::getCongestionStateSnapshot() const {
+  return snapshotCongestionState(*conn_);
+}
+
+folly::Expected<folly::Unit, LocalErrorCode>
+QuicTransportBase::restoreCongestionState(
+    const CongestionStateSnapshot& snapshot) {
+  if (closeState_ != CloseState::OPEN) {
+    return folly::makeUnexpected(LocalErrorCode::CONNECTION_CLOSED);
+  }
+  if (!quic::restoreCongestionState(*conn_, snapshot)) {
+    return folly::makeUnexpected(LocalErrorCode::INVALID_OPERATION);
+  }
+  // The window may have opened.
+  updateWriteLooper(true);
+  return folly::unit;
+}
+
 void QuicTransportBase::sendPing(std::chrono::milliseconds pingTimeout) {
   /* Step 0: Connection should not be closed */
   if (closeState_ == CloseState::CLOSED) {
@@ -2730,9 +2870,8 @@ void QuicTransportBase::scheduleLossTimeout(std::chrono::milliseconds timeout) {
   if (closeState_ == CloseState::CLOSED) {
     return;
   }
-  auto& wheelTimer = getEventBase()->timer();
-  timeout = timeMax(timeout, wheelTimer.getTickInterval());
-  wheelTimer.scheduleTimeout(&lossTimeout_, timeout);
+  timeout = timeMax(timeout, ShardTimerWheel::kTickInterval);
+  timeouts_.schedule(TimeoutType::Loss, timeout);
 }
 
 void QuicTransportBase::scheduleAckTimeout() {
@@ -2740,7 +2879,7 @@ void QuicTransportBase::scheduleAckTimeout() {
     return;
   }
   if (conn_->pendingEvents.scheduleAckTimeout) {
-    if (!ackTimeout_.isScheduled()) {
+    if (!timeouts_.isScheduled(TimeoutType::Ack)) {
       auto factoredRtt = std::chrono::duration_cast<std::chrono::microseconds>(
           kAckTimerFactor * conn_->lossState.srtt);
       // If we are using ACK_FREQUENCY, disable the factored RTT heuristic
@@ -2748,19 +2887,18 @@ void QuicTransportBase::scheduleAckTimeout() {
       if (conn_->ackStates.appDataAckState.ackFrequencySequenceNumber) {
         factoredRtt = conn_->ackStates.maxAckDelay;
       }
-      auto& wheelTimer = getEventBase()->timer();
       auto timeout = timeMax(
           std::chrono::duration_cast<std::chrono::microseconds>(
-              wheelTimer.getTickInterval()),
+              ShardTimerWheel::kTickInterval),
           timeMin(conn_->ackStates.maxAckDelay, factoredRtt));
       auto timeoutMs = folly::chrono::ceil<std::chrono::milliseconds>(timeout);
       //VLOG(10) << __func__ << " timeout=" << timeoutMs.count() << "ms" << " factoredRtt=" << factoredRtt.count() << "us" << " " << *this;
-      wheelTimer.scheduleTimeout(&ackTimeout_, timeoutMs);
+      timeouts_.schedule(TimeoutType::Ack, timeoutMs);
     }
   } else {
-    if (ackTimeout_.isScheduled()) {
+    if (timeouts_.isScheduled(TimeoutType::Ack)) {
       //VLOG(10) << __func__ << " cancel timeout " << *this;
-      ackTimeout_.cancelTimeout();
+      timeouts_.cancel(TimeoutType::Ack);
     }
   }
 }
@@ -2769,13 +2907,12 @@ void QuicTransportBase::schedulePingTimeout(
     PingCallback* pingCb,
     std::chrono::milliseconds timeout) {
   // if a ping timeout is already scheduled, nothing to do, return
-  if (pingTimeout_.isScheduled()) {
+  if (timeouts_.isScheduled(TimeoutType::Ping)) {
     return;
   }
 
   pingCallback_ = pingCb;
-  auto& wheelTimer = getEventBase()->timer();
-  wheelTimer.scheduleTimeout(&pingTimeout_, timeout);
+  timeouts_.schedule(TimeoutType::Ping, timeout);
 }
 
 void QuicTransportBase::schedulePathValidationTimeout() {
@@ -2783,13 +2920,13 @@ void QuicTransportBase::schedulePathValidationTimeout() {
     return;
   }
   if (!conn_->pendingEvents.schedulePathValidationTimeout) {
-    if (pathValidationTimeout_.isScheduled()) {
+    if (timeouts_.isScheduled(TimeoutType::PathValidation)) {
       //VLOG(10) << __func__ << " cancel timeout " << *this;
       // This means path validation succeeded, and we should have updated to
       // correct state
-      pathValidationTimeout_.cancelTimeout();
+      timeouts_.cancel(TimeoutType::PathValidation);
     }
-  } else if (!pathValidationTimeout_.isScheduled()) {
+  } else if (!timeouts_.isScheduled(TimeoutType::PathValidation)) {
     auto pto = conn_->lossState.srtt +
         std::max(4 * conn_->lossState.rttvar, kGranularity) +
         conn_->lossState.maxAckDelay;
@@ -2799,16 +2936,117 @@ void QuicTransportBase::schedulePathValidationTimeout() {
     auto timeoutMs =
         folly::chrono::ceil<std::chrono::milliseconds>(validationTimeout);
     //VLOG(10) << __func__ << " timeout=" << timeoutMs.count() << "ms " << *this;
-    getEventBase()->timer().scheduleTimeout(&pathValidationTimeout_, timeoutMs);
+    timeouts_.schedule(TimeoutType::PathValidation, timeoutMs);
   }
 }
 
 void QuicTransportBase::cancelLossTimeout() {
-  lossTimeout_.cancelTimeout();
+  timeouts_.cancel(TimeoutType::Loss);
 }
 
 bool QuicTransportBase::isLossTimeoutScheduled() const {
-  return lossTimeout_.isScheduled();
+  return timeouts_.isScheduled(TimeoutType::Loss);
+}
+
+void QuicTransportBase::ConnectionTimeouts::schedule(
+    TimeoutType type,
+    std::chrono::milliseconds timeout) {
+  deadlines_[type] = Clock::now() + timeout;
+  update();
+}
+
+void QuicTransportBase::ConnectionTimeouts::cancel(TimeoutType type) {
+  if (!deadlines_[type]) {
+    return;
+  }
+  deadlines_[type].reset();
+  update();
+}
+
+void QuicTransportBase::ConnectionTimeouts::cancelAll() {
+  for (auto& deadline : deadlines_) {
+    deadline.reset();
+  }
+  if (auto evb = transport_->getEventBase()) {
+    ShardTimerWheel::get(*evb).remove(*this);
+  }
+}
+
+void QuicTransportBase::ConnectionTimeouts::update() {
+  folly::Optional<TimePoint> earliest;
+  for (const auto& deadline : deadlines_) {
+    if (deadline && (!earliest || *deadline < *earliest)) {
+      earliest = deadline;
+    }
+  }
+  auto evb = transport_->getEventBase();
+  if (!evb) {
+    // Filed by the next update() once attached.
+    return;
+  }
+  auto& wheel = ShardTimerWheel::get(*evb);
+  if (earliest) {
+    wheel.schedule(*this, *earliest);
+  } else {
+    wheel.cancel(*this);
+  }
+}
+
+void QuicTransportBase::ConnectionTimeouts::deadlineReached(
+    TimePoint now) noexcept {
+  // Any of the timeouts may close the transport.
+  FOLLY_MAYBE_UNUSED auto self = transport_->sharedGuard();
+  for (auto type : deadlines_.keys()) {
+    auto& deadline = deadlines_[type];
+    if (deadline && *deadline <= now) {
+      deadline.reset();
+      timeoutExpired(type);
+    }
+  }
+  update();
+}
+
+void QuicTransportBase::ConnectionTimeouts::timeoutExpired(
+    TimeoutType type) noexcept {
+  switch (type) {
+    case TimeoutType::Loss:
+      transport_->lossTimeoutExpired();
+      break;
+    case TimeoutType::Ack:
+      transport_->ackTimeoutExpired();
+      break;
+    case TimeoutType::PathValidation:
+      transport_->pathValidationTimeoutExpired();
+      break;
+    case TimeoutType::Idle:
+      transport_->idleTimeoutExpired(true /* drain */);
+      break;
+    case TimeoutType::Keepalive:
+      transport_->keepaliveTimeoutExpired();
+      break;
+    case TimeoutType::Drain:
+      transport_->drainTimeoutExpired();
+      break;
+    case TimeoutType::Ping:
+      transport_->pingTimeoutExpired();
+      break;
+  }
+}
+
+void QuicTransportBase::ConnectionTimeouts::wheelCanceled() noexcept {
+  // The evb is dying. As with its own timer callbacks, skip the drain when
+  // the idle timeout is canceled, and run a pending drain timeout right away.
+  auto idle = std::exchange(deadlines_[TimeoutType::Idle], folly::none);
+  auto drain = std::exchange(deadlines_[TimeoutType::Drain], folly::none);
+  for (auto& deadline : deadlines_) {
+    deadline.reset();
+  }
+  if (idle) {
+    transport_->idleTimeoutExpired(false /* drain */);
+  }
+  if (drain) {
+    transport_->drainTimeoutExpired();
+  }
 }
 
 void QuicTransportBase::setSupportedVersions(
@@ -2869,6 +3107,7 @@ void QuicTransportBase::cancelAllAppCallbacks(const QuicError& err) noexcept {
 
   //VLOG(4) << "Clearing ping callback";
   pingCallback_ = nullptr;
+  bandwidthEstimateCallback_ = nullptr;
 
   //VLOG(4) << "Clearing " << peekCallbacks_.size() << " peek callbacks";
   auto peekCallbacksCopy = peekCallbacks_;
@@ -3038,6 +3277,7 @@ QuicTransportBase::readDatagrams(size_t atMost) {
       std::back_inserter(retDatagrams),
       [](ReadDatagram& dg) { return std::move(dg); });
   datagrams->erase(datagrams->begin(), datagrams->begin() + atMost);
+  updateShardMemoryAccounting(*conn_);
   return retDatagrams;
 }
 
@@ -3061,6 +3301,7 @@ QuicTransportBase::readDatagramBufs(size_t atMost) {
       std::back_inserter(retDatagrams),
       [](ReadDatagram& dg) { return dg.bufQueue().move(); });
   datagrams->erase(datagrams->begin(), datagrams->begin() + atMost);
+  updateShardMemoryAccounting(*conn_);
   return retDatagrams;
 }
 
@@ -3077,6 +3318,7 @@ void QuicTransportBase::writeSocketData() {
         conn_->outstandings.numOutstanding();
 
     updatePacketProcessorsPrewriteRequests();
+    updateEcnMarking();
 
     // if we're starting to write from app limited, notify observers
     if (conn_->appLimitedTracker.isAppLimited() &&
@@ -3084,7 +3326,10 @@ void QuicTransportBase::writeSocketData() {
       conn_->appLimitedTracker.setNotAppLimited();
       notifyStartWritingFromAppRateLimited();
     }
+    resetExpiredStreams();
+    resetDroppableStreams();
     writeData();
+    updateShardMemoryAccounting(*conn_);
     if (closeState_ != CloseState::CLOSED) {
       if (conn_->pendingEvents.closeTransport == true) {
         throw QuicTransportException(
@@ -3150,7 +3395,7 @@ void QuicTransportBase::writeSocketData() {
           conn_->cryptoState->oneRttStream.lossBuffer.empty();
       if (conn_->congestionController &&
           currentSendBufLen < conn_->udpSendPacketLen && lossBufferEmpty &&
-          conn_->congestionController->getWritableBytes()) {
+          congestionControllerWritableBytes(*conn_)) {
         conn_->congestionController->setAppLimited();
         // notify via connection call and any observer callbacks
         if (transportReadyNotified_ && connCallback_) {
@@ -3212,6 +3457,14 @@ void QuicTransportBase::setTransportSettings(
     conn_->transportSettings = std::move(transportSettings);
     conn_->streamManager->refreshTransportSettings(conn_->transportSettings);
   }
+  if (const auto& shardMemoryConfig =
+          conn_->transportSettings.shardMemoryConfig) {
+    auto& accountant = ShardMemoryAccountant::getThreadLocalInstance();
+    accountant.setLimit(shardMemoryConfig->limitBytes);
+    accountant.setPressureThresholds(
+        shardMemoryConfig->moderatePressure,
+        shardMemoryConfig->severePressure);
+  }
 
   // A few values cannot be overridden to be lower than default:
   // TODO refactor transport settings to avoid having to update params twice.
@@ -3241,6 +3494,8 @@ void QuicTransportBase::setTransportSettings(
                               : conn_->transportSettings.minCwndInMss;
       conn_->pacer = std::make_unique<TokenlessPacer>(*conn_, minCwnd);
       conn_->pacer->setExperimental(conn_->transportSettings.experimentalPacer);
+      writeLooper_->setUsePacingCalendar(
+          conn_->transportSettings.useShardPacingCalendar);
       conn_->canBePaced = conn_->transportSettings.pacingEnabledFirstFlight;
       if (conn_->transportSettings.defaultCongestionController ==
           CongestionControlType::BBR2) {
@@ -3292,6 +3547,8 @@ void QuicTransportBase::updateCongestionControlSettings(
       transportSettings.pacingTickInterval;
   conn_->transportSettings.pacingTimerResolution =
       transportSettings.pacingTimerResolution;
+  conn_->transportSettings.useShardPacingCalendar =
+      transportSettings.useShardPacingCalendar;
   conn_->transportSettings.minBurstPackets = transportSettings.minBurstPackets;
   conn_->transportSettings.copaDeltaParam = transportSettings.copaDeltaParam;
   conn_->transportSettings.copaUseRttStanding =
@@ -3337,6 +3594,47 @@ QuicTransportBase::setStreamPriority(StreamId id, Priority priority) {
   return folly::unit;
 }
 
+folly::Expected<folly::Unit, LocalErrorCode> QuicTransportBase::setStreamExpiry(
+    StreamId id,
+    folly::Optional<std::chrono::microseconds> expiry,
+    ApplicationErrorCode errorCode) {
+  if (isReceivingStream(conn_->nodeType, id)) {
+    return folly::makeUnexpected(LocalErrorCode::INVALID_OPERATION);
+  }
+  if (closeState_ != CloseState::OPEN) {
+    return folly::makeUnexpected(LocalErrorCode::CONNECTION_CLOSED);
+  }
+  auto stream = conn_->streamManager->findStream(id);
+  if (!stream) {
+    return folly::makeUnexpected(LocalErrorCode::STREAM_NOT_EXISTS);
+  }
+  if (expiry) {
+    stream->expiryTime = Clock::now() + *expiry;
+  } else {
+    stream->expiryTime.reset();
+  }
+  stream->expiryErrorCode = errorCode;
+  return folly::unit;
+}
+
+folly::Expected<folly::Unit, LocalErrorCode>
+QuicTransportBase::setStreamDroppableErrorCode(
+    StreamId id,
+    ApplicationErrorCode errorCode) {
+  if (isReceivingStream(conn_->nodeType, id)) {
+    return folly::makeUnexpected(LocalErrorCode::INVALID_OPERATION);
+  }
+  if (closeState_ != CloseState::OPEN) {
+    return folly::makeUnexpected(LocalErrorCode::CONNECTION_CLOSED);
+  }
+  auto stream = conn_->streamManager->findStream(id);
+  if (!stream) {
+    return folly::makeUnexpected(LocalErrorCode::STREAM_NOT_EXISTS);
+  }
+  stream->droppableErrorCode = errorCode;
+  return folly::unit;
+}
+
 folly::Expected<Priority, LocalErrorCode> QuicTransportBase::getStreamPriority(
     StreamId id) {
   if (closeState_ != CloseState::OPEN) {
@@ -3426,12 +3724,11 @@ void QuicTransportBase::detachEventBase() {
   }
   connWriteCallback_ = nullptr;
   pendingWriteCallbacks_.clear();
-  lossTimeout_.cancelTimeout();
-  ackTimeout_.cancelTimeout();
-  pathValidationTimeout_.cancelTimeout();
-  idleTimeout_.cancelTimeout();
-  keepaliveTimeout_.cancelTimeout();
-  drainTimeout_.cancelTimeout();
+  // The wheel is the old shard's, so the entry can't stay linked in it.
+  timeouts_.cancelAll();
+  if (conn_->congestionController) {
+    conn_->congestionController->onEventBaseDetached();
+  }
   readLooper_->detachEventBase();
   peekLooper_->detachEventBase();
   writeLooper_->detachEventBase();
@@ -3489,7 +3786,7 @@ void QuicTransportBase::pacedWriteDataToSocket() {
   }
 
   // We are in the middle of a pacing interval. Leave it be.
-  if (writeLooper_->isScheduled()) {
+  if (writeLooper_->isPacingTimeoutScheduled()) {
     // The next burst is already scheduled. Since the burst size doesn't depend
     // on much data we currently have in buffer at all, no need to change
     // anything.
@@ -3755,6 +4052,8 @@ void QuicTransportBase::notifyAppRateLimited() {
 
 void QuicTransportBase::setCmsgs(const folly::SocketOptionMap& options) {
   socket_->setCmsgs(options);
+  // Replaced the ECN cmsg as well, set it again on the next write.
+  socketEcnCodepoint_ = kEcnNotECT;
 }
 
 void QuicTransportBase::appendCmsgs(const folly::SocketOptionMap& options) {
@@ -3850,6 +4149,58 @@ void QuicTransportBase::updatePacketProcessorsPrewriteRequests() {
   conn_->socketCmsgsState.targetWriteCount = conn_->writeCount;
 }
 
+void QuicTransportBase::updateEcnMarking() {
+  auto& ecnState = conn_->ecnState;
+  if (!conn_->transportSettings.enableEcnOnEgress) {
+    // Also stops marking if the setting was turned off mid-connection.
+    ecnState.state = ECNState::NotAttempted;
+  } else if (ecnState.state == ECNState::NotAttempted) {
+    ecnState.state = conn_->transportSettings.useL4sEcn
+        ? ECNState::AttemptingL4S
+        : ECNState::AttemptingECN;
+  }
+  auto codepoint = ecnState.codepoint();
+  if (!socket_ || codepoint == socketEcnCodepoint_) {
+    return;
+  }
+  // Set on the socket's default cmsgs rather than additionalCmsgs, which are
+  // copied into every outstanding packet.
+  folly::SocketOptionMap cmsgs;
+  if (socket_->address().getFamily() == AF_INET6) {
+    cmsgs[{IPPROTO_IPV6, IPV6_TCLASS}] = codepoint;
+  } else {
+    cmsgs[{IPPROTO_IP, IP_TOS}] = codepoint;
+  }
+  socket_->appendCmsgs(cmsgs);
+  socketEcnCodepoint_ = codepoint;
+}
+
+void QuicTransportBase::resetExpiredStreams() {
+  for (auto id : getExpiredLossStreams(*conn_, Clock::now())) {
+    auto stream = conn_->streamManager->findStream(id);
+    if (!stream) {
+      continue;
+    }
+    resetStream(id, stream->expiryErrorCode);
+    if (closeState_ != CloseState::OPEN) {
+      return;
+    }
+  }
+}
+
+void QuicTransportBase::resetDroppableStreams() {
+  for (auto id : getDroppableMediaStreams(*conn_)) {
+    auto stream = conn_->streamManager->findStream(id);
+    if (!stream) {
+      continue;
+    }
+    resetStream(id, stream->droppableErrorCode);
+    if (closeState_ != CloseState::OPEN) {
+      return;
+    }
+  }
+}
+
 folly::Optional<folly::SocketOptionMap>
 QuicTransportBase::getAdditionalCmsgsForAsyncUDPSocket() {
   if (conn_->socketCmsgsState.additionalCmsgs) {
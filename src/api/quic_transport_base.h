@@ -10,8 +10,10 @@
 #include "protocol/quic_constants.hpp"
 #include "protocol/quic_exception.h"
 #include "quic_socket.h"
+#include "common/EnumArray.h"
 #include "common/Events.h"
 #include "common/FunctionLooper.h"
+#include "common/ShardTimerWheel.h"
 #include "common/Timers.h"
 #include "congestion_control/congestion_control_factory.h"
 #include "congestion_control/copa.h"
@@ -125,6 +127,8 @@ public:
 
     folly::Expected<StreamId, LocalErrorCode> createBidirectionalStream(bool replaySafe = true) override;
     folly::Expected<StreamId, LocalErrorCode> createUnidirectionalStream(bool replaySafe = true) override;
+    folly::Expected<std::vector<StreamId>, LocalErrorCode> createBidirectionalStreams(uint64_t numStreams) override;
+    folly::Expected<std::vector<StreamId>, LocalErrorCode> createUnidirectionalStreams(uint64_t numStreams) override;
     folly::Expected<StreamGroupId, LocalErrorCode> createBidirectionalStreamGroup() override;
     folly::Expected<StreamGroupId, LocalErrorCode> createUnidirectionalStreamGroup() override;
     folly::Expected<StreamId, LocalErrorCode> createBidirectionalStreamInGroup(StreamGroupId groupId) override;
@@ -146,6 +150,9 @@ public:
 
     WriteResult writeChain(StreamId id, Buf data, bool eof, ByteEventCallback* cb = nullptr) override;
 
+    WriteResult writeMediaChain(StreamId id, Buf data, MediaDataType type, bool eof,
+        ByteEventCallback* cb = nullptr) override;
+
     // TODO: Maybe I should virtualize DSR related APIs and only implement in
     // QuicServerTransport
     WriteResult writeBufMeta(StreamId id, const BufferMeta& data, bool eof, ByteEventCallback* cb = nullptr) override;
@@ -162,6 +169,14 @@ public:
 
     folly::Expected<folly::Unit, LocalErrorCode> setPingCallback(PingCallback* cb) override;
 
+    folly::Expected<folly::Unit, LocalErrorCode> setBandwidthEstimateCallback(
+        BandwidthEstimateCallback* cb, std::chrono::milliseconds interval) override;
+
+    [[nodiscard]] folly::Optional<CongestionStateSnapshot> getCongestionStateSnapshot() const override;
+
+    folly::Expected<folly::Unit, LocalErrorCode> restoreCongestionState(
+        const CongestionStateSnapshot& snapshot) override;
+
     void sendPing(std::chrono::milliseconds pingTimeout) override;
 
     const QuicConnectionStateBase* getState() const override {
@@ -375,143 +390,52 @@ public:
     void clearBackgroundModeParameters();
 
     // Timeout functions
-    class LossTimeout : public folly::HHWheelTimer::Callback {
-    public:
-        ~LossTimeout() override = default;
-
-        explicit LossTimeout(QuicTransportBase* transport)
-            : transport_(transport) {}
-
-        void timeoutExpired() noexcept override {
-            transport_->lossTimeoutExpired();
-        }
-
-        virtual void callbackCanceled() noexcept override {
-            // ignore. this usually means that the eventbase is dying, so we will be
-            // canceled anyway
-            return;
-        }
-
-    private:
-        QuicTransportBase* transport_;
-    };
-
-    class AckTimeout : public folly::HHWheelTimer::Callback {
-    public:
-        ~AckTimeout() override = default;
-
-        explicit AckTimeout(QuicTransportBase* transport) : transport_(transport) {}
-
-        void timeoutExpired() noexcept override {
-            transport_->ackTimeoutExpired();
-        }
-
-        virtual void callbackCanceled() noexcept override {
-            // ignore. this usually means that the eventbase is dying, so we will be
-            // canceled anyway
-            return;
-        }
-
-    private:
-        QuicTransportBase* transport_;
-    };
-
-    class PingTimeout : public folly::HHWheelTimer::Callback {
-    public:
-        ~PingTimeout() override = default;
-
-        explicit PingTimeout(QuicTransportBase* transport)
-            : transport_(transport) {}
-
-        void timeoutExpired() noexcept override {
-            transport_->pingTimeoutExpired();
-        }
-
-        void callbackCanceled() noexcept override {
-            // ignore, as this happens only when event  base dies
-            return;
-        }
-
-    private:
-        QuicTransportBase* transport_;
+    enum class TimeoutType : uint8_t {
+        Loss,
+        Ack,
+        PathValidation,
+        Idle,
+        Keepalive,
+        Drain,
+        Ping,
+        MAX = Ping,
     };
 
-    class PathValidationTimeout : public folly::HHWheelTimer::Callback {
-    public:
-        ~PathValidationTimeout() override = default;
-
-        explicit PathValidationTimeout(QuicTransportBase* transport)
-            : transport_(transport) {}
-
-        void timeoutExpired() noexcept override {
-            transport_->pathValidationTimeoutExpired();
-        }
-
-        virtual void callbackCanceled() noexcept override {
-            // ignore. this usually means that the eventbase is dying, so we will be
-            // canceled anyway
-            return;
-        }
-
-    private:
-        QuicTransportBase* transport_;
-    };
-
-    class IdleTimeout : public folly::HHWheelTimer::Callback {
+    /**
+     * Deadlines of all the connection's timeouts. They are filed in the
+     * shard's timer wheel as a single entry under the earliest one, so that
+     * rescheduling, say, the idle timeout on every packet doesn't touch a
+     * timer callback.
+     */
+    class ConnectionTimeouts : public ShardTimerWheel::Entry {
     public:
-        ~IdleTimeout() override = default;
-
-        explicit IdleTimeout(QuicTransportBase* transport)
+        explicit ConnectionTimeouts(QuicTransportBase* transport)
             : transport_(transport) {}
 
-        void timeoutExpired() noexcept override {
-            transport_->idleTimeoutExpired(true /* drain */);
-        }
-
-        void callbackCanceled() noexcept override {
-            // skip drain when canceling the timeout, to avoid scheduling a new
-            // drain timeout
-            transport_->idleTimeoutExpired(false /* drain */);
-        }
+        void schedule(TimeoutType type, std::chrono::milliseconds timeout);
 
-    private:
-        QuicTransportBase* transport_;
-    };
+        void cancel(TimeoutType type);
 
-    class KeepaliveTimeout : public folly::HHWheelTimer::Callback {
-    public:
-        ~KeepaliveTimeout() override = default;
+        // Cancels every timeout and takes the entry out of the wheel, before
+        // the transport moves to another evb.
+        void cancelAll();
 
-        explicit KeepaliveTimeout(QuicTransportBase* transport)
-            : transport_(transport) {}
-
-        void timeoutExpired() noexcept override {
-            transport_->keepaliveTimeoutExpired();
-        }
-        void callbackCanceled() noexcept override {
-            // Specifically do nothing since if we got canceled we shouldn't write.
+        [[nodiscard]] bool isScheduled(TimeoutType type) const {
+            return deadlines_[type].has_value();
         }
 
     private:
-        QuicTransportBase* transport_;
-    };
+        void deadlineReached(TimePoint now) noexcept override;
 
-    // DrainTimeout is a bit different from other timeouts. It needs to hold a
-    // shared_ptr to the transport, since if a DrainTimeout is scheduled,
-    // transport cannot die.
-    class DrainTimeout : public folly::HHWheelTimer::Callback {
-    public:
-        ~DrainTimeout() override = default;
+        void wheelCanceled() noexcept override;
 
-        explicit DrainTimeout(QuicTransportBase* transport)
-            : transport_(transport) {}
+        void timeoutExpired(TimeoutType type) noexcept;
 
-        void timeoutExpired() noexcept override {
-            transport_->drainTimeoutExpired();
-        }
+        // Files the entry under the earliest deadline, or cancels it.
+        void update();
 
-    private:
         QuicTransportBase* transport_;
+        EnumArray<TimeoutType, folly::Optional<TimePoint>> deadlines_;
     };
 
     void scheduleLossTimeout(std::chrono::milliseconds timeout);
@@ -590,6 +514,13 @@ public:
         return conn_->retransmissionPolicies;
     }
 
+    folly::Expected<folly::Unit, LocalErrorCode> setStreamExpiry(StreamId id,
+        folly::Optional<std::chrono::microseconds> expiry,
+        ApplicationErrorCode errorCode = GenericApplicationErrorCode::NO_ERROR) override;
+
+    folly::Expected<folly::Unit, LocalErrorCode> setStreamDroppableErrorCode(StreamId id,
+        ApplicationErrorCode errorCode) override;
+
 protected:
     void updateCongestionControlSettings(const TransportSettings& transportSettings);
     void processCallbacksAfterWriteData();
@@ -602,6 +533,8 @@ protected:
     void updateWriteLooper(bool thisIteration);
     void handlePingCallbacks();
     void handleKnobCallbacks();
+    void handleTargetBitrateCallbacks();
+    void handleBandwidthEstimateCallbacks();
     void handleAckEventCallbacks();
     void handleCancelByteEventCallbacks();
     void handleNewStreamCallbacks(std::vector<StreamId>& newPeerStreams);
@@ -630,6 +563,9 @@ protected:
     folly::Expected<folly::Unit, LocalErrorCode> setReadCallbackInternal(StreamId id, ReadCallback* cb, folly::Optional<ApplicationErrorCode> err) noexcept;
     folly::Expected<folly::Unit, LocalErrorCode> setPeekCallbackInternal(StreamId id, PeekCallback* cb) noexcept;
     folly::Expected<StreamId, LocalErrorCode> createStreamInternal(bool bidirectional, const folly::Optional<StreamGroupId>& streamGroupId = folly::none);
+    folly::Expected<std::vector<StreamId>, LocalErrorCode> createStreamsInternal(bool bidirectional, uint64_t numStreams);
+    void notifyStreamOpened(StreamId streamId);
+    WriteResult writeChainInternal(StreamId id, Buf data, bool eof, ByteEventCallback* cb, MediaDataType type);
 
     /**
      * Helper function - if given error is not set, returns a generic app error.
@@ -770,6 +706,10 @@ protected:
 
     DatagramCallback* datagramCallback_{nullptr};
     PingCallback* pingCallback_{nullptr};
+    BandwidthEstimateCallback* bandwidthEstimateCallback_{nullptr};
+    // ECN codepoint the socket currently marks packets with, see
+    // updateEcnMarking().
+    uint8_t socketEcnCodepoint_{kEcnNotECT};
 
     WriteCallback* connWriteCallback_{nullptr};
     std::map<StreamId, WriteCallback*> pendingWriteCallbacks_;
@@ -777,13 +717,7 @@ protected:
     bool transportReadyNotified_{false};
     bool handshakeDoneNotified_{false};
 
-    LossTimeout lossTimeout_;
-    AckTimeout ackTimeout_;
-    PathValidationTimeout pathValidationTimeout_;
-    IdleTimeout idleTimeout_;
-    KeepaliveTimeout keepaliveTimeout_;
-    DrainTimeout drainTimeout_;
-    PingTimeout pingTimeout_;
+    ConnectionTimeouts timeouts_;
     FunctionLooper::Ptr readLooper_;
     FunctionLooper::Ptr peekLooper_;
     FunctionLooper::Ptr writeLooper_;
@@ -881,6 +815,27 @@ private:
      */
     void updatePacketProcessorsPrewriteRequests();
 
+    /**
+     * Starts marking packets ECN capable if enabled in the transport settings,
+     * and makes the socket's cmsgs follow conn_->ecnState, e.g. stop marking
+     * once validation failed.
+     */
+    void updateEcnMarking();
+
+    /**
+     * Resets the streams whose lost data expired before it could be
+     * retransmitted, with the stream's expiryErrorCode, the same way the app
+     * resets a stream.
+     */
+    void resetExpiredStreams();
+
+    /**
+     * While writes are congestion limited, resets the media streams whose
+     * buffered data is all droppable and unsent, with the stream's
+     * droppableErrorCode.
+     */
+    void resetDroppableStreams();
+
 private:
     QuicEventBase qEvb_;
 };
@@ -14,6 +14,7 @@
 #include "protocol/quic_header.hpp"
 #include "protocol/quic_frame.hpp"
 #include "protocol/quic.hpp"
+#include "congestion_control/congestion_controller_calls.h"
 #include "flowcontrol/quic_flow_control.h"
 #include "happyeyeballs/QuicHappyEyeballsFunctions.h"
 #include "state/ack_handlers.h"
@@ -846,16 +847,6 @@ void updateConnection(
   }
   conn.lossState.totalAckElicitingPacketsSent++;
 
-  auto packetIt =
-      std::find_if(
-          conn.outstandings.packets.rbegin(),
-          conn.outstandings.packets.rend(),
-          [packetNum](const auto& packetWithTime) {
-            return packetWithTime.packet.header.getPacketSequenceNum() <
-                packetNum;
-          })
-          .base();
-
   std::function<void(const quic::OutstandingPacketWrapper&)> packetDestroyFn =
       [&conn](const quic::OutstandingPacketWrapper& pkt) {
         for (auto& packetProcessor : conn.packetProcessors) {
@@ -863,8 +854,8 @@ void updateConnection(
         }
       };
 
-  auto& pkt = *conn.outstandings.packets.emplace(
-      packetIt,
+  auto& pkt = conn.outstandings.packets[packetNumberSpace].emplace(
+      packetNum,
       std::move(packet),
       sentTime,
       encodedSize,
@@ -883,7 +874,10 @@ void updateConnection(
       conn.appLimitedTracker.getTotalAppLimitedTime(),
       packetDestroyFn);
 
-  pkt.metadata.cmsgs = conn.socketCmsgsState.additionalCmsgs;
+  if (conn.socketCmsgsState.additionalCmsgs) {
+    pkt.metadata.cold.getOrCreate().cmsgs =
+        conn.socketCmsgsState.additionalCmsgs;
+  }
 
   pkt.isAppLimited = conn.congestionController
       ? conn.congestionController->isAppLimited()
@@ -896,9 +890,12 @@ void updateConnection(
         *conn.lossState.adjustedLastAckedTime,
         conn.lossState.totalBytesSentAtLastAck,
         conn.lossState.totalBytesAckedAtLastAck);
+    pkt.lastAckedPacketInfo->peerReceiveTime =
+        conn.lossState.lastAckedPacketPeerReceiveTime;
   }
   if (packetEvent) {
-    //DCHECK(conn.outstandings.packetEvents.count(*packetEvent));
+    //DCHECK(conn.outstandings.cloneGroups.isPending(*packetEvent));
+    conn.outstandings.cloneGroups.addRef(*packetEvent);
     pkt.associatedEvent = std::move(packetEvent);
     conn.lossState.totalBytesCloned += encodedSize;
   }
@@ -913,7 +910,7 @@ void updateConnection(
   }
 
   if (conn.congestionController) {
-    conn.congestionController->onPacketSent(pkt);
+    congestionControllerOnPacketSent(conn, pkt);
   }
   if (conn.pacer) {
     conn.pacer->onPacketSent();
@@ -963,7 +960,7 @@ uint64_t congestionControlWritableBytes(QuicConnectionStateBase& conn) {
 
   if (conn.congestionController) {
     writableBytes = std::min<uint64_t>(
-        writableBytes, conn.congestionController->getWritableBytes());
+        writableBytes, congestionControllerWritableBytes(conn));
   }
 
   if (writableBytes == std::numeric_limits<uint64_t>::max()) {
@@ -1615,6 +1612,7 @@ WriteDataReason shouldWriteData(/*const*/ QuicConnectionStateBase& conn) {
 
   if (!congestionControlWritableBytes(conn)) {
     QUIC_STATS(conn.statsCallback, onCwndBlocked);
+    conn.bandwidthEstimateState.cwndLimited = true;
     return WriteDataReason::NO_WRITE;
   }
   return hasNonAckDataToWrite(conn);
@@ -1706,25 +1704,20 @@ void implicitAckCryptoStream(
       ? PacketNumberSpace::Handshake
       : PacketNumberSpace::Initial;
   auto& ackState = getAckState(conn, packetNumSpace);
-  AckBlocks ackBlocks;
+  const auto& outstandingPackets = conn.outstandings.packets[packetNumSpace];
+  if (outstandingPackets.empty()) {
+    return;
+  }
   ReadAckFrame implicitAck;
   implicitAck.ackDelay = 0ms;
   implicitAck.implicit = true;
-  for (const auto& op : conn.outstandings.packets) {
-    if (op.packet.header.getPacketNumberSpace() == packetNumSpace) {
-      ackBlocks.insert(op.packet.header.getPacketSequenceNum());
-    }
-  }
-  if (ackBlocks.empty()) {
-    return;
-  }
   // Construct an implicit ack covering the entire range of packets.
   // If some of these have already been ACK'd then processAckFrame
   // should simply ignore them.
-  implicitAck.largestAcked = ackBlocks.back().end;
+  implicitAck.largestAcked = outstandingPackets.lastPacketNum();
   implicitAck.ackBlocks.emplace_back(
-      ackBlocks.front().start, implicitAck.largestAcked);
-  processAckFrame(
+      outstandingPackets.firstPacketNum(), implicitAck.largestAcked);
+  auto ackEvent = processAckFrame(
       conn,
       packetNumSpace,
       implicitAck,
@@ -1754,6 +1747,8 @@ void implicitAckCryptoStream(
         //LOG(FATAL) << "Got loss from implicit crypto ACK.";
       },
       implicitAckTime);
+  // Nobody consumes implicit AckEvents, so its storage can be reused right away.
+  recycleAckEvent(conn, ackEvent);
   // Clear our the loss buffer explicity. The implicit ACK itself will not
   // remove data already in the loss buffer.
   auto cryptoStream = getCryptoStream(*conn.cryptoState, encryptionLevel);
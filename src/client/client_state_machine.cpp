@@ -76,14 +76,7 @@ std::unique_ptr<QuicClientConnectionState> undoAllClientStateForRetry(
   }
 
   // only copy over zero-rtt data
-  for (auto& outstandingPacket : conn->outstandings.packets) {
-    auto& packetHeader = outstandingPacket.packet.header;
-    if (packetHeader.getPacketNumberSpace() == PacketNumberSpace::AppData &&
-        packetHeader.getProtectionType() == ProtectionType::ZeroRtt) {
-      newConn->outstandings.packets.push_back(std::move(outstandingPacket));
-      newConn->outstandings.packetCount[PacketNumberSpace::AppData]++;
-    }
-  }
+  conn->outstandings.moveZeroRttPacketsTo(newConn->outstandings);
 
   newConn->lossState = conn->lossState;
   newConn->nodeType = conn->nodeType;
@@ -1743,6 +1743,8 @@ void QuicClientTransport::onNetworkSwitch(
     sock->close();
 
     socket_ = std::move(newSock);
+    // The new socket doesn't mark packets yet.
+    socketEcnCodepoint_ = kEcnNotECT;
     if (socket_) {
       socket_->setAdditionalCmsgsFunc(
           [&]() { return getAdditionalCmsgsForAsyncUDPSocket(); });
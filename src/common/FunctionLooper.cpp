@@ -27,6 +27,10 @@ bool FunctionLooper::hasPacingTimer() const noexcept {
   return pacingTimer_ != nullptr;
 }
 
+bool FunctionLooper::isPacingTimeoutScheduled() const noexcept {
+  return isScheduled() || hasPacingDeadline();
+}
+
 void FunctionLooper::setPacingFunction(
     folly::Function<std::chrono::microseconds()>&& pacingFunc) {
   pacingFunc_ = std::move(pacingFunc);
@@ -51,17 +55,32 @@ void FunctionLooper::commonLoopBody() noexcept {
 }
 
 bool FunctionLooper::schedulePacingTimeout() noexcept {
-  if (pacingFunc_ && pacingTimer_ && !isScheduled()) {
+  if (pacingFunc_ && pacingTimer_ && !isPacingTimeoutScheduled()) {
     auto timeUntilWrite = (*pacingFunc_)();
     if (timeUntilWrite != 0us) {
       nextPacingTime_ = Clock::now() + timeUntilWrite;
-      pacingTimer_->scheduleTimeout(this, timeUntilWrite);
+      if (usePacingCalendar_) {
+        pacingCalendar().schedule(*this, nextPacingTime_);
+      } else {
+        pacingTimer_->scheduleTimeout(this, timeUntilWrite);
+      }
       return true;
     }
   }
   return false;
 }
 
+void FunctionLooper::cancelPacingTimeout() noexcept {
+  cancelTimeout();
+  if (hasPacingDeadline()) {
+    pacingCalendar().cancel(*this);
+  }
+}
+
+ShardPacingCalendar& FunctionLooper::pacingCalendar() noexcept {
+  return ShardPacingCalendar::get(pacingTimer_);
+}
+
 void FunctionLooper::runLoopCallback() noexcept {
   folly::DelayedDestruction::DestructorGuard dg(this);
   commonLoopBody();
@@ -76,20 +95,21 @@ void FunctionLooper::run(bool thisIteration) noexcept {
     //VLOG(4) << __func__ << ": " << type_ << " in loop body and using pacing - not rescheduling";
     return;
   }
-  if (isLoopCallbackScheduled() || (!fireLoopEarly_ && isScheduled())) {
+  if (isLoopCallbackScheduled() ||
+      (!fireLoopEarly_ && isPacingTimeoutScheduled())) {
     //VLOG(10) << __func__ << ": " << type_ << " already scheduled";
     return;
   }
   // If we are pacing, we're about to write again, if it's close, just write
   // now.
-  if (isScheduled()) {
+  if (isPacingTimeoutScheduled()) {
     auto n = Clock::now();
     auto timeUntilWrite = nextPacingTime_ < n
         ? 0us
         : std::chrono::duration_cast<std::chrono::milliseconds>(
               nextPacingTime_ - n);
     if (timeUntilWrite <= 1ms) {
-      cancelTimeout();
+      cancelPacingTimeout();
       // The next loop is good enough
       thisIteration = false;
     } else {
@@ -103,7 +123,7 @@ void FunctionLooper::stop() noexcept {
   //VLOG(10) << __func__ << ": " << type_;
   running_ = false;
   cancelLoopCallback();
-  cancelTimeout();
+  cancelPacingTimeout();
 }
 
 bool FunctionLooper::isRunning() const {
@@ -121,7 +141,7 @@ void FunctionLooper::detachEventBase() {
   //VLOG(10) << __func__ << ": " << type_;
   //DCHECK(evb_ && evb_->isInEventBaseThread());
   stop();
-  cancelTimeout();
+  cancelPacingTimeout();
   evb_ = nullptr;
 }
 
@@ -134,6 +154,11 @@ void FunctionLooper::callbackCanceled() noexcept {
   return;
 }
 
+void FunctionLooper::pacingDeadlineReached(TimePoint /* now */) noexcept {
+  folly::DelayedDestruction::DestructorGuard dg(this);
+  commonLoopBody();
+}
+
 folly::Optional<std::chrono::microseconds>
 FunctionLooper::getTimerTickInterval() noexcept {
   if (pacingTimer_) {
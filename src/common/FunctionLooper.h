@@ -11,6 +11,7 @@
 #include <folly/Function.h>
 #include "protocol/quic_constants.hpp"
 #include "Events.h"
+#include "ShardPacingCalendar.h"
 #include "Timers.h"
 
 namespace quic {
@@ -29,7 +30,8 @@ std::ostream& operator<<(std::ostream& /* out */, const LooperType& /*rhs*/);
  */
 class FunctionLooper : public QuicEventBase::LoopCallback,
                        public folly::DelayedDestruction,
-                       public TimerHighRes::Callback {
+                       public TimerHighRes::Callback,
+                       public ShardPacingCalendar::Entry {
  public:
   using Ptr =
       std::unique_ptr<FunctionLooper, folly::DelayedDestruction::Destructor>;
@@ -43,6 +45,20 @@ class FunctionLooper : public QuicEventBase::LoopCallback,
 
   bool hasPacingTimer() const noexcept;
 
+  /**
+   * Files pacing timeouts in the shard's ShardPacingCalendar instead of
+   * scheduling them on the pacing timer, which then drives the calendar.
+   */
+  void setUsePacingCalendar(bool usePacingCalendar) noexcept {
+    usePacingCalendar_ = usePacingCalendar;
+  }
+
+  /**
+   * Whether the next paced write is scheduled, on the pacing timer or in the
+   * calendar.
+   */
+  bool isPacingTimeoutScheduled() const noexcept;
+
   void runLoopCallback() noexcept override;
 
   /**
@@ -95,6 +111,10 @@ class FunctionLooper : public QuicEventBase::LoopCallback,
   ~FunctionLooper() override = default;
   void commonLoopBody() noexcept;
   bool schedulePacingTimeout() noexcept;
+  void cancelPacingTimeout() noexcept;
+  // The calendar pacing timeouts are filed in and cancelled from.
+  ShardPacingCalendar& pacingCalendar() noexcept;
+  void pacingDeadlineReached(TimePoint now) noexcept override;
 
   QuicEventBase* evb_;
   folly::Function<void()> func_;
@@ -105,5 +125,6 @@ class FunctionLooper : public QuicEventBase::LoopCallback,
   const LooperType type_;
   TimePoint nextPacingTime_;
   bool fireLoopEarly_{false};
+  bool usePacingCalendar_{false};
 };
 } // namespace quic
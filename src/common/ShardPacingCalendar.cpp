@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "ShardPacingCalendar.h"
+
+#include <limits>
+
+#include <folly/Chrono.h>
+#include <folly/lang/Bits.h>
+
+namespace quic {
+
+namespace {
+
+constexpr uint64_t kNoSlot = std::numeric_limits<uint64_t>::max();
+
+// Index of the first possibly occupied slot at or after from, or kSlots if
+// there is none.
+template <class Occupied>
+size_t firstOccupiedFrom(const Occupied& occupied, size_t from) {
+  for (size_t word = from / 64; word < occupied.size(); ++word) {
+    auto bits = occupied[word];
+    if (word == from / 64) {
+      bits &= ~0ull << (from % 64);
+    }
+    if (bits) {
+      return word * 64 + folly::findFirstSet(bits) - 1;
+    }
+  }
+  return ShardPacingCalendar::kSlots;
+}
+
+} // namespace
+
+ShardPacingCalendar& ShardPacingCalendar::getThreadLocalInstance() {
+  static thread_local ShardPacingCalendar sCalendar;
+  return sCalendar;
+}
+
+ShardPacingCalendar& ShardPacingCalendar::get(
+    const TimerHighRes::SharedPtr& timer) {
+  auto& calendar = getThreadLocalInstance();
+  if (calendar.timer_.expired() && timer) {
+    calendar.attachTimer(timer);
+  }
+  return calendar;
+}
+
+ShardPacingCalendar::ShardPacingCalendar()
+    : start_(Clock::now()), driver_(*this) {}
+
+ShardPacingCalendar::~ShardPacingCalendar() {
+  driver_.cancelTimeout();
+  cancelAll();
+}
+
+void ShardPacingCalendar::attachTimer(const TimerHighRes::SharedPtr& timer) {
+  if (timer_.lock() == timer) {
+    return;
+  }
+  driver_.cancelTimeout();
+  armedSlot_.reset();
+  timer_ = timer;
+  if (!timer) {
+    return;
+  }
+  const auto tickInterval = timer->getTickInterval();
+  if (nextBusySlot() == kNoSlot && tickInterval.count() > 0 &&
+      tickInterval != slotInterval_) {
+    // Nothing is filed, so slots can be renumbered.
+    slotInterval_ = tickInterval;
+    currentSlot_ = slotAtOrBefore(Clock::now());
+  }
+  rearmDriver();
+}
+
+void ShardPacingCalendar::schedule(Entry& entry, TimePoint deadline) {
+  if (entry.hook_.is_linked()) {
+    unfile(entry);
+  }
+  if (!advancing_ && !armedSlot_ && nextBusySlot() == kNoSlot) {
+    // Skip the slots that went by while the calendar was idle, so the whole
+    // ring is ahead of now.
+    currentSlot_ = std::max(currentSlot_, slotAtOrBefore(Clock::now()));
+  }
+  entry.deadline_ = deadline;
+  file(entry, slotAtOrAfter(deadline));
+  if (!advancing_ && (!armedSlot_ || entry.filedSlot_ < *armedSlot_)) {
+    rearmDriver();
+  }
+}
+
+void ShardPacingCalendar::cancel(Entry& entry) {
+  if (entry.hook_.is_linked()) {
+    unfile(entry);
+  }
+  // The driver may wake up for nothing; it is rearmed then.
+  entry.deadline_.reset();
+}
+
+size_t ShardPacingCalendar::advance(TimePoint now) {
+  const auto target = slotAtOrBefore(now);
+  size_t entriesRun = 0;
+  advancing_ = true;
+  while (currentSlot_ < target) {
+    currentSlot_ = std::min(nextBusySlot(), target);
+    const auto index = currentSlot_ % kSlots;
+    EntryList due;
+    due.splice(due.end(), slots_[index]);
+    occupied_[index / 64] &= ~(1ull << (index % 64));
+    while (!due.empty()) {
+      // Unlink before running anything: writing may reschedule this entry or
+      // destroy other entries still in the list.
+      auto& entry = due.front();
+      due.pop_front();
+      const auto slot = slotAtOrAfter(*entry.deadline_);
+      if (slot > currentSlot_) {
+        // Was filed in the last slot of the ring.
+        file(entry, slot);
+        continue;
+      }
+      entry.deadline_.reset();
+      entry.pacingDeadlineReached(now);
+      ++entriesRun;
+    }
+  }
+  advancing_ = false;
+  rearmDriver();
+  return entriesRun;
+}
+
+folly::Optional<TimePoint> ShardPacingCalendar::nextWakeup() const {
+  const auto slot = nextBusySlot();
+  if (slot == kNoSlot) {
+    return folly::none;
+  }
+  return timeOfSlot(slot);
+}
+
+void ShardPacingCalendar::cancelAll() {
+  EntryList entries;
+  for (auto& slot : slots_) {
+    entries.splice(entries.end(), slot);
+  }
+  occupied_.fill(0);
+  while (!entries.empty()) {
+    auto& entry = entries.front();
+    entries.pop_front();
+    entry.deadline_.reset();
+    entry.calendarCanceled();
+  }
+}
+
+uint64_t ShardPacingCalendar::slotAtOrAfter(TimePoint time) const {
+  if (time <= start_) {
+    return 0;
+  }
+  const auto elapsed =
+      folly::chrono::ceil<std::chrono::microseconds>(time - start_).count();
+  return (elapsed + slotInterval_.count() - 1) / slotInterval_.count();
+}
+
+uint64_t ShardPacingCalendar::slotAtOrBefore(TimePoint time) const {
+  if (time <= start_) {
+    return 0;
+  }
+  return std::chrono::floor<std::chrono::microseconds>(time - start_).count() /
+      slotInterval_.count();
+}
+
+TimePoint ShardPacingCalendar::timeOfSlot(uint64_t slot) const {
+  return start_ + slot * slotInterval_;
+}
+
+void ShardPacingCalendar::file(Entry& entry, uint64_t slot) {
+  // Overdue entries run in the next slot.
+  slot = std::max(slot, currentSlot_ + 1);
+  slot = std::min(slot, currentSlot_ + kSlots - 1);
+  const auto index = slot % kSlots;
+  slots_[index].push_back(entry);
+  occupied_[index / 64] |= 1ull << (index % 64);
+  entry.filedSlot_ = slot;
+}
+
+void ShardPacingCalendar::unfile(Entry& entry) {
+  const auto index = entry.filedSlot_ % kSlots;
+  entry.hook_.unlink();
+  if (slots_[index].empty()) {
+    occupied_[index / 64] &= ~(1ull << (index % 64));
+  }
+}
+
+uint64_t ShardPacingCalendar::nextBusySlot() const {
+  // Slots after currentSlot_ in the ring come before those up to it.
+  const auto from = (currentSlot_ + 1) % kSlots;
+  auto index = firstOccupiedFrom(occupied_, from);
+  if (index < kSlots) {
+    return currentSlot_ + 1 + (index - from);
+  }
+  if (from > 0 && (index = firstOccupiedFrom(occupied_, 0)) < from) {
+    return currentSlot_ + 1 + (kSlots - from) + index;
+  }
+  return kNoSlot;
+}
+
+void ShardPacingCalendar::rearmDriver() {
+  auto timer = timer_.lock();
+  if (!timer) {
+    return;
+  }
+  const auto slot = nextBusySlot();
+  if (slot == kNoSlot) {
+    driver_.cancelTimeout();
+    armedSlot_.reset();
+    return;
+  }
+  if (armedSlot_ == slot) {
+    return;
+  }
+  auto timeout = folly::chrono::ceil<std::chrono::microseconds>(
+      timeOfSlot(slot) - Clock::now());
+  driver_.cancelTimeout();
+  timer->scheduleTimeout(
+      &driver_, std::max(timeout, std::chrono::microseconds(0)));
+  armedSlot_ = slot;
+}
+
+void ShardPacingCalendar::Driver::timeoutExpired() noexcept {
+  calendar_.armedSlot_.reset();
+  calendar_.advance(Clock::now());
+}
+
+void ShardPacingCalendar::Driver::callbackCanceled() noexcept {
+  // The timer is going away; the connections it paced are too.
+  calendar_.armedSlot_.reset();
+  calendar_.timer_.reset();
+  calendar_.cancelAll();
+}
+
+} // namespace quic
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include <boost/intrusive/list.hpp>
+#include <folly/Optional.h>
+#include "Timers.h"
+#include "protocol/quic_constants.hpp"
+
+namespace quic {
+
+/**
+ * Calendar of the paced connections on a shard due to write, shared instead
+ * of each connection's write looper scheduling its own pacing timeout.
+ *
+ * The calendar is a ring of kSlots slots, one tick of the pacing timer wide.
+ * A connection files an Entry in the slot of its next write time and the
+ * calendar keeps a single callback on the pacing timer armed for the earliest
+ * occupied slot. When it fires, every entry due in the slots up to now runs in
+ * the order it was filed, in one wakeup, so the timer is only touched when
+ * the earliest slot changes rather than for every burst of every connection.
+ *
+ * Write times past the span of the ring are filed in its last slot and filed
+ * again once that slot comes up. Rescheduling and cancelling unlink the entry
+ * right away; paced connections move their write time on every burst, in
+ * either direction.
+ *
+ * advance() and nextWakeup() are all a reactor needs to drive the calendar
+ * itself; by default it is driven from the first pacing timer it is given.
+ */
+class ShardPacingCalendar {
+ public:
+  // With the default 100us pacing timer resolution the ring spans about 400ms,
+  // longer than the write interval of any but the slowest paced connections.
+  static constexpr size_t kSlots = 4096;
+
+  class Entry {
+   public:
+    virtual ~Entry() = default;
+
+    // Whether a write time is pending, i.e. pacingDeadlineReached() is due.
+    [[nodiscard]] bool hasPacingDeadline() const {
+      return deadline_.has_value();
+    }
+
+    [[nodiscard]] folly::Optional<TimePoint> pacingDeadline() const {
+      return deadline_;
+    }
+
+   protected:
+    // Invoked once the write time is reached, with the entry no longer
+    // scheduled.
+    virtual void pacingDeadlineReached(TimePoint now) noexcept = 0;
+
+    // Invoked on scheduled entries if the pacing timer goes away first.
+    virtual void calendarCanceled() noexcept {}
+
+   private:
+    friend class ShardPacingCalendar;
+
+    using Hook = boost::intrusive::list_member_hook<
+        boost::intrusive::link_mode<boost::intrusive::auto_unlink>>;
+
+    Hook hook_;
+    folly::Optional<TimePoint> deadline_;
+    // Slot the entry is linked in, if hook_ is linked.
+    uint64_t filedSlot_{0};
+  };
+
+  static ShardPacingCalendar& getThreadLocalInstance();
+
+  /**
+   * The thread local calendar, woken by timer unless it already has a timer.
+   * The calendar doesn't keep timer alive.
+   */
+  static ShardPacingCalendar& get(const TimerHighRes::SharedPtr& timer);
+
+  ShardPacingCalendar();
+  ~ShardPacingCalendar();
+
+  ShardPacingCalendar(const ShardPacingCalendar&) = delete;
+  ShardPacingCalendar& operator=(const ShardPacingCalendar&) = delete;
+
+  // Slots become one tick of timer wide if nothing is filed yet.
+  void attachTimer(const TimerHighRes::SharedPtr& timer);
+
+  // Sets or moves the write time of entry.
+  void schedule(Entry& entry, TimePoint deadline);
+
+  void cancel(Entry& entry);
+
+  /**
+   * Runs the entries whose slot is at or before now. Returns the number of
+   * entries run.
+   */
+  size_t advance(TimePoint now);
+
+  /**
+   * Start of the earliest slot with entries, or none if there are none.
+   */
+  [[nodiscard]] folly::Optional<TimePoint> nextWakeup() const;
+
+  [[nodiscard]] std::chrono::microseconds slotInterval() const {
+    return slotInterval_;
+  }
+
+  // Drops every entry, invoking calendarCanceled() on them.
+  void cancelAll();
+
+ private:
+  using EntryList = boost::intrusive::list<
+      Entry,
+      boost::intrusive::member_hook<Entry, Entry::Hook, &Entry::hook_>,
+      boost::intrusive::constant_time_size<false>>;
+
+  class Driver : public TimerHighRes::Callback {
+   public:
+    explicit Driver(ShardPacingCalendar& calendar) : calendar_(calendar) {}
+
+    void timeoutExpired() noexcept override;
+    void callbackCanceled() noexcept override;
+
+   private:
+    ShardPacingCalendar& calendar_;
+  };
+
+  [[nodiscard]] uint64_t slotAtOrAfter(TimePoint time) const;
+  [[nodiscard]] uint64_t slotAtOrBefore(TimePoint time) const;
+  [[nodiscard]] TimePoint timeOfSlot(uint64_t slot) const;
+
+  void file(Entry& entry, uint64_t slot);
+  void unfile(Entry& entry);
+  // Next slot after currentSlot_ which may have entries.
+  [[nodiscard]] uint64_t nextBusySlot() const;
+  void rearmDriver();
+
+  // Slots are numbered from start_ and slot n is slots_[n % kSlots]. Entries
+  // unlink themselves on destruction, so a set occupied bit can be stale.
+  std::array<EntryList, kSlots> slots_;
+  std::array<uint64_t, kSlots / 64> occupied_{};
+  const TimePoint start_;
+  std::chrono::microseconds slotInterval_{kDefaultPacingTimerResolution};
+  // Slots up to this one have been run.
+  uint64_t currentSlot_{0};
+  std::weak_ptr<TimerHighRes> timer_;
+  Driver driver_;
+  // Slot the driver is armed for, if it is.
+  folly::Optional<uint64_t> armedSlot_;
+  bool advancing_{false};
+};
+
+} // namespace quic
@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "ShardTimerWheel.h"
+
+#include <folly/Chrono.h>
+#include <folly/io/async/EventBaseLocal.h>
+#include <folly/lang/Bits.h>
+
+namespace quic {
+
+namespace {
+
+constexpr uint64_t kNoTick = std::numeric_limits<uint64_t>::max();
+constexpr uint64_t kSlotMask = ShardTimerWheel::kSlotsPerLevel - 1;
+constexpr uint64_t kWheelSpan = 1ull
+    << (ShardTimerWheel::kLevelBits * ShardTimerWheel::kLevels);
+
+// Index of the first possibly occupied slot at or after from, or
+// kSlotsPerLevel if there is none.
+template <class Occupied>
+size_t firstOccupiedFrom(const Occupied& occupied, size_t from) {
+  for (size_t word = from / 64; word < occupied.size(); ++word) {
+    auto bits = occupied[word];
+    if (word == from / 64) {
+      bits &= ~0ull << (from % 64);
+    }
+    if (bits) {
+      return word * 64 + folly::findFirstSet(bits) - 1;
+    }
+  }
+  return ShardTimerWheel::kSlotsPerLevel;
+}
+
+template <class Occupied>
+bool anyOccupied(const Occupied& occupied) {
+  for (auto bits : occupied) {
+    if (bits) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+ShardTimerWheel& ShardTimerWheel::get(folly::EventBase& evb) {
+  static folly::EventBaseLocal<ShardTimerWheel> sWheels;
+  if (auto wheel = sWheels.get(evb)) {
+    return *wheel;
+  }
+  auto& wheel = sWheels.emplace(evb);
+  wheel.attachEventBase(&evb);
+  // Entries are canceled while evb can still run their callbacks; the wheel
+  // itself goes with evb's locals after that.
+  evb.runOnDestruction([&wheel] {
+    wheel.attachEventBase(nullptr);
+    wheel.cancelAll();
+  });
+  return wheel;
+}
+
+ShardTimerWheel::ShardTimerWheel() : start_(Clock::now()), driver_(*this) {}
+
+ShardTimerWheel::~ShardTimerWheel() {
+  driver_.cancelTimeout();
+  cancelAll();
+}
+
+void ShardTimerWheel::attachEventBase(folly::EventBase* evb) {
+  if (evb_ == evb) {
+    return;
+  }
+  driver_.cancelTimeout();
+  armedTick_.reset();
+  evb_ = evb;
+  rearmDriver();
+}
+
+void ShardTimerWheel::schedule(Entry& entry, TimePoint deadline) {
+  entry.deadline_ = deadline;
+  const auto tick = tickAtOrAfter(deadline);
+  if (entry.hook_.is_linked()) {
+    if (entry.filedTick_ <= tick) {
+      // Filed early; it is filed again under the new deadline when its slot
+      // comes up.
+      return;
+    }
+    entry.hook_.unlink();
+  }
+  file(entry, tick);
+  if (!advancing_ && (!armedTick_ || entry.filedTick_ < *armedTick_)) {
+    rearmDriver();
+  }
+}
+
+void ShardTimerWheel::cancel(Entry& entry) {
+  // The entry is dropped when its slot comes up, or when it is destroyed.
+  entry.deadline_.reset();
+}
+
+void ShardTimerWheel::remove(Entry& entry) {
+  // The slot's occupied bit is left set; the driver wakes up for nothing at
+  // worst.
+  entry.hook_.unlink();
+  entry.deadline_.reset();
+}
+
+size_t ShardTimerWheel::advance(TimePoint now) {
+  const auto target = tickAtOrBefore(now);
+  size_t entriesRun = 0;
+  advancing_ = true;
+  while (currentTick_ < target) {
+    currentTick_ = std::min(nextBusyTick(), target);
+    // Cascade from the lowest level up; a level only cascades when the level
+    // below it wrapped around.
+    for (size_t level = 1; level < kLevels &&
+         ((currentTick_ >> (kLevelBits * (level - 1))) & kSlotMask) == 0;
+         ++level) {
+      cascade(level);
+    }
+
+    auto& level0 = levels_[0];
+    const auto slot = currentTick_ & kSlotMask;
+    EntryList due;
+    due.splice(due.end(), level0.slots[slot]);
+    level0.occupied[slot / 64] &= ~(1ull << (slot % 64));
+    while (!due.empty()) {
+      // Unlink before running anything: callbacks may reschedule this entry or
+      // destroy other entries still in the list.
+      auto& entry = due.front();
+      due.pop_front();
+      if (!entry.deadline_) {
+        continue;
+      }
+      const auto tick = tickAtOrAfter(*entry.deadline_);
+      if (tick > currentTick_) {
+        file(entry, tick);
+        continue;
+      }
+      entry.deadline_.reset();
+      entry.deadlineReached(now);
+      ++entriesRun;
+    }
+  }
+  advancing_ = false;
+  rearmDriver();
+  return entriesRun;
+}
+
+folly::Optional<TimePoint> ShardTimerWheel::nextWakeup() const {
+  const auto tick = nextBusyTick();
+  if (tick == kNoTick) {
+    return folly::none;
+  }
+  return timeOfTick(tick);
+}
+
+void ShardTimerWheel::cancelAll() {
+  EntryList entries;
+  for (auto& level : levels_) {
+    for (auto& slot : level.slots) {
+      entries.splice(entries.end(), slot);
+    }
+    level.occupied.fill(0);
+  }
+  while (!entries.empty()) {
+    auto& entry = entries.front();
+    entries.pop_front();
+    if (entry.deadline_) {
+      entry.deadline_.reset();
+      entry.wheelCanceled();
+    }
+  }
+}
+
+uint64_t ShardTimerWheel::tickAtOrAfter(TimePoint time) const {
+  if (time <= start_) {
+    return 0;
+  }
+  return folly::chrono::ceil<std::chrono::milliseconds>(time - start_)
+             .count() /
+      kTickInterval.count();
+}
+
+uint64_t ShardTimerWheel::tickAtOrBefore(TimePoint time) const {
+  if (time <= start_) {
+    return 0;
+  }
+  return std::chrono::floor<std::chrono::milliseconds>(time - start_).count() /
+      kTickInterval.count();
+}
+
+TimePoint ShardTimerWheel::timeOfTick(uint64_t tick) const {
+  return start_ + tick * kTickInterval;
+}
+
+void ShardTimerWheel::file(Entry& entry, uint64_t tick) {
+  // Overdue entries run on the next tick.
+  tick = std::max(tick, currentTick_ + 1);
+  tick = std::min(tick, currentTick_ + kWheelSpan - 1);
+  const auto delta = tick - currentTick_;
+  size_t level = 0;
+  while (level + 1 < kLevels && delta >= (1ull << (kLevelBits * (level + 1)))) {
+    ++level;
+  }
+  const auto slot = (tick >> (kLevelBits * level)) & kSlotMask;
+  levels_[level].slots[slot].push_back(entry);
+  levels_[level].occupied[slot / 64] |= 1ull << (slot % 64);
+  entry.filedTick_ = tick;
+}
+
+void ShardTimerWheel::cascade(size_t level) {
+  auto& wheelLevel = levels_[level];
+  const auto slot = (currentTick_ >> (kLevelBits * level)) & kSlotMask;
+  EntryList entries;
+  entries.splice(entries.end(), wheelLevel.slots[slot]);
+  wheelLevel.occupied[slot / 64] &= ~(1ull << (slot % 64));
+  while (!entries.empty()) {
+    auto& entry = entries.front();
+    entries.pop_front();
+    if (entry.deadline_) {
+      // Lands in a lower level, or in the level 0 slot of currentTick_ and
+      // runs right away.
+      const auto tick = tickAtOrAfter(*entry.deadline_);
+      if (tick <= currentTick_) {
+        auto& current = levels_[0].slots[currentTick_ & kSlotMask];
+        current.push_back(entry);
+        entry.filedTick_ = currentTick_;
+      } else {
+        file(entry, tick);
+      }
+    }
+  }
+}
+
+uint64_t ShardTimerWheel::nextBusyTick() const {
+  uint64_t tick = kNoTick;
+  const auto blockStart = currentTick_ & ~kSlotMask;
+  const auto currentSlot = currentTick_ & kSlotMask;
+  const auto& level0 = levels_[0].occupied;
+  // Level 0 slots after the current one belong to this block, those up to it
+  // to the next one.
+  auto slot = currentSlot + 1 < kSlotsPerLevel
+      ? firstOccupiedFrom(level0, currentSlot + 1)
+      : kSlotsPerLevel;
+  if (slot < kSlotsPerLevel) {
+    tick = blockStart + slot;
+  } else if ((slot = firstOccupiedFrom(level0, 0)) <= currentSlot) {
+    tick = blockStart + kSlotsPerLevel + slot;
+  }
+  for (size_t level = 1; level < kLevels; ++level) {
+    if (anyOccupied(levels_[level].occupied)) {
+      // Higher levels cascade at block boundaries.
+      tick = std::min(tick, blockStart + kSlotsPerLevel);
+      break;
+    }
+  }
+  return tick;
+}
+
+void ShardTimerWheel::rearmDriver() {
+  if (!evb_) {
+    return;
+  }
+  const auto tick = nextBusyTick();
+  if (tick == kNoTick) {
+    driver_.cancelTimeout();
+    armedTick_.reset();
+    return;
+  }
+  if (armedTick_ == tick) {
+    return;
+  }
+  auto timeout = folly::chrono::ceil<std::chrono::milliseconds>(
+      timeOfTick(tick) - Clock::now());
+  driver_.cancelTimeout();
+  evb_->timer().scheduleTimeout(
+      &driver_, std::max(timeout, std::chrono::milliseconds(0)));
+  armedTick_ = tick;
+}
+
+void ShardTimerWheel::Driver::timeoutExpired() noexcept {
+  wheel_.armedTick_.reset();
+  wheel_.advance(Clock::now());
+}
+
+void ShardTimerWheel::Driver::callbackCanceled() noexcept {
+  // The evb timer dropped its callbacks; arm again on the next schedule().
+  wheel_.armedTick_.reset();
+}
+
+} // namespace quic
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include <boost/intrusive/list.hpp>
+#include <folly/Optional.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/HHWheelTimer.h>
+#include "protocol/quic_constants.hpp"
+
+namespace quic {
+
+/**
+ * Hierarchical timing wheel shared by all the connections on a shard.
+ *
+ * Each connection files a single Entry under its earliest deadline, instead
+ * of one evb timer callback per timeout type, and the wheel itself keeps one
+ * callback on the evb timer armed for the earliest slot with entries in it.
+ *
+ * Cancellation is lazy: cancelling, or moving a deadline later, only updates
+ * the entry, which stays in the slot it was filed in. When that slot comes up
+ * the entry is dropped or filed again under its current deadline. Only moving
+ * a deadline earlier relinks the entry. Connections which keep pushing their
+ * idle, ack or loss deadlines back therefore cost no list operations.
+ *
+ * The wheel has kLevels levels of kSlotsPerLevel slots of kTickInterval ticks,
+ * which spans about 49 days; later deadlines are filed at the end of the span.
+ *
+ * advance() and nextWakeup() are all a reactor needs to drive a wheel of its
+ * own; the wheels handed out by get() are driven from their evb's timer.
+ */
+class ShardTimerWheel {
+ public:
+  static constexpr std::chrono::milliseconds kTickInterval{1};
+  static constexpr size_t kLevelBits = 8;
+  static constexpr size_t kSlotsPerLevel = 1 << kLevelBits;
+  static constexpr size_t kLevels = 4;
+
+  class Entry {
+   public:
+    virtual ~Entry() = default;
+
+    // Whether a deadline is pending, i.e. deadlineReached() is still due.
+    [[nodiscard]] bool isScheduled() const {
+      return deadline_.has_value();
+    }
+
+    [[nodiscard]] folly::Optional<TimePoint> deadline() const {
+      return deadline_;
+    }
+
+   protected:
+    // Invoked once the deadline is reached, with the entry no longer scheduled.
+    virtual void deadlineReached(TimePoint now) noexcept = 0;
+
+    // Invoked on scheduled entries if the wheel is torn down before their
+    // deadline, e.g. because the evb driving it is being destroyed.
+    virtual void wheelCanceled() noexcept {}
+
+   private:
+    friend class ShardTimerWheel;
+
+    using Hook = boost::intrusive::list_member_hook<
+        boost::intrusive::link_mode<boost::intrusive::auto_unlink>>;
+
+    Hook hook_;
+    folly::Optional<TimePoint> deadline_;
+    // Tick of the slot the entry is linked in, if hook_ is linked.
+    uint64_t filedTick_{0};
+  };
+
+  /**
+   * The wheel of evb, created on first use and driven from evb's timer. Its
+   * scheduled entries are canceled when evb is destroyed.
+   */
+  static ShardTimerWheel& get(folly::EventBase& evb);
+
+  ShardTimerWheel();
+  ~ShardTimerWheel();
+
+  ShardTimerWheel(const ShardTimerWheel&) = delete;
+  ShardTimerWheel& operator=(const ShardTimerWheel&) = delete;
+
+  void attachEventBase(folly::EventBase* evb);
+
+  // Sets or moves the deadline of entry.
+  void schedule(Entry& entry, TimePoint deadline);
+
+  void cancel(Entry& entry);
+
+  /**
+   * Cancels and unlinks entry right away, rather than when its slot comes up,
+   * e.g. before it moves to another shard's wheel.
+   */
+  void remove(Entry& entry);
+
+  /**
+   * Runs the entries whose deadline is at or before now. Returns the number of
+   * entries run.
+   */
+  size_t advance(TimePoint now);
+
+  /**
+   * Earliest time advance() may have entries to run or cascade, or none if no
+   * entry is filed.
+   */
+  [[nodiscard]] folly::Optional<TimePoint> nextWakeup() const;
+
+  // Drops every entry, invoking wheelCanceled() on those still scheduled.
+  void cancelAll();
+
+ private:
+  using EntryList = boost::intrusive::list<
+      Entry,
+      boost::intrusive::
+          member_hook<Entry, Entry::Hook, &Entry::hook_>,
+      boost::intrusive::constant_time_size<false>>;
+
+  // Slots of one level, with a bit per slot which may hold entries. Entries
+  // unlink themselves on destruction, so a set bit can be stale.
+  struct Level {
+    std::array<EntryList, kSlotsPerLevel> slots;
+    std::array<uint64_t, kSlotsPerLevel / 64> occupied{};
+  };
+
+  class Driver : public folly::HHWheelTimer::Callback {
+   public:
+    explicit Driver(ShardTimerWheel& wheel) : wheel_(wheel) {}
+
+    void timeoutExpired() noexcept override;
+    void callbackCanceled() noexcept override;
+
+   private:
+    ShardTimerWheel& wheel_;
+  };
+
+  [[nodiscard]] uint64_t tickAtOrAfter(TimePoint time) const;
+  [[nodiscard]] uint64_t tickAtOrBefore(TimePoint time) const;
+  [[nodiscard]] TimePoint timeOfTick(uint64_t tick) const;
+
+  void file(Entry& entry, uint64_t tick);
+  void cascade(size_t level);
+  // Next tick after currentTick_ at which a level 0 slot may have entries, or
+  // a higher level slot is due to cascade.
+  [[nodiscard]] uint64_t nextBusyTick() const;
+  void rearmDriver();
+
+  std::array<Level, kLevels> levels_;
+  const TimePoint start_;
+  uint64_t currentTick_{0};
+  folly::EventBase* evb_{nullptr};
+  Driver driver_;
+  // Tick the driver is armed for, if it is.
+  folly::Optional<uint64_t> armedTick_;
+  bool advancing_{false};
+};
+
+} // namespace quic
@@ -230,7 +230,8 @@ void BbrCongestionController::onPacketAcked(const AckEvent& ack, uint64_t prevIn
     }
 
     const auto& ackFrequencyConfig = conn_.transportSettings.bbrConfig.ackFrequencyConfig;
-    if (newRoundTrip && canSendAckControlFrames(conn_) && ackFrequencyConfig) {
+    if (newRoundTrip && canSendAckControlFrames(conn_) && ackFrequencyConfig &&
+        !conn_.transportSettings.ackFrequencyControllerConfig) {
         auto updatedMaxAckDelay = std::chrono::duration_cast<std::chrono::milliseconds>(clampMaxAckDelay(conn_, minRtt() / ackFrequencyConfig->minRttDivisor));
         // If we are either in STARTUP or haven't sent enough packets, based on
         // config.
@@ -579,6 +580,48 @@ void BbrCongestionController::getStats(CongestionControllerStats& stats) const {
     stats.bbrStats.state = static_cast<uint8_t>(state_);
 }
 
+folly::Optional<CongestionControllerSnapshot> BbrCongestionController::snapshot() const {
+    CongestionControllerSnapshot snapshot;
+    snapshot.type = type();
+    snapshot.cwndBytes = cwnd_;
+    snapshot.state = static_cast<uint8_t>(state_);
+    snapshot.filledPipe = btlbwFound_;
+    snapshot.bandwidth = bandwidth();
+    snapshot.minRtt = minRtt();
+    return snapshot;
+}
+
+bool BbrCongestionController::restore(const CongestionControllerSnapshot& snapshot) {
+    if (snapshot.type != type() || snapshot.cwndBytes == 0 || !bandwidthSampler_ || !minRttSampler_) {
+        return false;
+    }
+    cwnd_ = boundedCwnd(snapshot.cwndBytes, conn_.udpSendPacketLen, conn_.transportSettings.maxCwndInMss,
+        conn_.transportSettings.minCwndInMss);
+    if (snapshot.bandwidth) {
+        bandwidthSampler_->restoreBandwidth(snapshot.bandwidth, roundTripCounter_);
+    }
+    if (snapshot.minRtt > 0us) {
+        // The sampler doesn't expose when its min RTT was taken; count it as
+        // fresh.
+        minRttSampler_->newRttSample(snapshot.minRtt, snapshot.minRttTimestamp.value_or(Clock::now()));
+    }
+    btlbwFound_ = snapshot.filledPipe;
+    endOfRecovery_.reset();
+    recoveryState_ = RecoveryState::NOT_RECOVERY;
+    // Drain and ProbeRtt end on the inflight of the old connection state, so
+    // go on from where they lead to.
+    if (btlbwFound_) {
+        transitToProbeBw(Clock::now());
+    } else {
+        transitToStartup();
+    }
+    if (conn_.pacer && snapshot.bandwidth && snapshot.minRtt > 0us) {
+        pacingWindow_ = snapshot.bandwidth * pacingGain_ * snapshot.minRtt;
+        conn_.pacer->refreshPacingRate(pacingWindow_, snapshot.minRtt);
+    }
+    return true;
+}
+
 uint64_t BbrCongestionController::getCongestionWindow() const noexcept {
     if (state_ == BbrCongestionController::BbrState::ProbeRtt) {
         if (conn_.transportSettings.bbrConfig.largeProbeRttCwnd) {
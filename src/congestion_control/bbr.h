@@ -50,7 +50,7 @@ constexpr uint64_t k64K = 64 * 1024;
 
 // TODO: rate based startup mode
 // TODO: send extra bandwidth probers when pipe isn't sufficiently full
-class BbrCongestionController : public CongestionController {
+class BbrCongestionController final : public CongestionController {
 public:
     /**
      * A class to collect RTT samples, tracks the minimal one among them, and
@@ -96,6 +96,10 @@ public:
         virtual void onAppLimited() = 0;
         virtual bool isAppLimited() const = 0;
         virtual void setWindowLength(const uint64_t windowLength) noexcept = 0;
+        /**
+         * Starts over from bandwidth as the best sample, as of roundTripCounter.
+         */
+        virtual void restoreBandwidth(Bandwidth bandwidth, uint64_t roundTripCounter) noexcept = 0;
     };
 
     explicit BbrCongestionController(QuicConnectionStateBase& conn);
@@ -159,6 +163,8 @@ public:
     bool isAppLimited() const noexcept override;
 
     void getStats(CongestionControllerStats& stats) const override;
+    [[nodiscard]] folly::Optional<CongestionControllerSnapshot> snapshot() const override;
+    bool restore(const CongestionControllerSnapshot& snapshot) override;
 
     // TODO: some of these do not have to be in public API.
     bool inRecovery() const noexcept;
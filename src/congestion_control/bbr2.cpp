@@ -38,6 +38,15 @@ constexpr float kProbeRttCwndGain = 0.5;
 constexpr float kBeta = 0.7;
 
 constexpr float kLossThreshold = 0.02;
+// With L4S, bandwidth probing stops once this fraction of the round is CE
+// marked, as BBRv2 does for DCTCP style marking.
+constexpr float kEcnCeThreshold = 0.5;
+// Rounds with L4S marks bound inflight_lo to inflight_latest cut by alpha
+// times kEcnFactor, BBRv2's ecn_factor, once alpha is above
+// kEcnAlphaThreshold. BBR2 paces at the bandwidth it measured, so it has less
+// of a queue to drain than Prague's alpha/2 cut is sized for.
+constexpr double kEcnFactor = 1.0 / 3;
+constexpr double kEcnAlphaThreshold = 0.5;
 constexpr float kHeadroomFactor = 0.15;
 
 quic::Bandwidth kMinPacingRateForSendQuantum{1200 * 1000, 1s};
@@ -62,6 +71,9 @@ void Bbr2CongestionController::onRemoveBytesFromInflight(uint64_t bytesToRemove)
 }
 
 void Bbr2CongestionController::onPacketSent(const OutstandingPacketWrapper& packet) {
+    if (!congestionGroupChecked_) {
+        joinCongestionGroup();
+    }
     // Handle restart from idle
     if (conn_.lossState.inflightBytes == 0 && isAppLimited()) {
         idleRestart_ = true;
@@ -136,7 +148,7 @@ void Bbr2CongestionController::onPacketAckOrLoss(const AckEvent* FOLLY_NULLABLE
             cwndLimitedInRound_ = false;
         }
 
-        updateCongestionSignals(lossEvent);
+        updateCongestionSignals(*ackEvent, lossEvent);
         updateAckAggregation(*ackEvent);
         checkStartupDone();
         checkDrain();
@@ -155,16 +167,11 @@ void Bbr2CongestionController::onPacketAckOrLoss(const AckEvent* FOLLY_NULLABLE
         setPacing();
         setSendQuantum();
         setCwnd(ackEvent->ackedBytes, lostBytes);
-    }
-}
-
-uint64_t Bbr2CongestionController::getWritableBytes() const noexcept {
-    return getCongestionWindow() > conn_.lossState.inflightBytes
-        ? getCongestionWindow() - conn_.lossState.inflightBytes : 0;
-}
 
-uint64_t Bbr2CongestionController::getCongestionWindow() const noexcept {
-    return cwndBytes_;
+        if (congestionGroup_ && roundStart_) {
+            congestionGroup_->report(bandwidth_, minRtt_, ackEvent->ackTime);
+        }
+    }
 }
 
 CongestionControlType Bbr2CongestionController::type() const noexcept {
@@ -188,7 +195,37 @@ void Bbr2CongestionController::setAppLimited() noexcept {
     appLimitedLastSendTime_ = Clock::now();
 }
 
+void Bbr2CongestionController::onEventBaseDetached() {
+    congestionGroup_.reset();
+    congestionGroupChecked_ = false;
+}
+
 // Internals
+void Bbr2CongestionController::joinCongestionGroup() {
+    congestionGroupChecked_ = true;
+    const auto& config = conn_.transportSettings.congestionGroupConfig;
+    if (!config || !conn_.peerAddress.isFamilyInet()) {
+        return;
+    }
+    auto now = Clock::now();
+    congestionGroup_.emplace(CongestionGroupTable::getThreadLocalInstance().getGroup(conn_.peerAddress, *config, now));
+    auto estimate = congestionGroup_->warmStartEstimate(now);
+    if (!estimate || conn_.lossState.totalBytesAcked > 0) {
+        return;
+    }
+    // Start from our share of the group's bandwidth, as if measured. The min
+    // RTT is left without a timestamp so that our first sample replaces it,
+    // it only sizes the initial BDP.
+    maxBwFilter_.Update(estimate->bandwidth, cycleCount_);
+    bandwidth_ = maxBwFilter_.GetBest();
+    minRtt_ = estimate->minRtt;
+    cwndBytes_ = std::max(cwndBytes_,
+        std::min(getBDPWithGain(), conn_.udpSendPacketLen * conn_.transportSettings.maxCwndInMss));
+    if (conn_.pacer) {
+        setPacing();
+    }
+}
+
 void Bbr2CongestionController::resetCongestionSignals() {
     lossBytesInRound_ = 0;
     lossEventsInRound_ = 0;
@@ -305,7 +342,7 @@ void Bbr2CongestionController::updateLatestDeliverySignals(const AckEvent& ackEv
     }
 }
 
-void Bbr2CongestionController::updateCongestionSignals(const LossEvent* FOLLY_NULLABLE lossEvent) {
+void Bbr2CongestionController::updateCongestionSignals(const AckEvent& ackEvent, const LossEvent* FOLLY_NULLABLE lossEvent) {
     // Update max bandwidth
     if (bandwidthLatest_ > maxBwFilter_.GetBest() || !bandwidthLatest_.isAppLimited) {
         //VLOG(6) << fmt::format("Updating bandwidth filter with sample: {}", bandwidthLatest_.normalizedDescribe());
@@ -318,9 +355,28 @@ void Bbr2CongestionController::updateCongestionSignals(const LossEvent* FOLLY_NU
         lossEventsInRound_ += 1;
     }
 
+    // Update CE signal. Classic ECN marks count as losses (RFC 9002 section
+    // 7.1), L4S ones bound inflight in proportion to their fraction below.
+    const auto& ecnState = conn_.ecnState;
+    if (ackEvent.ecnCEMarkedPackets > 0 && !ecnState.isL4s()) {
+        lossBytesInRound_ += ackEvent.ecnCEMarkedPackets * conn_.udpSendPacketLen;
+        lossEventsInRound_ += 1;
+    }
+    ecnAckedInRound_ += ackEvent.ackedPackets.size();
+    ecnCeMarkedInRound_ += ackEvent.ecnCEMarkedPackets;
+
     if (!lossRoundStart_) {
         return; // we're still within the same round
     }
+    auto ecnCeMarkedInRound = ecnCeMarkedInRound_;
+    ecnAckedInRound_ = 0;
+    ecnCeMarkedInRound_ = 0;
+    if (ecnCeMarkedInRound > 0 && ecnState.isL4s() && ecnState.l4sAlpha > kEcnAlphaThreshold) {
+        // BBRv2's ECN lower bound of inflight. Also while probing up, the
+        // marks mean the probe already reached the queue.
+        inflightLo_ = std::min(inflightLo_,
+            static_cast<uint64_t>(static_cast<double>(inflightLatest_) * (1 - ecnState.l4sAlpha * kEcnFactor)));
+    }
     // AdaptLowerBoundsFromCongestion - once per round-trip
     if (state_ == State::ProbeBw_Up) {
         return;
@@ -535,7 +591,17 @@ bool Bbr2CongestionController::checkInflightTooHigh(uint64_t inflightBytesAtLarg
 }
 
 bool Bbr2CongestionController::isInflightTooHigh(uint64_t inflightBytesAtLargestAckedPacket, uint64_t lostBytes) {
-    return static_cast<float>(lostBytes) > static_cast<float>(inflightBytesAtLargestAckedPacket) * kLossThreshold;
+    if (isEcnTooHigh()) {
+        return true;
+    }
+    // Loss over the round, as one ACK rarely declares 2% of inflight lost.
+    return static_cast<float>(std::max(lostBytes, lossBytesInRound_)) >
+        static_cast<float>(inflightBytesAtLargestAckedPacket) * kLossThreshold;
+}
+
+bool Bbr2CongestionController::isEcnTooHigh() const {
+    return conn_.ecnState.isL4s() && ecnAckedInRound_ > 0 &&
+        static_cast<float>(ecnCeMarkedInRound_) > static_cast<float>(ecnAckedInRound_) * kEcnCeThreshold;
 }
 
 void Bbr2CongestionController::handleInFlightTooHigh(uint64_t inflightBytesAtLargestAckedPacket) {
@@ -543,9 +609,14 @@ void Bbr2CongestionController::handleInFlightTooHigh(uint64_t inflightBytesAtLar
     // TODO: Should this be the app limited state of the largest acknowledged
     // packet?
     if (!isAppLimited()) {
+        // L4S marks start at a queue of about a millisecond, when the pipe is
+        // just full, so they don't take inflight_hi below the BDP. A probe
+        // gets them before inflight reaches the BDP, as the queue grows with
+        // the rate.
+        auto beta = isEcnTooHigh() ? 1.0f : kBeta;
         inflightHi_ = std::max(
         inflightBytesAtLargestAckedPacket,
-        static_cast<uint64_t>(static_cast<float>(getTargetInflightWithGain()) * kBeta));
+        static_cast<uint64_t>(static_cast<float>(getTargetInflightWithGain()) * beta));
     }
     if (state_ == State::ProbeBw_Up) {
         startProbeBwDown();
@@ -782,6 +853,13 @@ Bandwidth Bbr2CongestionController::getBandwidthSampleFromAck(const AckEvent& ac
 
     auto lastAckTime = lastAckedPacket ? lastAckedPacket->adjustedAckTime : conn_.connectionTime;
     auto ackElapsed = ackTime - lastAckTime;
+    // With ACK receive timestamps from the peer, measure the delivery interval
+    // where the data was delivered, without the noise of ACK delay and ACK
+    // aggregation.
+    if (lastAckedPacket && lastAckedPacket->peerReceiveTime && pkt->receiveRelativeTimeStampUsec &&
+        *pkt->receiveRelativeTimeStampUsec > *lastAckedPacket->peerReceiveTime) {
+        ackElapsed = *pkt->receiveRelativeTimeStampUsec - *lastAckedPacket->peerReceiveTime;
+    }
     auto interval = std::max(ackElapsed, sendElapsed);
     if (interval == 0us) {
         return Bandwidth();
@@ -808,6 +886,60 @@ void Bbr2CongestionController::getStats(CongestionControllerStats& stats) const
     stats.bbr2Stats.state = uint8_t(state_);
 }
 
+folly::Optional<CongestionControllerSnapshot> Bbr2CongestionController::snapshot() const {
+    CongestionControllerSnapshot snapshot;
+    snapshot.type = type();
+    snapshot.cwndBytes = cwndBytes_;
+    snapshot.state = uint8_t(state_);
+    snapshot.filledPipe = filledPipe_;
+    snapshot.bandwidth = maxBwFilter_.GetBest();
+    snapshot.minRtt = minRtt_;
+    snapshot.minRttTimestamp = minRttTimestamp_;
+    snapshot.bandwidthHi = bandwidthHi_;
+    snapshot.bandwidthLo = bandwidthLo_;
+    snapshot.inflightHi = inflightHi_;
+    snapshot.inflightLo = inflightLo_;
+    return snapshot;
+}
+
+bool Bbr2CongestionController::restore(const CongestionControllerSnapshot& snapshot) {
+    if (snapshot.type != type() || snapshot.cwndBytes == 0) {
+        return false;
+    }
+    // Join first, so the group's warm start doesn't replace what's restored.
+    if (!congestionGroupChecked_) {
+        joinCongestionGroup();
+    }
+    cwndBytes_ = boundedCwnd(snapshot.cwndBytes, conn_.udpSendPacketLen, conn_.transportSettings.maxCwndInMss,
+        kMinCwndInMssForBbr);
+    maxBwFilter_.Reset(snapshot.bandwidth, cycleCount_);
+    if (snapshot.minRtt > 0us) {
+        minRtt_ = snapshot.minRtt;
+        minRttTimestamp_ = snapshot.minRttTimestamp;
+        probeRttMinValue_ = snapshot.minRtt;
+        probeRttMinTimestamp_ = snapshot.minRttTimestamp;
+    }
+    bandwidthHi_ = snapshot.bandwidthHi;
+    bandwidthLo_ = snapshot.bandwidthLo;
+    inflightHi_ = snapshot.inflightHi;
+    inflightLo_ = snapshot.inflightLo;
+    filledPipe_ = snapshot.filledPipe;
+    inPacketConservation_ = false;
+    // Drain and ProbeRTT end on the inflight of the old connection state, so
+    // go on from where they lead to.
+    if (filledPipe_) {
+        enterProbeBW();
+    } else {
+        enterStartup();
+    }
+    boundBwForModel();
+    setSendQuantum();
+    if (conn_.pacer && bandwidth_) {
+        setPacing();
+    }
+    return true;
+}
+
 std::string bbr2StateToString(Bbr2CongestionController::State state) {
     switch (state) {
         case Bbr2CongestionController::State::Startup:
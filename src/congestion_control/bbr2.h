@@ -9,6 +9,7 @@
 
 #include "bandwidth.h"
 #include "congestion_controller.h"
+#include "congestion_group.h"
 #include "windowed_filter.h"
 #include "state/state_data.h"
 #include "state/transport_setting.h"
@@ -16,11 +17,12 @@
 #include <sys/types.h>
 #include <chrono>
 #include <cstdint>
+#include <limits>
 #include <optional>
 #include <ratio>
 
 namespace quic {
-class Bbr2CongestionController : public CongestionController {
+class Bbr2CongestionController final : public CongestionController {
 public:
     enum class State : uint8_t {
         Startup = 0,
@@ -39,9 +41,15 @@ public:
 
     void onPacketAckOrLoss(const AckEvent* FOLLY_NULLABLE ackEvent, const LossEvent* FOLLY_NULLABLE lossEvent) override;
 
-    FOLLY_NODISCARD uint64_t getWritableBytes() const noexcept override;
+    // Defined here so that devirtualized calls inline, see
+    // CongestionControllerPtr::visit().
+    FOLLY_NODISCARD uint64_t getWritableBytes() const noexcept override {
+        return cwndBytes_ > conn_.lossState.inflightBytes ? cwndBytes_ - conn_.lossState.inflightBytes : 0;
+    }
 
-    FOLLY_NODISCARD uint64_t getCongestionWindow() const noexcept override;
+    FOLLY_NODISCARD uint64_t getCongestionWindow() const noexcept override {
+        return cwndBytes_;
+    }
 
     FOLLY_NODISCARD CongestionControlType type() const noexcept override;
 
@@ -51,10 +59,16 @@ public:
 
     FOLLY_NODISCARD folly::Optional<Bandwidth> getBandwidth() const override;
 
+    void onEventBaseDetached() override;
+
     void setAppLimited() noexcept override;
 
     void getStats(CongestionControllerStats& /*stats*/) const override;
 
+    FOLLY_NODISCARD folly::Optional<CongestionControllerSnapshot> snapshot() const override;
+
+    bool restore(const CongestionControllerSnapshot& snapshot) override;
+
     void setAppIdle(bool, TimePoint) noexcept override {}
 
     void setBandwidthUtilizationFactor(float) noexcept override {}
@@ -65,7 +79,7 @@ private:
     void resetCongestionSignals();
     void resetLowerBounds();
     void updateLatestDeliverySignals(const AckEvent& ackEvent);
-    void updateCongestionSignals(const LossEvent* FOLLY_NULLABLE lossEvent);
+    void updateCongestionSignals(const AckEvent& ackEvent, const LossEvent* FOLLY_NULLABLE lossEvent);
     void updateAckAggregation(const AckEvent& ackEvent);
     void advanceLatestDeliverySignals(const AckEvent& ackEvent);
     void boundBwForModel();
@@ -108,6 +122,7 @@ private:
     bool hasElapsedInPhase(std::chrono::microseconds interval);
     bool checkInflightTooHigh(uint64_t inflightBytesAtLargestAckedPacket, uint64_t lostBytes);
     bool isInflightTooHigh(uint64_t inflightBytesAtLargestAckedPacket, uint64_t lostBytes);
+    bool isEcnTooHigh() const;
     void handleInFlightTooHigh(uint64_t inflightBytesAtLargestAckedPacket);
     void raiseInflightHiSlope();
     void probeInflightHiUpward(uint64_t ackedBytes);
@@ -117,6 +132,8 @@ private:
     [[nodiscard]] uint64_t getBDPWithGain(float gain = 1.0) const;
     [[nodiscard]] uint64_t addQuantizationBudget(uint64_t input) const;
 
+    void joinCongestionGroup();
+
     bool isProbeBwState(const Bbr2CongestionController::State state);
     Bandwidth getBandwidthSampleFromAck(const AckEvent& ackEvent);
     bool isRenoCoexistenceProbeTime();
@@ -128,7 +145,7 @@ private:
 
     // Data Rate Model Parameters
     WindowedFilter<Bandwidth, MaxFilter<Bandwidth>, uint64_t, uint64_t> maxBwFilter_;
-    Bandwidth bandwidthHi_, bandwidthLo_, bandwidth_;
+    Bandwidth bandwidthHi_{std::numeric_limits<uint64_t>::max(), 1us}, bandwidthLo_, bandwidth_;
     uint64_t cycleCount_{0}; // TODO: this can be one bit
 
     // Data Volume Model Parameters
@@ -141,9 +158,11 @@ private:
 
     bool probeRttExpired_{false};
 
-    uint64_t sendQuantum_, inflightMax_, inflightHi_, inflightLo_;
+    uint64_t sendQuantum_{0}, inflightMax_{0}, inflightLo_;
+    // Unbounded until a bandwidth probe sees too much loss.
+    uint64_t inflightHi_{std::numeric_limits<uint64_t>::max()};
     folly::Optional<TimePoint> extraAckedStartTimestamp_;
-    uint64_t extraAckedDelivered_;
+    uint64_t extraAckedDelivered_{0};
     WindowedFilter<uint64_t, MaxFilter<uint64_t>, uint64_t, uint64_t> maxExtraAckedFilter_;
 
     // Responding to congestion
@@ -155,6 +174,9 @@ private:
     uint64_t lossRoundEndBytesSent_{0};
     float lossPctInLastRound_{0.0f};
     uint64_t lossEventsInLastRound_{0};
+    // Packets acked and CE marked in the current loss round, for L4S.
+    uint64_t ecnAckedInRound_{0};
+    uint64_t ecnCeMarkedInRound_{0};
     bool inLossRecovery_{false};
 
     // Cwnd
@@ -180,11 +202,18 @@ private:
 
     uint64_t probeUpCount_{0};
     TimePoint probeBWCycleStart_;
-    uint64_t roundsSinceBwProbe_;
-    std::chrono::milliseconds bwProbeWait_;
-    uint64_t bwProbeSamples_;
+    uint64_t roundsSinceBwProbe_{0};
+    std::chrono::milliseconds bwProbeWait_{0};
+    uint64_t bwProbeSamples_{0};
     uint64_t probeUpRounds_{0};
     uint64_t probeUpAcks_{0};
+
+    // Shared estimates of the connections to the same peer prefix, joined on
+    // the first send once the peer address is known. The group belongs to the
+    // evb thread's table, so it is left on detach and joined again on the new
+    // thread.
+    bool congestionGroupChecked_{false};
+    folly::Optional<CongestionGroupMembership> congestionGroup_;
 };
 
 std::string bbr2StateToString(Bbr2CongestionController::State state);
@@ -25,6 +25,11 @@ void BbrBandwidthSampler::setWindowLength(const uint64_t windowLength) noexcept
     windowedFilter_.SetWindowLength(windowLength);
 }
 
+void BbrBandwidthSampler::restoreBandwidth(Bandwidth bandwidth, uint64_t rttCounter) noexcept {
+    windowedFilter_.Reset(bandwidth, rttCounter);
+    latestSample_ = bandwidth;
+}
+
 void BbrBandwidthSampler::onPacketAcked(const CongestionController::AckEvent& ackEvent, uint64_t rttCounter) {
     if (appLimited_) {
         if (appLimitedExitTarget_ < ackEvent.largestNewlyAckedPacketSentTime) {
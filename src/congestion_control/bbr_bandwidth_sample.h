@@ -38,6 +38,9 @@ class BbrBandwidthSampler : public BbrCongestionController::BandwidthSampler {
 
   void setWindowLength(const uint64_t windowLength) noexcept override;
 
+  void restoreBandwidth(Bandwidth bandwidth, uint64_t rttCounter) noexcept
+      override;
+
  private:
   QuicConnectionStateBase& conn_;
   WindowedFilter<Bandwidth, MaxFilter<Bandwidth>, uint64_t, uint64_t>
@@ -11,8 +11,10 @@
 #include "bbr2.h"
 #include "bbr_bandwidth_sample.h"
 #include "bbr_rtt_sample.h"
+#include "congestion_hint_cache.h"
 #include "copa.h"
 #include "copa2.h"
+#include "media_congestion_controller.h"
 #include "new_reno.h"
 
 #include "static_cwnd_congestion_controller.h"
@@ -24,6 +26,8 @@ namespace quic {
 std::unique_ptr<CongestionController>
 DefaultCongestionControllerFactory::makeCongestionController(QuicConnectionStateBase& conn, CongestionControlType type) {
     std::unique_ptr<CongestionController> congestionController;
+    auto hint = lookupCongestionHint(conn);
+    bool hintApplied = hint && applyCongestionHint(conn, *hint);
     auto setupBBR = [&conn](BbrCongestionController* bbr) {
         bbr->setRttSampler(std::make_unique<BbrRttSampler>(
             std::chrono::seconds(kDefaultRttSamplerExpiration)));
@@ -56,6 +60,9 @@ DefaultCongestionControllerFactory::makeCongestionController(QuicConnectionState
             congestionController = std::move(bbr2);
             break;
         }
+        case CongestionControlType::Media:
+            congestionController = std::make_unique<MediaCongestionController>(conn);
+            break;
         case CongestionControlType::StaticCwnd: {
             throw QuicInternalException("StaticCwnd Congestion Controller cannot be constructed via CongestionControllerFactory.", LocalErrorCode::INTERNAL_ERROR);
         }
@@ -64,6 +71,10 @@ DefaultCongestionControllerFactory::makeCongestionController(QuicConnectionState
         case CongestionControlType::MAX:
             throw QuicInternalException("MAX is not a valid cc algorithm.", LocalErrorCode::INTERNAL_ERROR);
     }
+    if (hintApplied && congestionController && conn.pacer) {
+        // Pace the first flight at the hinted rate rather than bursting it.
+        conn.pacer->refreshPacingRate(congestionController->getCongestionWindow(), conn.transportSettings.initialRtt);
+    }
     QUIC_STATS(conn.statsCallback, onNewCongestionController, type);
     return congestionController;
 }
@@ -17,8 +17,20 @@ uint64_t boundedCwnd(uint64_t cwndBytes, uint64_t packetLength, uint64_t maxCwnd
     return std::max(std::min(cwndBytes, maxCwndInMss * packetLength), minCwndInMss * packetLength);
 }
 
+std::chrono::microseconds pacingTickInterval(const QuicConnectionStateBase& conn) {
+    if (conn.ecnState.isL4s()) {
+        return std::min(conn.transportSettings.pacingTickInterval, conn.transportSettings.pacingTimerResolution);
+    }
+    return conn.transportSettings.pacingTickInterval;
+}
+
+uint64_t minPacingBurstPackets(const QuicConnectionStateBase& conn) {
+    return conn.ecnState.isL4s() ? 1 : conn.transportSettings.minBurstPackets;
+}
+
 PacingRate calculatePacingRate(const QuicConnectionStateBase& conn, uint64_t cwnd, uint64_t minCwndInMss, std::chrono::microseconds rtt) {
-    if (conn.transportSettings.pacingTickInterval > rtt) {
+    const auto tickInterval = pacingTickInterval(conn);
+    if (tickInterval > rtt) {
         // We cannot really pace in this case.
         return PacingRate::Builder()
             .setInterval(0us)
@@ -28,10 +40,10 @@ PacingRate calculatePacingRate(const QuicConnectionStateBase& conn, uint64_t cwn
     uint64_t cwndInPackets = std::max(minCwndInMss, cwnd / conn.udpSendPacketLen);
     // Each interval we want to send cwndInpackets / (rtt / minimalInverval)
     // number of packets.
-    uint64_t burstPerInterval = std::max(conn.transportSettings.minBurstPackets,
+    uint64_t burstPerInterval = std::max(minPacingBurstPackets(conn),
         static_cast<uint64_t>(std::ceil(static_cast<double>(cwndInPackets) *
-            static_cast<double>(conn.transportSettings.pacingTickInterval.count()) / static_cast<double>(rtt.count()))));
-    auto interval = timeMax(conn.transportSettings.pacingTickInterval, rtt * burstPerInterval / cwndInPackets);
+            static_cast<double>(tickInterval.count()) / static_cast<double>(rtt.count()))));
+    auto interval = timeMax(tickInterval, rtt * burstPerInterval / cwndInPackets);
 
     return PacingRate::Builder()
         .setInterval(interval)
@@ -39,4 +51,54 @@ PacingRate calculatePacingRate(const QuicConnectionStateBase& conn, uint64_t cwn
         .build();
 }
 
+folly::Optional<CongestionStateSnapshot> snapshotCongestionState(const QuicConnectionStateBase& conn) {
+    if (!conn.congestionController) {
+        return folly::none;
+    }
+    auto congestionController = conn.congestionController->snapshot();
+    if (!congestionController) {
+        return folly::none;
+    }
+    CongestionStateSnapshot snapshot;
+    snapshot.congestionController = *congestionController;
+    if (conn.pacer) {
+        snapshot.pacer = conn.pacer->snapshot();
+    }
+    snapshot.srtt = conn.lossState.srtt;
+    snapshot.lrtt = conn.lossState.lrtt;
+    snapshot.rttvar = conn.lossState.rttvar;
+    snapshot.mrtt = conn.lossState.mrtt;
+    return snapshot;
+}
+
+bool restoreCongestionState(QuicConnectionStateBase& conn, const CongestionStateSnapshot& snapshot) {
+    if (!conn.congestionController || conn.congestionController->type() != snapshot.congestionController.type) {
+        return false;
+    }
+    // The controllers size the pacing rate from the RTT, so it goes first,
+    // and back if the controller rejects the snapshot.
+    auto& lossState = conn.lossState;
+    const auto srtt = lossState.srtt;
+    const auto lrtt = lossState.lrtt;
+    const auto rttvar = lossState.rttvar;
+    const auto mrtt = lossState.mrtt;
+    if (lossState.srtt == 0us && snapshot.srtt > 0us) {
+        lossState.srtt = snapshot.srtt;
+        lossState.lrtt = snapshot.lrtt;
+        lossState.rttvar = snapshot.rttvar;
+        lossState.mrtt = std::min(lossState.mrtt, snapshot.mrtt);
+    }
+    if (!conn.congestionController->restore(snapshot.congestionController)) {
+        lossState.srtt = srtt;
+        lossState.lrtt = lrtt;
+        lossState.rttvar = rttvar;
+        lossState.mrtt = mrtt;
+        return false;
+    }
+    if (conn.pacer && snapshot.pacer) {
+        conn.pacer->restore(*snapshot.pacer);
+    }
+    return true;
+}
+
 } // namespace quic
@@ -16,8 +16,32 @@ namespace quic {
 
 uint64_t boundedCwnd(uint64_t cwndBytes, uint64_t packetLength, uint64_t maxCwndInMss, uint64_t minCwndInMss) noexcept;
 
+/**
+ * The smallest interval between the pacer's writes, and the fewest packets it
+ * writes each time. L4S bottlenecks mark packets that queue for about a
+ * millisecond, which a default tick's worth of packets at the bottleneck rate
+ * already does, so while packets are marked for L4S the pacer writes a packet
+ * at a time, as often as the pacing timer's resolution allows.
+ */
+std::chrono::microseconds pacingTickInterval(const QuicConnectionStateBase& conn);
+uint64_t minPacingBurstPackets(const QuicConnectionStateBase& conn);
+
 PacingRate calculatePacingRate(const QuicConnectionStateBase& conn, uint64_t cwnd, uint64_t minCwndInMss, std::chrono::microseconds rtt);
 
+/**
+ * conn's congestion controller, pacer and RTT state, or none if its
+ * congestion controller can't be restored from a snapshot.
+ */
+folly::Optional<CongestionStateSnapshot> snapshotCongestionState(const QuicConnectionStateBase& conn);
+
+/**
+ * Makes conn go on from snapshot, which must come from a connection with the
+ * same congestion controller type. The RTT is only restored if conn has no
+ * sample of its own yet. Returns false, with conn left as it was, if the
+ * controller rejects the snapshot.
+ */
+bool restoreCongestionState(QuicConnectionStateBase& conn, const CongestionStateSnapshot& snapshot);
+
 template <class T1, class T2>
 void addAndCheckOverflow(T1& value, const T2& toAdd) {
     if (std::numeric_limits<T1>::max() - toAdd < value) {
@@ -37,11 +37,48 @@ struct CubicStats {
     uint64_t lastLossTimeMs;
 };
 
+struct MediaStats {
+    uint8_t usage;
+    uint64_t targetBitrate;
+};
+
 union CongestionControllerStats {
     struct BbrStats bbrStats;
     struct Bbr2Stats bbr2Stats;
     struct CopaStats copaStats;
     struct CubicStats cubicStats;
+    struct MediaStats mediaStats;
+};
+
+/**
+ * What a congestion controller needs to go on from where it was in a new
+ * instance of the same type, rather than from slow start. Plain values, so
+ * it can be handed to another shard's thread with the rest of the connection.
+ */
+struct CongestionControllerSnapshot {
+    CongestionControlType type{CongestionControlType::None};
+    uint64_t cwndBytes{0};
+    // The controller's state, as in its getStats().
+    uint8_t state{0};
+
+    // Cubic
+    uint64_t ssthreshBytes{std::numeric_limits<uint64_t>::max()};
+    folly::Optional<uint64_t> lastMaxCwndBytes;
+    folly::Optional<TimePoint> lastReductionTime;
+    uint64_t estRenoCwndBytes{0};
+
+    // BBR and BBR2
+    // Whether startup found the bottleneck bandwidth.
+    bool filledPipe{false};
+    Bandwidth bandwidth;
+    std::chrono::microseconds minRtt{0us};
+    folly::Optional<TimePoint> minRttTimestamp;
+
+    // BBR2's bounds from loss and ECN.
+    Bandwidth bandwidthHi;
+    Bandwidth bandwidthLo;
+    uint64_t inflightHi{std::numeric_limits<uint64_t>::max()};
+    uint64_t inflightLo{std::numeric_limits<uint64_t>::max()};
 };
 
 struct CongestionController {
@@ -179,6 +216,30 @@ public:
      * Enable experimental settings of the congestion controller
      */
     virtual void setExperimental(bool /*experimental*/) {}
+
+    /**
+     * The state to restore() another instance of this controller from, or none
+     * if the controller doesn't support it.
+     */
+    [[nodiscard]] virtual folly::Optional<CongestionControllerSnapshot> snapshot() const {
+        return folly::none;
+    }
+
+    /**
+     * Goes on from snapshot, taken from a controller of the same type, e.g. on
+     * another shard. Returns false and leaves the controller as it was if the
+     * snapshot can't be used.
+     */
+    virtual bool restore(const CongestionControllerSnapshot& /*snapshot*/) {
+        return false;
+    }
+
+    /**
+     * The connection is leaving its evb thread, e.g. on detachEventBase(). The
+     * controller lets go of that thread's shard state, and may pick up the new
+     * thread's once it sends again.
+     */
+    virtual void onEventBaseDetached() {}
 };
 
 } // namespace quic
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include "bbr.h"
+#include "bbr2.h"
+#include "congestion_controller.h"
+#include "congestion_controller_dispatch.h"
+#include "copa.h"
+#include "copa2.h"
+#include "media_congestion_controller.h"
+#include "new_reno.h"
+#include "quic_cubic.h"
+#include "static_cwnd_congestion_controller.h"
+#include "state/state_data.h"
+
+namespace quic {
+
+/*
+ * The congestion controller calls made for every packet sent or acked. Built
+ * with QUIC_DEVIRTUALIZE_CONGESTION_CONTROL they visit the controller as its
+ * concrete type, see CongestionControllerPtr, otherwise they go through the
+ * vtable. All of them expect conn.congestionController to be set.
+ */
+
+inline void congestionControllerOnPacketSent(QuicConnectionStateBase& conn, const OutstandingPacketWrapper& packet) {
+#ifdef QUIC_DEVIRTUALIZE_CONGESTION_CONTROL
+    conn.congestionController.visit([&packet](auto& controller) { controller.onPacketSent(packet); });
+#else
+    conn.congestionController->onPacketSent(packet);
+#endif
+}
+
+inline void congestionControllerOnPacketAckOrLoss(QuicConnectionStateBase& conn,
+    const CongestionController::AckEvent* FOLLY_NULLABLE ackEvent,
+    const CongestionController::LossEvent* FOLLY_NULLABLE lossEvent) {
+#ifdef QUIC_DEVIRTUALIZE_CONGESTION_CONTROL
+    conn.congestionController.visit(
+        [ackEvent, lossEvent](auto& controller) { controller.onPacketAckOrLoss(ackEvent, lossEvent); });
+#else
+    conn.congestionController->onPacketAckOrLoss(ackEvent, lossEvent);
+#endif
+}
+
+inline uint64_t congestionControllerWritableBytes(const QuicConnectionStateBase& conn) {
+#ifdef QUIC_DEVIRTUALIZE_CONGESTION_CONTROL
+    return conn.congestionController.visit([](const auto& controller) { return controller.getWritableBytes(); });
+#else
+    return conn.congestionController->getWritableBytes();
+#endif
+}
+
+inline uint64_t congestionControllerWindow(const QuicConnectionStateBase& conn) {
+#ifdef QUIC_DEVIRTUALIZE_CONGESTION_CONTROL
+    return conn.congestionController.visit([](const auto& controller) { return controller.getCongestionWindow(); });
+#else
+    return conn.congestionController->getCongestionWindow();
+#endif
+}
+
+} // namespace quic
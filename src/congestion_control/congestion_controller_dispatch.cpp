@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "congestion_controller_dispatch.h"
+#include "bbr.h"
+#include "bbr2.h"
+#include "copa.h"
+#include "copa2.h"
+#include "media_congestion_controller.h"
+#include "new_reno.h"
+#include "quic_cubic.h"
+#include "static_cwnd_congestion_controller.h"
+
+#include <typeinfo>
+
+namespace quic {
+
+void CongestionControllerPtr::reset(std::unique_ptr<CongestionController> controller) noexcept {
+    controller_ = std::move(controller);
+    auto* ptr = controller_.get();
+    concrete_ = ptr;
+    if (!ptr) {
+        return;
+    }
+    // Exact type match only, which final guarantees for the built-in ones.
+    const auto& type = typeid(*ptr);
+    if (type == typeid(Bbr2CongestionController)) {
+        concrete_ = static_cast<Bbr2CongestionController*>(ptr);
+    } else if (type == typeid(Cubic)) {
+        concrete_ = static_cast<Cubic*>(ptr);
+    } else if (type == typeid(BbrCongestionController)) {
+        concrete_ = static_cast<BbrCongestionController*>(ptr);
+    } else if (type == typeid(NewReno)) {
+        concrete_ = static_cast<NewReno*>(ptr);
+    } else if (type == typeid(Copa)) {
+        concrete_ = static_cast<Copa*>(ptr);
+    } else if (type == typeid(Copa2)) {
+        concrete_ = static_cast<Copa2*>(ptr);
+    } else if (type == typeid(MediaCongestionController)) {
+        concrete_ = static_cast<MediaCongestionController*>(ptr);
+    } else if (type == typeid(StaticCwndCongestionController)) {
+        concrete_ = static_cast<StaticCwndCongestionController*>(ptr);
+    }
+}
+
+} // namespace quic
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <variant>
+
+#include "congestion_controller.h"
+
+namespace quic {
+
+class Cubic;
+class NewReno;
+class Copa;
+class Copa2;
+class BbrCongestionController;
+class Bbr2CongestionController;
+class MediaCongestionController;
+struct StaticCwndCongestionController;
+
+/**
+ * Owns a connection's congestion controller like a unique_ptr, and also keeps
+ * a pointer to it as its concrete type in a variant. The concrete type is
+ * looked up once, when the controller is installed, and visit() hands the
+ * callback the controller as that type with a std::visit. The built-in
+ * controllers are final, so calls on them are direct, and their cwnd getters
+ * are defined in their headers so those inline too. Controllers from a custom
+ * factory are passed as CongestionController and called virtually.
+ *
+ * See congestion_controller_calls.h for the per packet calls using it.
+ */
+class CongestionControllerPtr {
+public:
+    using Concrete = std::variant<CongestionController*, Cubic*, NewReno*, Copa*, Copa2*, BbrCongestionController*,
+        Bbr2CongestionController*, MediaCongestionController*, StaticCwndCongestionController*>;
+
+    CongestionControllerPtr() = default;
+
+    CongestionControllerPtr(std::nullptr_t) {}
+
+    CongestionControllerPtr(std::unique_ptr<CongestionController> controller) {
+        reset(std::move(controller));
+    }
+
+    CongestionControllerPtr(CongestionControllerPtr&& other) noexcept {
+        reset(std::move(other.controller_));
+        other.reset();
+    }
+
+    CongestionControllerPtr& operator=(CongestionControllerPtr&& other) noexcept {
+        if (this != &other) {
+            reset(std::move(other.controller_));
+            other.reset();
+        }
+        return *this;
+    }
+
+    CongestionControllerPtr& operator=(std::unique_ptr<CongestionController> controller) {
+        reset(std::move(controller));
+        return *this;
+    }
+
+    CongestionControllerPtr& operator=(std::nullptr_t) {
+        reset();
+        return *this;
+    }
+
+    void reset(std::unique_ptr<CongestionController> controller = nullptr) noexcept;
+
+    [[nodiscard]] CongestionController* get() const {
+        return controller_.get();
+    }
+
+    CongestionController* operator->() const {
+        return controller_.get();
+    }
+
+    CongestionController& operator*() const {
+        return *controller_;
+    }
+
+    explicit operator bool() const {
+        return controller_ != nullptr;
+    }
+
+    friend bool operator==(const CongestionControllerPtr& ptr, std::nullptr_t) {
+        return !ptr;
+    }
+
+    /**
+     * Calls fn with the controller as its concrete type. Only instantiate
+     * where the controllers' headers are included.
+     */
+    template <typename Fn>
+    decltype(auto) visit(Fn&& fn) const {
+        return std::visit([&fn](auto* controller) -> decltype(auto) { return fn(*controller); }, concrete_);
+    }
+
+private:
+    std::unique_ptr<CongestionController> controller_;
+    Concrete concrete_{static_cast<CongestionController*>(nullptr)};
+};
+
+} // namespace quic
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "congestion_group.h"
+
+namespace quic {
+
+folly::Optional<CongestionGroup::Estimate> CongestionGroup::warmStartEstimate(TimePoint now) const {
+    if (!lastUpdate_ || now - *lastUpdate_ > estimateTtl_ || capacityBytesPerSec_ == 0 || !minRttTimestamp_ ||
+        now - *minRttTimestamp_ > estimateTtl_) {
+        return folly::none;
+    }
+    // The new member, counted in numMembers_ already, takes an equal share.
+    auto share = capacityBytesPerSec_ / std::max<uint64_t>(numMembers_, 1);
+    return Estimate{Bandwidth(share, 1s), minRtt_};
+}
+
+void CongestionGroup::update(
+    uint64_t oldBytesPerSec, uint64_t newBytesPerSec, std::chrono::microseconds minRtt, TimePoint now) {
+    bandwidthSumBytesPerSec_ -= std::min(oldBytesPerSec, bandwidthSumBytesPerSec_);
+    bandwidthSumBytesPerSec_ += newBytesPerSec;
+    capacityBytesPerSec_ = bandwidthSumBytesPerSec_;
+    if (minRtt != kDefaultMinRtt &&
+        (minRtt <= minRtt_ || !minRttTimestamp_ || now - *minRttTimestamp_ > estimateTtl_)) {
+        minRtt_ = minRtt;
+        minRttTimestamp_ = now;
+    }
+    lastUpdate_ = now;
+}
+
+CongestionGroupMembership::~CongestionGroupMembership() {
+    --group_.numMembers_;
+    group_.bandwidthSumBytesPerSec_ -= std::min(reportedBytesPerSec_, group_.bandwidthSumBytesPerSec_);
+}
+
+void CongestionGroupMembership::report(const Bandwidth& bandwidth, std::chrono::microseconds minRtt, TimePoint now) {
+    auto bytesPerSec = bandwidth.unitType == Bandwidth::UnitType::BYTES ? bandwidth.normalize() : 0;
+    group_.update(reportedBytesPerSec_, bytesPerSec, minRtt, now);
+    reportedBytesPerSec_ = bytesPerSec;
+}
+
+CongestionGroupTable& CongestionGroupTable::getThreadLocalInstance() {
+    static thread_local CongestionGroupTable sTable;
+    return sTable;
+}
+
+CongestionGroup& CongestionGroupTable::getGroup(
+    const folly::SocketAddress& peerAddress, const CongestionGroupConfig& config, TimePoint now) {
+    const auto& address = peerAddress.getIPAddress();
+    auto prefix = address.mask(address.isV4() ? config.v4PrefixLen : config.v6PrefixLen);
+    if (groups_.size() >= sweepAtSize_) {
+        for (auto it = groups_.begin(); it != groups_.end();) {
+            it = it->second.expired(now) ? groups_.erase(it) : std::next(it);
+        }
+        sweepAtSize_ = std::max(kMinSweepSize, 2 * groups_.size());
+    }
+    return groups_.try_emplace(std::move(prefix), config.estimateTtl).first->second;
+}
+
+} // namespace quic
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/IPAddress.h>
+#include <folly/Optional.h>
+#include <folly/SocketAddress.h>
+#include <folly/container/F14Map.h>
+#include "bandwidth.h"
+#include "protocol/quic_constants.hpp"
+#include "state/transport_setting.h"
+
+namespace quic {
+
+class CongestionGroupMembership;
+
+/**
+ * The connections on a shard whose peers share an address prefix, e.g.
+ * viewers behind one NAT, and so most likely a bottleneck. Members report
+ * their bandwidth and min RTT estimates. The sum of their bandwidths is the
+ * group's estimate of the bottleneck capacity, and a new member starts from
+ * its fair share of it rather than from initCwndInMss, instead of probing for
+ * bandwidth the others already use. Estimates outlive the members for the
+ * configured TTL, so a viewer reconnecting also starts warm.
+ */
+class CongestionGroup {
+public:
+    struct Estimate {
+        Bandwidth bandwidth;
+        std::chrono::microseconds minRtt;
+    };
+
+    explicit CongestionGroup(std::chrono::microseconds estimateTtl) : estimateTtl_(estimateTtl) {}
+
+    [[nodiscard]] uint64_t numMembers() const noexcept {
+        return numMembers_;
+    }
+
+    /**
+     * Bandwidth and min RTT a member joining at now should start from, if the
+     * group has recent enough estimates.
+     */
+    [[nodiscard]] folly::Optional<Estimate> warmStartEstimate(TimePoint now) const;
+
+    // A group without members nor usable estimates can be dropped.
+    [[nodiscard]] bool expired(TimePoint now) const noexcept {
+        return numMembers_ == 0 && (!lastUpdate_ || now - *lastUpdate_ > estimateTtl_);
+    }
+
+private:
+    friend class CongestionGroupMembership;
+
+    void update(uint64_t oldBytesPerSec, uint64_t newBytesPerSec, std::chrono::microseconds minRtt, TimePoint now);
+
+    std::chrono::microseconds estimateTtl_;
+    uint64_t numMembers_{0};
+    // Sum of the members' latest bandwidths.
+    uint64_t bandwidthSumBytesPerSec_{0};
+    // The sum as of the last report. Unlike the sum it isn't lowered when
+    // members leave, the capacity they used is still there.
+    uint64_t capacityBytesPerSec_{0};
+    std::chrono::microseconds minRtt_{kDefaultMinRtt};
+    folly::Optional<TimePoint> minRttTimestamp_;
+    folly::Optional<TimePoint> lastUpdate_;
+};
+
+/**
+ * A connection's membership in its CongestionGroup, which it leaves on
+ * destruction.
+ */
+class CongestionGroupMembership {
+public:
+    explicit CongestionGroupMembership(CongestionGroup& group) : group_(group) {
+        ++group_.numMembers_;
+    }
+
+    ~CongestionGroupMembership();
+
+    CongestionGroupMembership(const CongestionGroupMembership&) = delete;
+    CongestionGroupMembership& operator=(const CongestionGroupMembership&) = delete;
+
+    [[nodiscard]] folly::Optional<CongestionGroup::Estimate> warmStartEstimate(TimePoint now) const {
+        return group_.warmStartEstimate(now);
+    }
+
+    /**
+     * Replaces this member's bandwidth in the group's sum. minRtt is left out
+     * of the group's if it is still kDefaultMinRtt.
+     */
+    void report(const Bandwidth& bandwidth, std::chrono::microseconds minRtt, TimePoint now);
+
+private:
+    CongestionGroup& group_;
+    uint64_t reportedBytesPerSec_{0};
+};
+
+/**
+ * The congestion groups of a shard, keyed by masked peer address.
+ */
+class CongestionGroupTable {
+public:
+    static CongestionGroupTable& getThreadLocalInstance();
+
+    /**
+     * Returns the group peerAddress belongs to, creating it if needed. Expired
+     * groups are dropped here once the table has doubled in size since the
+     * last sweep.
+     */
+    CongestionGroup& getGroup(const folly::SocketAddress& peerAddress, const CongestionGroupConfig& config,
+        TimePoint now = Clock::now());
+
+    [[nodiscard]] size_t size() const noexcept {
+        return groups_.size();
+    }
+
+private:
+    static constexpr size_t kMinSweepSize = 1024;
+
+    // Node map: memberships hold references to the groups.
+    folly::F14NodeMap<folly::IPAddress, CongestionGroup> groups_;
+    size_t sweepAtSize_{kMinSweepSize};
+};
+
+} // namespace quic
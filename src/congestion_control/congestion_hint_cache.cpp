@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "congestion_hint_cache.h"
+
+namespace quic {
+
+CongestionHintCache& CongestionHintCache::getThreadLocalInstance() {
+    static thread_local CongestionHintCache sCache;
+    return sCache;
+}
+
+void CongestionHintCache::setCapacity(size_t capacity) {
+    capacity_ = capacity;
+    while (entries_.size() > capacity_) {
+        index_.erase(entries_.back().address);
+        entries_.pop_back();
+    }
+}
+
+void CongestionHintCache::insert(const folly::IPAddress& address, const CongestionHint& hint, TimePoint now) {
+    if (capacity_ == 0) {
+        return;
+    }
+    auto it = index_.find(address);
+    if (it != index_.end()) {
+        it->second->hint = hint;
+        it->second->insertTime = now;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+    if (entries_.size() >= capacity_) {
+        // Reuse the least recently used node.
+        index_.erase(entries_.back().address);
+        entries_.splice(entries_.begin(), entries_, std::prev(entries_.end()));
+        entries_.front() = Entry{address, hint, now};
+    } else {
+        entries_.push_front(Entry{address, hint, now});
+    }
+    index_.emplace(address, entries_.begin());
+}
+
+folly::Optional<CongestionHint> CongestionHintCache::get(
+    const folly::IPAddress& address, std::chrono::microseconds ttl, TimePoint now) {
+    auto it = index_.find(address);
+    if (it == index_.end()) {
+        return folly::none;
+    }
+    if (now - it->second->insertTime > ttl) {
+        entries_.erase(it->second);
+        index_.erase(it);
+        return folly::none;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->hint;
+}
+
+folly::Optional<CongestionHint> makeCongestionHint(const QuicConnectionStateBase& conn) {
+    const auto& lossState = conn.lossState;
+    if (!conn.congestionController || lossState.totalPacketsSent < kMinCongestionHintPackets ||
+        lossState.mrtt == kDefaultMinRtt) {
+        return folly::none;
+    }
+    auto bandwidth = conn.congestionController->getBandwidth();
+    uint64_t bytesPerSec = 0;
+    if (bandwidth && *bandwidth && bandwidth->unitType == Bandwidth::UnitType::BYTES) {
+        bytesPerSec = bandwidth->normalize();
+    } else if (lossState.srtt > 0us) {
+        // Window based controllers: one cwnd per RTT.
+        bytesPerSec = conn.congestionController->getCongestionWindow() * 1000000 /
+            static_cast<uint64_t>(lossState.srtt.count());
+    }
+    if (bytesPerSec == 0) {
+        return folly::none;
+    }
+    CongestionHint hint;
+    hint.bandwidthBytesPerSec = bytesPerSec;
+    hint.minRtt = lossState.mrtt;
+    hint.lossPerMille = static_cast<uint16_t>(
+        std::min<uint64_t>(1000, uint64_t(lossState.totalPacketsMarkedLost) * 1000 / lossState.totalPacketsSent));
+    return hint;
+}
+
+void recordCongestionHint(const QuicConnectionStateBase& conn) {
+    if (!conn.transportSettings.congestionHintConfig || !conn.peerAddress.isFamilyInet()) {
+        return;
+    }
+    if (auto hint = makeCongestionHint(conn)) {
+        CongestionHintCache::getThreadLocalInstance().insert(conn.peerAddress.getIPAddress(), *hint);
+    }
+}
+
+folly::Optional<CongestionHint> lookupCongestionHint(const QuicConnectionStateBase& conn) {
+    const auto& config = conn.transportSettings.congestionHintConfig;
+    if (!config || conn.lossState.totalPacketsSent > 0 || !conn.peerAddress.isFamilyInet()) {
+        return folly::none;
+    }
+    return CongestionHintCache::getThreadLocalInstance().get(conn.peerAddress.getIPAddress(), config->ttl);
+}
+
+bool applyCongestionHint(QuicConnectionStateBase& conn, const CongestionHint& hint) {
+    const auto& config = conn.transportSettings.congestionHintConfig;
+    if (!config || hint.lossPerMille > config->maxLossPerMille || hint.minRtt <= 0us) {
+        return false;
+    }
+    // A fraction of the last BDP: the path may have changed since.
+    auto bdpBytes = hint.bandwidthBytesPerSec * static_cast<uint64_t>(hint.minRtt.count()) / 1000000;
+    auto cwndInMss = static_cast<uint64_t>(static_cast<double>(bdpBytes) * config->cwndGain) / conn.udpSendPacketLen;
+    auto& settings = conn.transportSettings;
+    settings.initCwndInMss = std::max(settings.initCwndInMss, std::min(cwndInMss, config->maxInitCwndInMss));
+    settings.initialRtt = std::min(settings.initialRtt, std::max(hint.minRtt, config->minInitialRtt));
+    return true;
+}
+
+} // namespace quic
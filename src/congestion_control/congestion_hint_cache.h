@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/IPAddress.h>
+#include <folly/Optional.h>
+#include <folly/container/F14Map.h>
+#include "protocol/quic_constants.hpp"
+#include "state/state_data.h"
+
+#include <list>
+
+namespace quic {
+
+/**
+ * What a finished connection learned about its path, for the next connection
+ * from the same client to start from instead of kInitCwndInMss and
+ * initialRtt.
+ */
+struct CongestionHint {
+    uint64_t bandwidthBytesPerSec{0};
+    std::chrono::microseconds minRtt{0us};
+    // Packets declared lost per thousand sent.
+    uint16_t lossPerMille{0};
+};
+
+/**
+ * Per shard LRU cache of CongestionHints keyed by client address. The port is
+ * left out of the key since a reconnecting client usually gets a new one.
+ */
+class CongestionHintCache {
+public:
+    static CongestionHintCache& getThreadLocalInstance();
+
+    void setCapacity(size_t capacity);
+
+    [[nodiscard]] size_t size() const noexcept {
+        return entries_.size();
+    }
+
+    void insert(const folly::IPAddress& address, const CongestionHint& hint, TimePoint now = Clock::now());
+
+    /**
+     * Returns the hint for address if it was inserted less than ttl ago, and
+     * marks it most recently used.
+     */
+    folly::Optional<CongestionHint> get(
+        const folly::IPAddress& address, std::chrono::microseconds ttl, TimePoint now = Clock::now());
+
+private:
+    struct Entry {
+        folly::IPAddress address;
+        CongestionHint hint;
+        TimePoint insertTime;
+    };
+
+    size_t capacity_{kDefaultCongestionHintCacheSize};
+    // Most recently used first.
+    std::list<Entry> entries_;
+    folly::F14FastMap<folly::IPAddress, std::list<Entry>::iterator> index_;
+};
+
+/**
+ * The hint to remember for conn's peer, if conn measured its path well
+ * enough: enough packets sent, a bandwidth estimate and an RTT sample.
+ */
+folly::Optional<CongestionHint> makeCongestionHint(const QuicConnectionStateBase& conn);
+
+/**
+ * Stores conn's hint in the shard's cache, on close.
+ */
+void recordCongestionHint(const QuicConnectionStateBase& conn);
+
+/**
+ * The cached hint for conn's peer, if congestion hints are enabled and conn
+ * hasn't sent anything yet.
+ */
+folly::Optional<CongestionHint> lookupCongestionHint(const QuicConnectionStateBase& conn);
+
+/**
+ * Raises conn's initial cwnd and lowers its initial RTT towards what hint
+ * measured, within transportSettings.congestionHintConfig's clamps. Returns
+ * false if the hint isn't trusted, e.g. because the path was lossy.
+ */
+bool applyCongestionHint(QuicConnectionStateBase& conn, const CongestionHint& hint);
+
+} // namespace quic
@@ -221,6 +221,10 @@ void Copa::onPacketAcked(const AckEvent& ack) {
         isSlowStart_ = false;
         subtractAndCheckUnderflow(cwndBytes_, std::min<uint64_t>(reduction, cwndBytes_ - conn_.transportSettings.minCwndInMss * conn_.udpSendPacketLen));
     }
+    // Copa doesn't back off on loss, so when the queueing delay stays hidden,
+    // e.g. under ACK aggregation, the window would otherwise grow without end.
+    cwndBytes_ = boundedCwnd(cwndBytes_, conn_.udpSendPacketLen, conn_.transportSettings.maxCwndInMss,
+        conn_.transportSettings.minCwndInMss);
     if (conn_.pacer) {
         conn_.pacer->refreshPacingRate(cwndBytes_ * 2, conn_.lossState.srtt);
     }
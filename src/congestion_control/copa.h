@@ -28,7 +28,7 @@ constexpr std::chrono::microseconds kMinRTTWindowLength{10s};
  * https://www.usenix.org/system/files/conference/nsdi18/nsdi18-arun.pdf
  */
 
-class Copa : public CongestionController {
+class Copa final : public CongestionController {
 public:
     explicit Copa(QuicConnectionStateBase& conn);
     void onRemoveBytesFromInflight(uint64_t) override;
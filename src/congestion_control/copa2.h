@@ -19,7 +19,7 @@ using namespace std::chrono_literals;
 constexpr std::chrono::microseconds kCopa2MinRttWindowLength{10s};
 constexpr std::chrono::microseconds kCopa2ProbeRttInterval{8s};
 
-class Copa2 : public CongestionController {
+class Copa2 final : public CongestionController {
 public:
     explicit Copa2(QuicConnectionStateBase& conn);
     void onRemoveBytesFromInflight(uint64_t) override;
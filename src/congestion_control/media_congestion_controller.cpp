@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "media_congestion_controller.h"
+#include "congestion_control_functions.h"
+#include "logging/qlogger_constants.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace quic {
+
+using namespace std::chrono;
+
+namespace {
+
+// Threshold adaptation speeds, per ms, when the trend is above and below it.
+constexpr double kThresholdGainUp = 0.0087;
+constexpr double kThresholdGainDown = 0.039;
+constexpr double kMinThresholdMs = 6;
+constexpr double kMaxThresholdMs = 600;
+// Trends this far above the threshold are spikes the threshold shouldn't
+// follow.
+constexpr double kMaxThresholdAdaptOvershootMs = 15;
+constexpr uint64_t kMaxModifiedTrendDeltas = 60;
+// Multiplicative increase per second, far from the last overuse.
+constexpr double kMultiplicativeIncreasePerSec = 1.08;
+constexpr uint64_t kMinIncreaseBitrate = 1000;
+// Above the acked bitrate the target may run ahead by this much.
+constexpr double kMaxTargetToAckedRatio = 1.5;
+constexpr uint64_t kMaxTargetOverAckedBitrate = 10'000;
+constexpr microseconds kResponseTimeOverRtt{100ms};
+constexpr double kMaxBitrateSmoothing = 0.05;
+constexpr uint64_t kMinPacketsInLossCycle = 20;
+constexpr microseconds kMinLossCycleLength{100ms};
+constexpr double kHighLossFraction = 0.1;
+
+double toMs(microseconds duration) {
+    return static_cast<double>(duration.count()) / 1000.0;
+}
+
+} // namespace
+
+MediaCongestionController::MediaCongestionController(QuicConnectionStateBase& conn)
+    : conn_(conn), cwndBytes_(conn.transportSettings.initCwndInMss * conn.udpSendPacketLen),
+      targetBitrate_(conn.transportSettings.mediaCongestionControllerConfig.startBitrate),
+      minRttFilter_(kMediaMinRttWindowLength.count(), 0us, 0) {
+    setTargetBitrate(targetBitrate_);
+}
+
+void MediaCongestionController::onRemoveBytesFromInflight(uint64_t bytes) {
+    subtractAndCheckUnderflow(conn_.lossState.inflightBytes, bytes);
+    if (conn_.qLogger) {
+        conn_.qLogger->addCongestionMetricUpdate(conn_.lossState.inflightBytes, getCongestionWindow(), kRemoveInflight);
+    }
+}
+
+void MediaCongestionController::onPacketSent(const OutstandingPacketWrapper& packet) {
+    addAndCheckOverflow(conn_.lossState.inflightBytes, packet.metadata.encodedSize);
+    if (conn_.qLogger) {
+        conn_.qLogger->addCongestionMetricUpdate(
+            conn_.lossState.inflightBytes, getCongestionWindow(), kCongestionPacketSent);
+    }
+}
+
+void MediaCongestionController::onPacketAckOrLoss(
+    const AckEvent* FOLLY_NULLABLE ack, const LossEvent* FOLLY_NULLABLE loss) {
+    if (loss) {
+        onPacketLoss(*loss);
+        if (conn_.pacer) {
+            conn_.pacer->onPacketsLoss();
+        }
+    }
+    if (ack && ack->largestNewlyAckedPacket.has_value()) {
+        if (appLimited_ && appLimitedExitTarget_ < ack->largestNewlyAckedPacketSentTime) {
+            appLimited_ = false;
+            if (conn_.qLogger) {
+                conn_.qLogger->addAppUnlimitedUpdate();
+            }
+        }
+        onPacketAcked(*ack);
+    }
+    updateCwndAndPacing();
+}
+
+void MediaCongestionController::onPacketAcked(const AckEvent& ack) {
+    subtractAndCheckUnderflow(conn_.lossState.inflightBytes, ack.ackedBytes);
+    minRttFilter_.Update(conn_.lossState.lrtt, duration_cast<microseconds>(ack.ackTime.time_since_epoch()).count());
+    numAckedInLossCycle_ += ack.ackedPackets.size();
+
+    updateAckedBitrate(ack);
+    updateTrendline(ack);
+    updateTargetBitrate(ack.ackTime);
+    maybeEndLossCycle(ack.ackTime);
+}
+
+void MediaCongestionController::onPacketLoss(const LossEvent& loss) {
+    subtractAndCheckUnderflow(conn_.lossState.inflightBytes, loss.lostBytes);
+    if (conn_.qLogger) {
+        conn_.qLogger->addCongestionMetricUpdate(
+            conn_.lossState.inflightBytes, getCongestionWindow(), kCongestionPacketLoss);
+    }
+    if (loss.persistentCongestion) {
+        // Nothing got through for several PTOs, start over from the bottom.
+        setTargetBitrate(conn_.transportSettings.mediaCongestionControllerConfig.minBitrate);
+        rateState_ = RateState::Hold;
+        if (conn_.qLogger) {
+            conn_.qLogger->addCongestionMetricUpdate(
+                conn_.lossState.inflightBytes, getCongestionWindow(), kPersistentCongestion);
+        }
+    }
+    numLostInLossCycle_ += loss.lostPackets;
+    maybeEndLossCycle(loss.lossTime);
+}
+
+void MediaCongestionController::updateTrendline(const AckEvent& ack) {
+    // adjustedAckTime leaves out the time the peer held the ACK, so what is
+    // left is the RTT, whose growth is the queue's.
+    auto delay = duration_cast<microseconds>(ack.adjustedAckTime - ack.largestNewlyAckedPacketSentTime);
+    if (!firstDelay_) {
+        firstDelay_ = delay;
+        firstArrival_ = ack.ackTime;
+    }
+    smoothedDelayMs_ = kMediaTrendlineSmoothing * smoothedDelayMs_ +
+        (1 - kMediaTrendlineSmoothing) * toMs(delay - *firstDelay_);
+    delaySamples_.push_back(
+        DelaySample{toMs(duration_cast<microseconds>(ack.ackTime - *firstArrival_)), smoothedDelayMs_});
+    if (delaySamples_.size() > kMediaTrendlineWindowSize) {
+        delaySamples_.pop_front();
+    }
+    numDeltas_ = std::min<uint64_t>(numDeltas_ + 1, 1000);
+    if (delaySamples_.size() < kMediaTrendlineWindowSize) {
+        return;
+    }
+
+    // Least squares slope of the smoothed delay over the arrival time.
+    double sumX = 0;
+    double sumY = 0;
+    for (const auto& sample : delaySamples_) {
+        sumX += sample.arrivalMs;
+        sumY += sample.smoothedDelayMs;
+    }
+    auto meanX = sumX / static_cast<double>(delaySamples_.size());
+    auto meanY = sumY / static_cast<double>(delaySamples_.size());
+    double numerator = 0;
+    double denominator = 0;
+    for (const auto& sample : delaySamples_) {
+        numerator += (sample.arrivalMs - meanX) * (sample.smoothedDelayMs - meanY);
+        denominator += (sample.arrivalMs - meanX) * (sample.arrivalMs - meanX);
+    }
+    auto trend = denominator != 0 ? numerator / denominator : prevTrend_;
+    auto modifiedTrend =
+        static_cast<double>(std::min(numDeltas_, kMaxModifiedTrendDeltas)) * trend * kMediaTrendlineGain;
+    detectUsage(modifiedTrend, trend, ack.ackTime);
+}
+
+void MediaCongestionController::detectUsage(double modifiedTrend, double trend, TimePoint now) {
+    if (modifiedTrend > thresholdMs_) {
+        if (!overuseStart_) {
+            overuseStart_ = now;
+        }
+        // Only once the delay grew for long enough, and is still growing.
+        if (now - *overuseStart_ >= kMediaOveruseTime && trend >= prevTrend_) {
+            usage_ = Usage::Overusing;
+        }
+    } else if (modifiedTrend < -thresholdMs_) {
+        overuseStart_.reset();
+        usage_ = Usage::Underusing;
+    } else {
+        overuseStart_.reset();
+        usage_ = Usage::Normal;
+    }
+    prevTrend_ = trend;
+    updateThreshold(modifiedTrend, now);
+}
+
+void MediaCongestionController::updateThreshold(double modifiedTrend, TimePoint now) {
+    if (!lastThresholdUpdate_) {
+        lastThresholdUpdate_ = now;
+    }
+    auto absTrend = std::fabs(modifiedTrend);
+    if (absTrend > thresholdMs_ + kMaxThresholdAdaptOvershootMs) {
+        lastThresholdUpdate_ = now;
+        return;
+    }
+    auto gain = absTrend < thresholdMs_ ? kThresholdGainDown : kThresholdGainUp;
+    auto elapsedMs = toMs(std::min<microseconds>(duration_cast<microseconds>(now - *lastThresholdUpdate_), 100ms));
+    thresholdMs_ = std::clamp(thresholdMs_ + gain * (absTrend - thresholdMs_) * elapsedMs, kMinThresholdMs,
+        kMaxThresholdMs);
+    lastThresholdUpdate_ = now;
+}
+
+void MediaCongestionController::updateAckedBitrate(const AckEvent& ack) {
+    if (!ackedWindowStart_) {
+        ackedWindowStart_ = ack.ackTime;
+    }
+    ackedWindowBytes_ += ack.ackedBytes;
+    auto elapsed = duration_cast<microseconds>(ack.ackTime - *ackedWindowStart_);
+    if (elapsed >= kMediaAckedBitrateWindow) {
+        ackedBandwidth_ = Bandwidth(ackedWindowBytes_, elapsed);
+        ackedWindowStart_ = ack.ackTime;
+        ackedWindowBytes_ = 0;
+    }
+}
+
+void MediaCongestionController::updateTargetBitrate(TimePoint now) {
+    auto elapsed = lastRateUpdate_ ? duration_cast<microseconds>(now - *lastRateUpdate_) : 0us;
+    lastRateUpdate_ = now;
+
+    switch (usage_) {
+        case Usage::Overusing:
+            rateState_ = RateState::Decrease;
+            break;
+        case Usage::Underusing:
+            // The queue is draining, let it before growing again.
+            rateState_ = RateState::Hold;
+            break;
+        case Usage::Normal:
+            if (rateState_ == RateState::Hold) {
+                rateState_ = RateState::Increase;
+            } else if (rateState_ == RateState::Decrease) {
+                rateState_ = RateState::Hold;
+            }
+            break;
+    }
+
+    auto ackedBitrate = ackedBandwidth_ ? folly::make_optional(ackedBandwidth_.normalize() * 8) : folly::none;
+    auto target = static_cast<double>(targetBitrate_);
+    switch (rateState_) {
+        case RateState::Increase: {
+            if (ackedBitrate && avgMaxBitrateKbps_) {
+                auto ackedKbps = static_cast<double>(*ackedBitrate) / 1000;
+                // The bottleneck moved up, the old maximum doesn't hold anymore.
+                if (ackedKbps > *avgMaxBitrateKbps_ + 3 * std::sqrt(varMaxBitrateKbps_ * *avgMaxBitrateKbps_)) {
+                    avgMaxBitrateKbps_.reset();
+                }
+            }
+            auto elapsedSec = std::min(static_cast<double>(elapsed.count()) / 1e6, 1.0);
+            double increase;
+            if (avgMaxBitrateKbps_) {
+                // About a packet per response time, near the last overuse.
+                auto responseTime = minRttFilter_.GetBest() + kResponseTimeOverRtt;
+                auto packetBits = static_cast<double>(conn_.udpSendPacketLen * 8);
+                increase = std::max<double>(kMinIncreaseBitrate, packetBits * 1e6 / responseTime.count()) * elapsedSec;
+            } else {
+                increase = target * (std::pow(kMultiplicativeIncreasePerSec, elapsedSec) - 1);
+            }
+            target += increase;
+            if (ackedBitrate && !appLimited_) {
+                // Don't run ahead of what actually gets through.
+                target = std::min(
+                    target, kMaxTargetToAckedRatio * static_cast<double>(*ackedBitrate) + kMaxTargetOverAckedBitrate);
+            }
+            break;
+        }
+        case RateState::Decrease:
+            if (ackedBitrate) {
+                target = std::min(target, kMediaDecreaseFactor * static_cast<double>(*ackedBitrate));
+                updateMaxBitrateEstimate(static_cast<double>(*ackedBitrate) / 1000);
+            } else {
+                target *= kMediaDecreaseFactor;
+            }
+            // One decrease per overuse, then wait for the queue to drain.
+            rateState_ = RateState::Hold;
+            usage_ = Usage::Normal;
+            overuseStart_.reset();
+            break;
+        case RateState::Hold:
+            break;
+    }
+    setTargetBitrate(static_cast<uint64_t>(target));
+}
+
+void MediaCongestionController::updateMaxBitrateEstimate(double ackedKbps) {
+    if (avgMaxBitrateKbps_ &&
+        ackedKbps < *avgMaxBitrateKbps_ - 3 * std::sqrt(varMaxBitrateKbps_ * *avgMaxBitrateKbps_)) {
+        avgMaxBitrateKbps_.reset();
+    }
+    if (!avgMaxBitrateKbps_) {
+        avgMaxBitrateKbps_ = ackedKbps;
+    } else {
+        *avgMaxBitrateKbps_ = (1 - kMaxBitrateSmoothing) * *avgMaxBitrateKbps_ + kMaxBitrateSmoothing * ackedKbps;
+    }
+    auto norm = std::max(*avgMaxBitrateKbps_, 1.0);
+    auto deviation = *avgMaxBitrateKbps_ - ackedKbps;
+    varMaxBitrateKbps_ = std::clamp((1 - kMaxBitrateSmoothing) * varMaxBitrateKbps_ +
+            kMaxBitrateSmoothing * deviation * deviation / norm,
+        0.4, 2.5);
+}
+
+void MediaCongestionController::maybeEndLossCycle(TimePoint now) {
+    auto numPackets = numAckedInLossCycle_ + numLostInLossCycle_;
+    if (now - lossCycleStartTime_ < std::max<microseconds>(conn_.lossState.srtt, kMinLossCycleLength) ||
+        numPackets < kMinPacketsInLossCycle) {
+        return;
+    }
+    auto lossFraction = static_cast<double>(numLostInLossCycle_) / static_cast<double>(numPackets);
+    if (lossFraction > kHighLossFraction) {
+        // Delay doesn't build on short buffers, the loss does.
+        setTargetBitrate(static_cast<uint64_t>(static_cast<double>(targetBitrate_) * (1 - 0.5 * lossFraction)));
+        rateState_ = RateState::Hold;
+    }
+    numAckedInLossCycle_ = 0;
+    numLostInLossCycle_ = 0;
+    lossCycleStartTime_ = now;
+}
+
+void MediaCongestionController::setTargetBitrate(uint64_t bitsPerSecond) {
+    const auto& config = conn_.transportSettings.mediaCongestionControllerConfig;
+    targetBitrate_ = std::clamp(bitsPerSecond, config.minBitrate, config.maxBitrate);
+    auto change = targetBitrate_ > reportedBitrate_ ? targetBitrate_ - reportedBitrate_
+                                                    : reportedBitrate_ - targetBitrate_;
+    if (reportedBitrate_ == 0 ||
+        static_cast<double>(change) >= config.reportThreshold * static_cast<double>(reportedBitrate_)) {
+        reportedBitrate_ = targetBitrate_;
+        conn_.pendingEvents.targetBitrate = targetBitrate_;
+    }
+}
+
+void MediaCongestionController::updateCwndAndPacing() {
+    auto rtt = minRttFilter_.GetBest();
+    if (rtt == 0us) {
+        rtt = conn_.transportSettings.initialRtt;
+    }
+    // Paced at the target, with a window of twice its BDP so that the pacer
+    // and not the window sets the rate.
+    auto bdp = Bandwidth(targetBitrate_ / 8, 1s) * rtt;
+    auto minCwnd = conn_.transportSettings.minCwndInMss * conn_.udpSendPacketLen;
+    auto maxCwnd = conn_.transportSettings.maxCwndInMss * conn_.udpSendPacketLen;
+    cwndBytes_ = std::clamp<uint64_t>(2 * bdp, minCwnd, std::max(minCwnd, maxCwnd));
+    if (conn_.pacer) {
+        conn_.pacer->refreshPacingRate(std::max(bdp, minCwnd), rtt);
+    }
+}
+
+uint64_t MediaCongestionController::getWritableBytes() const noexcept {
+    if (conn_.lossState.inflightBytes > cwndBytes_) {
+        return 0;
+    } else {
+        return cwndBytes_ - conn_.lossState.inflightBytes;
+    }
+}
+
+uint64_t MediaCongestionController::getCongestionWindow() const noexcept {
+    return cwndBytes_;
+}
+
+folly::Optional<Bandwidth> MediaCongestionController::getBandwidth() const noexcept {
+    return Bandwidth(targetBitrate_ / 8, 1s);
+}
+
+CongestionControlType MediaCongestionController::type() const noexcept {
+    return CongestionControlType::Media;
+}
+
+void MediaCongestionController::setAppIdle(bool, TimePoint) noexcept {}
+
+void MediaCongestionController::setAppLimited() {
+    if (conn_.lossState.inflightBytes > getCongestionWindow()) {
+        return;
+    }
+    appLimited_ = true;
+    appLimitedExitTarget_ = Clock::now();
+    if (conn_.qLogger) {
+        conn_.qLogger->addAppLimitedUpdate();
+    }
+}
+
+bool MediaCongestionController::isAppLimited() const noexcept {
+    return appLimited_;
+}
+
+void MediaCongestionController::getStats(CongestionControllerStats& stats) const {
+    stats.mediaStats.usage = static_cast<uint8_t>(usage_);
+    stats.mediaStats.targetBitrate = targetBitrate_;
+}
+
+} // namespace quic
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include "congestion_controller.h"
+#include "windowed_filter.h"
+#include "state/ack_event.h"
+#include "state/state_data.h"
+
+#include <deque>
+
+namespace quic {
+
+using namespace std::chrono_literals;
+constexpr std::chrono::microseconds kMediaMinRttWindowLength{10s};
+// Number of delay samples the trendline is fitted over.
+constexpr size_t kMediaTrendlineWindowSize{20};
+constexpr double kMediaTrendlineSmoothing{0.9};
+constexpr double kMediaTrendlineGain{4.0};
+// How long the trend has to exceed the threshold before it is overuse.
+constexpr std::chrono::microseconds kMediaOveruseTime{10ms};
+constexpr double kMediaInitialThresholdMs{12.5};
+// On overuse the target drops to this fraction of the acked bitrate.
+constexpr double kMediaDecreaseFactor{0.85};
+constexpr std::chrono::microseconds kMediaAckedBitrateWindow{250ms};
+
+/**
+ * Delay based congestion controller for low latency live media, after GCC
+ * (draft-ietf-rmcat-gcc). It keeps the queue at the bottleneck near empty
+ * rather than filling it: the growth of the one way delay is estimated with a
+ * least squares fit over the recent smoothed delays, and once the trend
+ * exceeds an adaptive threshold for a while the target bitrate drops below
+ * the acked bitrate. Otherwise the target grows, multiplicatively while far
+ * from the bitrate of the last overuse and additively near it. Losses above
+ * 10% cut the target as well, for paths with short buffers.
+ *
+ * The sender is paced at the target bitrate. The target is reported through
+ * ConnectionCallback::onTargetBitrateChange, so that the app can switch
+ * renditions before the queue builds up, rather than once the cwnd blocks its
+ * writes.
+ */
+class MediaCongestionController final : public CongestionController {
+public:
+    enum class Usage : uint8_t {
+        Normal,
+        Overusing,
+        Underusing,
+    };
+
+    enum class RateState : uint8_t {
+        Increase,
+        Hold,
+        Decrease,
+    };
+
+    explicit MediaCongestionController(QuicConnectionStateBase& conn);
+    void onRemoveBytesFromInflight(uint64_t) override;
+    void onPacketSent(const OutstandingPacketWrapper& packet) override;
+    void onPacketAckOrLoss(const AckEvent* FOLLY_NULLABLE, const LossEvent* FOLLY_NULLABLE) override;
+    void onPacketAckOrLoss(folly::Optional<AckEvent> ack, folly::Optional<LossEvent> loss) {
+        onPacketAckOrLoss(ack.get_pointer(), loss.get_pointer());
+    }
+
+    FOLLY_NODISCARD uint64_t getWritableBytes() const noexcept override;
+    FOLLY_NODISCARD uint64_t getCongestionWindow() const noexcept override;
+    FOLLY_NODISCARD folly::Optional<Bandwidth> getBandwidth() const noexcept override;
+    FOLLY_NODISCARD CongestionControlType type() const noexcept override;
+
+    void setAppIdle(bool, TimePoint) noexcept override;
+    void setAppLimited() override;
+    FOLLY_NODISCARD bool isAppLimited() const noexcept override;
+
+    void setBandwidthUtilizationFactor(float /*bandwidthUtilizationFactor*/) noexcept override {}
+
+    bool isInBackgroundMode() const noexcept override {
+        return false;
+    }
+
+    // In bits per second.
+    FOLLY_NODISCARD uint64_t getTargetBitrate() const noexcept {
+        return targetBitrate_;
+    }
+
+    FOLLY_NODISCARD Usage getUsage() const noexcept {
+        return usage_;
+    }
+
+    FOLLY_NODISCARD RateState getRateState() const noexcept {
+        return rateState_;
+    }
+
+    void getStats(CongestionControllerStats& stats) const override;
+
+private:
+    struct DelaySample {
+        double arrivalMs;
+        double smoothedDelayMs;
+    };
+
+    void onPacketAcked(const AckEvent& ack);
+    void onPacketLoss(const LossEvent& loss);
+    void updateTrendline(const AckEvent& ack);
+    void detectUsage(double modifiedTrend, double trend, TimePoint now);
+    void updateThreshold(double modifiedTrend, TimePoint now);
+    void updateAckedBitrate(const AckEvent& ack);
+    void updateTargetBitrate(TimePoint now);
+    void updateMaxBitrateEstimate(double ackedKbps);
+    void maybeEndLossCycle(TimePoint now);
+    void setTargetBitrate(uint64_t bitsPerSecond);
+    void updateCwndAndPacing();
+
+    QuicConnectionStateBase& conn_;
+    uint64_t cwndBytes_;
+    // In bits per second.
+    uint64_t targetBitrate_;
+    uint64_t reportedBitrate_{0};
+
+    WindowedFilter<std::chrono::microseconds, MinFilter<std::chrono::microseconds>, uint64_t, uint64_t> minRttFilter_;
+
+    // Trendline estimator. Delays are relative to the first sample, which
+    // leaves out the base RTT.
+    folly::Optional<std::chrono::microseconds> firstDelay_;
+    folly::Optional<TimePoint> firstArrival_;
+    double smoothedDelayMs_{0};
+    std::deque<DelaySample> delaySamples_;
+    uint64_t numDeltas_{0};
+    double prevTrend_{0};
+
+    // Overuse detector.
+    double thresholdMs_{kMediaInitialThresholdMs};
+    folly::Optional<TimePoint> lastThresholdUpdate_;
+    folly::Optional<TimePoint> overuseStart_;
+    Usage usage_{Usage::Normal};
+
+    // Rate controller.
+    RateState rateState_{RateState::Increase};
+    folly::Optional<TimePoint> lastRateUpdate_;
+    // Acked bitrate at the recent decreases, and its normalized variance.
+    // Close to it, the target only grows additively.
+    folly::Optional<double> avgMaxBitrateKbps_;
+    double varMaxBitrateKbps_{0.4};
+
+    // Acked bitrate over the last complete window.
+    Bandwidth ackedBandwidth_;
+    folly::Optional<TimePoint> ackedWindowStart_;
+    uint64_t ackedWindowBytes_{0};
+
+    // Loss rate over windows of at least an RTT.
+    uint64_t numAckedInLossCycle_{0};
+    uint64_t numLostInLossCycle_{0};
+    TimePoint lossCycleStartTime_{Clock::now()};
+
+    bool appLimited_{false};
+    // When a packet with a send time later than appLimitedExitTarget_ is acked,
+    // an app-limited connection is considered no longer app-limited.
+    TimePoint appLimitedExitTarget_;
+};
+
+} // namespace quic
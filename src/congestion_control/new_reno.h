@@ -17,7 +17,7 @@
 
 namespace quic {
 
-class NewReno : public CongestionController {
+class NewReno final : public CongestionController {
 public:
     explicit NewReno(QuicConnectionStateBase& conn);
     void onRemoveBytesFromInflight(uint64_t) override;
@@ -12,6 +12,8 @@
 
 #include <folly/Chrono.h>
 
+#include <algorithm>
+
 namespace quic {
 
 Cubic::Cubic(QuicConnectionStateBase& conn, uint64_t initCwndBytes,
@@ -37,11 +39,6 @@ CubicStates Cubic::state() const noexcept {
     return state_;
 }
 
-uint64_t Cubic::getWritableBytes() const noexcept {
-    return cwndBytes_ > conn_.lossState.inflightBytes
-        ? cwndBytes_ - conn_.lossState.inflightBytes : 0;
-}
-
 void Cubic::handoff(uint64_t newCwnd, uint64_t newSsthresh, TimePoint lastReductionTime) noexcept {
     cwndBytes_ = newCwnd;
     ssthresh_ = newSsthresh;
@@ -52,10 +49,6 @@ void Cubic::handoff(uint64_t newCwnd, uint64_t newSsthresh, TimePoint lastReduct
     }
 }
 
-uint64_t Cubic::getCongestionWindow() const noexcept {
-    return cwndBytes_;
-}
-
 /**
  * TODO: onPersistentCongestion entirely depends on how long a loss period is,
  * not how much a sender sends during that period. If the connection is app
@@ -75,6 +68,7 @@ void Cubic::onPersistentCongestion() {
     quiescenceStart_.reset();
     hystartState_.found = Cubic::HystartFound::No;
     hystartState_.inRttRound = false;
+    hystartState_.cssBaselineMinRtt.reset();
 
     state_ = CubicStates::Hystart;
 
@@ -108,10 +102,11 @@ void Cubic::onPacketLoss(const LossEvent& loss) {
   if (*loss.largestLostSentTime >=
       recoveryState_.endOfRecovery.value_or(*loss.largestLostSentTime)) {
     recoveryState_.endOfRecovery = Clock::now();
-    cubicReduction(loss.lossTime);
+    cubicReduction(loss.lossTime, steadyState_.reductionFactor, true);
     if (state_ == CubicStates::Hystart || state_ == CubicStates::Steady) {
       state_ = CubicStates::FastRecovery;
     }
+    hystartState_.cssBaselineMinRtt.reset();
     ssthresh_ = cwndBytes_;
     if (conn_.pacer) {
       conn_.pacer->refreshPacingRate(
@@ -288,8 +283,12 @@ uint64_t Cubic::calculateCubicCwnd(int64_t delta) noexcept {
   }
 }
 
-void Cubic::cubicReduction(TimePoint lossTime) noexcept {
-  if (cwndBytes_ >= steadyState_.lastMaxCwndBytes.value_or(cwndBytes_)) {
+void Cubic::cubicReduction(
+    TimePoint lossTime,
+    float reductionFactor,
+    bool fastConvergence) noexcept {
+  if (!fastConvergence ||
+      cwndBytes_ >= steadyState_.lastMaxCwndBytes.value_or(cwndBytes_)) {
     steadyState_.lastMaxCwndBytes = cwndBytes_;
   } else {
     // We need to reduce cwnd before it goes back to previous reduction point.
@@ -301,7 +300,7 @@ void Cubic::cubicReduction(TimePoint lossTime) noexcept {
   lossCwndBytes_ = cwndBytes_;
   lossSsthresh_ = ssthresh_;
   cwndBytes_ = boundedCwnd(
-      cwndBytes_ * steadyState_.reductionFactor,
+      cwndBytes_ * reductionFactor,
       conn_.udpSendPacketLen,
       conn_.transportSettings.maxCwndInMss,
       conn_.transportSettings.minCwndInMss);
@@ -326,6 +325,59 @@ void Cubic::onPacketAckOrLoss(
   if (ackEvent && ackEvent->largestNewlyAckedPacket.has_value()) {
     //CHECK(!ackEvent->ackedPackets.empty());
     onPacketAcked(*ackEvent);
+    if (ackEvent->ecnCEMarkedPackets > 0) {
+      onCongestionExperienced(*ackEvent);
+    }
+  }
+}
+
+void Cubic::onCongestionExperienced(const AckEvent& ack) {
+  // Like losses, CE marks reduce the cwnd at most once per round trip.
+  if (recoveryState_.endOfRecovery.has_value() &&
+      *recoveryState_.endOfRecovery >= ack.largestNewlyAckedPacketSentTime) {
+    return;
+  }
+  const auto& ecnState = conn_.ecnState;
+  if (ecnState.isL4s() && state_ == CubicStates::Hystart &&
+      ecnState.ceMarkedPacketsInRound <=
+          ecnState.ackedPacketsInRound * kCubicL4sSlowStartCeThreshold) {
+    // Paced slow start sends faster than the bottleneck for a while before
+    // the window reaches the BDP, so a few marks don't mean it is full yet.
+    return;
+  }
+  quiescenceStart_.reset();
+  recoveryState_.endOfRecovery = Clock::now();
+  if (ecnState.isL4s()) {
+    // Prague: the cut is proportional to the fraction of packets marked, so
+    // a shallow marking threshold keeps the queue short without starving the
+    // flow. The cuts are frequent and small, so W_max isn't lowered further.
+    // Slow start ends on a round mostly marked, which alpha may not show yet.
+    auto alpha = ecnState.l4sAlpha;
+    if (state_ == CubicStates::Hystart) {
+      alpha = std::max(alpha,
+          static_cast<double>(ecnState.ceMarkedPacketsInRound) /
+              static_cast<double>(ecnState.ackedPacketsInRound));
+    }
+    cubicReduction(ack.ackTime, static_cast<float>(1 - alpha / 2), false);
+  } else {
+    // Classic ECN: a CE mark is a loss (RFC 9002 section 7.1).
+    cubicReduction(ack.ackTime, steadyState_.reductionFactor, true);
+  }
+  if (state_ == CubicStates::Hystart || state_ == CubicStates::Steady) {
+    state_ = CubicStates::FastRecovery;
+  }
+  hystartState_.cssBaselineMinRtt.reset();
+  ssthresh_ = cwndBytes_;
+  if (conn_.pacer) {
+    conn_.pacer->refreshPacingRate(
+        cwndBytes_ * pacingGain(), conn_.lossState.srtt);
+  }
+  if (conn_.qLogger) {
+    conn_.qLogger->addCongestionMetricUpdate(
+        conn_.lossState.inflightBytes,
+        getCongestionWindow(),
+        kCubicCongestionExperienced,
+        cubicStateToString(state_).str());
   }
 }
 
@@ -400,7 +452,10 @@ CongestionControlType Cubic::type() const noexcept {
 float Cubic::pacingGain() const noexcept {
   double pacingGain = 1.0f;
   if (state_ == CubicStates::Hystart) {
-    pacingGain = kCubicHystartPacingGain;
+    // Conservative slow start grows by a quarter per round, not doubles.
+    pacingGain = hystartState_.cssBaselineMinRtt
+        ? kCubicConservativeSlowStartPacingGain
+        : kCubicHystartPacingGain;
   } else if (state_ == CubicStates::FastRecovery) {
     pacingGain = kCubicRecoveryPacingGain;
   }
@@ -420,15 +475,34 @@ void Cubic::onPacketAckedInHystart(const AckEvent& ack) {
     throw QuicInternalException(
         "Cubic Hystart: cwnd overflow", LocalErrorCode::CWND_OVERFLOW);
   }
-  //VLOG(15) << "Cubic Hystart increase cwnd=" << cwndBytes_ << ", by " << ack.ackedBytes;
+  auto increase = ack.ackedBytes;
+  if (conn_.transportSettings.cubicConfig.hystartPlusPlus) {
+    // Unpaced, a large ACK would otherwise release a burst of twice its size.
+    if (!isConnectionPaced(conn_)) {
+      increase = std::min(
+          increase, kHystartUnpacedAckIncreaseInMss * conn_.udpSendPacketLen);
+    }
+    if (hystartState_.cssBaselineMinRtt) {
+      increase /= kCssGrowthDivisor;
+    }
+  }
+  //VLOG(15) << "Cubic Hystart increase cwnd=" << cwndBytes_ << ", by " << increase;
   cwndBytes_ = boundedCwnd(
-      cwndBytes_ + ack.ackedBytes,
+      cwndBytes_ + increase,
       conn_.udpSendPacketLen,
       conn_.transportSettings.maxCwndInMss,
       conn_.transportSettings.minCwndInMss);
 
   folly::Optional<Cubic::ExitReason> exitReason;
   SCOPE_EXIT {
+    // HyStart++ leaves conservative slow start at the end of its kCssRounds
+    // round.
+    if (hystartState_.cssBaselineMinRtt &&
+        ack.largestNewlyAckedPacketSentTime >
+            hystartState_.rttRoundEndTarget &&
+        ++hystartState_.cssRounds >= kCssRounds) {
+      exitReason = Cubic::ExitReason::EXITPOINT;
+    }
     if (hystartState_.found != Cubic::HystartFound::No &&
         cwndBytes_ >= kLowSsthreshInMss * conn_.udpSendPacketLen) {
       exitReason = Cubic::ExitReason::EXITPOINT;
@@ -449,6 +523,7 @@ void Cubic::onPacketAckedInHystart(const AckEvent& ack) {
        * sampled RTT as the lastSampledRtt:
        */
       hystartState_.currSampledRtt.reset();
+      hystartState_.cssBaselineMinRtt.reset();
       steadyState_.lastMaxCwndBytes.reset();
       steadyState_.lastReductionTime.reset();
       quiescenceStart_.reset();
@@ -491,6 +566,11 @@ void Cubic::onPacketAckedInHystart(const AckEvent& ack) {
       }
     }
   }
+  if (hystartState_.found == Cubic::HystartFound::No &&
+      conn_.transportSettings.cubicConfig.hystartPlusPlus) {
+    onHystartPlusPlusRttSample();
+    return;
+  }
   // If AckTrain wasn't used or didn't find the exit point, continue with
   // DelayIncrease.
   if (hystartState_.found == Cubic::HystartFound::No) {
@@ -539,6 +619,45 @@ void Cubic::onPacketAckedInHystart(const AckEvent& ack) {
   }
 }
 
+/**
+ * HyStart++ (RFC 9406): rather than leaving slow start on the first RTT
+ * increase, enter conservative slow start (CSS), which grows cwnd a quarter as
+ * fast. If a later round's min RTT drops below the one CSS was entered with,
+ * the increase was spurious, e.g. jitter, and slow start resumes. Otherwise
+ * the exit point is found after kCssRounds rounds, see
+ * onPacketAckedInHystart. This keeps slow start from overshooting deep
+ * buffers by a whole cwnd, while a noisy RTT doesn't end it too early.
+ */
+void Cubic::onHystartPlusPlusRttSample() noexcept {
+  if (hystartState_.ackCount >= kAckSampling) {
+    // Only the first kAckSampling ACKs of a round are compared.
+    return;
+  }
+  hystartState_.currSampledRtt = std::min(
+      conn_.lossState.lrtt,
+      hystartState_.currSampledRtt.value_or(conn_.lossState.lrtt));
+  if (++hystartState_.ackCount < kAckSampling ||
+      !hystartState_.lastSampledRtt) {
+    return;
+  }
+  if (hystartState_.cssBaselineMinRtt) {
+    if (*hystartState_.currSampledRtt < *hystartState_.cssBaselineMinRtt) {
+      hystartState_.cssBaselineMinRtt.reset();
+    }
+    return;
+  }
+  auto rttThresh = std::clamp(
+      *hystartState_.lastSampledRtt /
+          static_cast<int64_t>(kHystartPlusPlusRttThreshDivisor),
+      kDelayIncreaseLowerBound,
+      kDelayIncreaseUpperBound);
+  if (*hystartState_.currSampledRtt >=
+      *hystartState_.lastSampledRtt + rttThresh) {
+    hystartState_.cssBaselineMinRtt = hystartState_.currSampledRtt;
+    hystartState_.cssRounds = 0;
+  }
+}
+
 /**
  * Note: The Cubic paper, and linux/chromium implementation differ on the
  * definition of "time to origin", or the variable K in the paper. In the paper,
@@ -681,6 +800,49 @@ void Cubic::getStats(CongestionControllerStats& stats) const {
   }
 }
 
+folly::Optional<CongestionControllerSnapshot> Cubic::snapshot() const {
+  CongestionControllerSnapshot snapshot;
+  snapshot.type = type();
+  snapshot.cwndBytes = cwndBytes_;
+  snapshot.state = static_cast<uint8_t>(state_);
+  snapshot.ssthreshBytes = ssthresh_;
+  snapshot.lastMaxCwndBytes = steadyState_.lastMaxCwndBytes;
+  snapshot.lastReductionTime = steadyState_.lastReductionTime;
+  snapshot.estRenoCwndBytes = steadyState_.estRenoCwnd;
+  return snapshot;
+}
+
+bool Cubic::restore(const CongestionControllerSnapshot& snapshot) {
+  if (snapshot.type != type() || snapshot.cwndBytes == 0) {
+    return false;
+  }
+  cwndBytes_ = boundedCwnd(
+      snapshot.cwndBytes,
+      conn_.udpSendPacketLen,
+      conn_.transportSettings.maxCwndInMss,
+      conn_.transportSettings.minCwndInMss);
+  ssthresh_ = snapshot.ssthreshBytes;
+  // Recovery would end with the ACK of a packet sent after it started, which
+  // the new connection state has no record of, so go on from the window
+  // recovery settled on.
+  state_ = cwndBytes_ < ssthresh_ ? CubicStates::Hystart : CubicStates::Steady;
+  hystartState_.inRttRound = false;
+  recoveryState_.endOfRecovery.reset();
+  lossCwndBytes_.reset();
+  lossSsthresh_.reset();
+  quiescenceStart_.reset();
+  steadyState_.lastMaxCwndBytes = snapshot.lastMaxCwndBytes;
+  steadyState_.lastReductionTime = snapshot.lastReductionTime;
+  steadyState_.estRenoCwnd = snapshot.estRenoCwndBytes;
+  // Recalculated from lastMaxCwndBytes on the next ACK.
+  steadyState_.originPoint.reset();
+  if (conn_.pacer) {
+    conn_.pacer->refreshPacingRate(
+        cwndBytes_ * pacingGain(), conn_.lossState.srtt);
+  }
+  return true;
+}
+
 folly::StringPiece cubicStateToString(CubicStates state) {
   switch (state) {
     case CubicStates::Steady:
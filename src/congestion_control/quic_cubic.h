@@ -18,6 +18,7 @@
 namespace quic {
 
 constexpr float kCubicHystartPacingGain = 2.0f;
+constexpr float kCubicConservativeSlowStartPacingGain = 1.25f;
 constexpr float kCubicRecoveryPacingGain = 1.25f;
 
 enum class CubicStates : uint8_t {
@@ -45,7 +46,7 @@ enum class CubicStates : uint8_t {
  *
  */
 
-class Cubic : public CongestionController {
+class Cubic final : public CongestionController {
 public:
     static constexpr uint64_t INIT_SSTHRESH = std::numeric_limits<uint64_t>::max();
     /**
@@ -80,8 +81,16 @@ public:
     void onRemoveBytesFromInflight(uint64_t) override;
     void onPacketSent(const OutstandingPacketWrapper& packet) override;
 
-    uint64_t getWritableBytes() const noexcept override;
-    uint64_t getCongestionWindow() const noexcept override;
+    // Defined here so that devirtualized calls inline, see
+    // CongestionControllerPtr::visit().
+    uint64_t getWritableBytes() const noexcept override {
+        return cwndBytes_ > conn_.lossState.inflightBytes ? cwndBytes_ - conn_.lossState.inflightBytes : 0;
+    }
+
+    uint64_t getCongestionWindow() const noexcept override {
+        return cwndBytes_;
+    }
+
     void setAppIdle(bool idle, TimePoint eventTime) noexcept override;
     void setAppLimited() override;
 
@@ -103,6 +112,10 @@ public:
         experimental_ = experimental;
     }
 
+    [[nodiscard]] folly::Optional<CongestionControllerSnapshot> snapshot() const override;
+
+    bool restore(const CongestionControllerSnapshot& snapshot) override;
+
 protected:
     CubicStates state_{CubicStates::Hystart};
 
@@ -116,12 +129,14 @@ private:
     void onPacketLoss(const LossEvent& loss);
     void onPacketLossInRecovery(const LossEvent& loss);
     void onPersistentCongestion();
+    void onCongestionExperienced(const AckEvent& ack);
 
     float pacingGain() const noexcept;
 
     void startHystartRttRound(TimePoint time) noexcept;
+    void onHystartPlusPlusRttSample() noexcept;
 
-    void cubicReduction(TimePoint lossTime) noexcept;
+    void cubicReduction(TimePoint lossTime, float reductionFactor, bool fastConvergence) noexcept;
     void updateTimeToOrigin() noexcept;
     int64_t calculateCubicCwndDelta(TimePoint timePoint) noexcept;
     uint64_t calculateCubicCwnd(int64_t delta) noexcept;
@@ -159,6 +174,11 @@ private:
         // When a packet with sent time >= rttRoundEndTarget is acked, end the
         // current RTT round
         TimePoint rttRoundEndTarget;
+        // HyStart++: the round's min RTT when conservative slow start was
+        // entered, set while in it.
+        folly::Optional<std::chrono::microseconds> cssBaselineMinRtt;
+        // HyStart++: rounds completed in conservative slow start
+        uint8_t cssRounds{0};
     };
 
     struct SteadyState {
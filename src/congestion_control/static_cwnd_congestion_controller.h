@@ -23,7 +23,7 @@ namespace quic {
  * Although capable of being used in production, intended to be used for
  * testing and experiments.
  */
-struct StaticCwndCongestionController : public CongestionController {
+struct StaticCwndCongestionController final : public CongestionController {
     /**
      * Helper struct to make it clear that CWND should be passed in # of bytes.
      */
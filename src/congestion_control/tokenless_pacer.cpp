@@ -31,7 +31,7 @@ void TokenlessPacer::refreshPacingRate(
       : cwndBytes * 1s / rtt;
   if (targetRateBytesPerSec > maxPacingRateBytesPerSec_) {
     return setPacingRate(maxPacingRateBytesPerSec_);
-  } else if (rtt < conn_.transportSettings.pacingTickInterval) {
+  } else if (rtt < pacingTickInterval(conn_)) {
     writeInterval_ = 0us;
     batchSize_ = conn_.transportSettings.writeConnectionDataPacketsLimit;
   } else {
@@ -58,14 +58,13 @@ void TokenlessPacer::setPacingRate(uint64_t rateBps) {
 
   if (rateBps == 0) {
     batchSize_ = 0;
-    writeInterval_ = conn_.transportSettings.pacingTickInterval;
+    writeInterval_ = pacingTickInterval(conn_);
   } else {
     batchSize_ = conn_.transportSettings.writeConnectionDataPacketsLimit;
     uint64_t interval =
         (batchSize_ * conn_.udpSendPacketLen * 1000000) / rateBps;
     writeInterval_ = std::max(
-        std::chrono::microseconds(interval),
-        conn_.transportSettings.pacingTickInterval);
+        std::chrono::microseconds(interval), pacingTickInterval(conn_));
   }
 
   if (conn_.qLogger) {
@@ -115,8 +114,7 @@ std::chrono::microseconds TokenlessPacer::getTimeUntilNextWrite(
     return 0us;
   }
   return std::max(
-      writeInterval_ - timeSinceLastWrite,
-      conn_.transportSettings.pacingTickInterval);
+      writeInterval_ - timeSinceLastWrite, pacingTickInterval(conn_));
 }
 
 uint64_t TokenlessPacer::updateAndGetWriteBatchSize(TimePoint currentTime) {
@@ -157,4 +155,27 @@ void TokenlessPacer::setPacingRateCalculator(
 void TokenlessPacer::setExperimental(bool experimental) {
   experimental_ = experimental;
 }
+
+folly::Optional<PacerSnapshot> TokenlessPacer::snapshot() const {
+  PacerSnapshot snapshot;
+  snapshot.batchSize = batchSize_;
+  snapshot.writeInterval = writeInterval_;
+  snapshot.maxPacingRateBytesPerSec = maxPacingRateBytesPerSec_;
+  snapshot.rttFactorNumerator = rttFactorNumerator_;
+  snapshot.rttFactorDenominator = rttFactorDenominator_;
+  return snapshot;
+}
+
+bool TokenlessPacer::restore(const PacerSnapshot& snapshot) {
+  if (snapshot.batchSize == 0 || snapshot.rttFactorDenominator == 0) {
+    return false;
+  }
+  batchSize_ = snapshot.batchSize;
+  writeInterval_ = snapshot.writeInterval;
+  maxPacingRateBytesPerSec_ = snapshot.maxPacingRateBytesPerSec;
+  rttFactorNumerator_ = snapshot.rttFactorNumerator;
+  rttFactorDenominator_ = snapshot.rttFactorDenominator;
+  lastWriteTime_.reset();
+  return true;
+}
 } // namespace quic
@@ -48,6 +48,10 @@ class TokenlessPacer : public Pacer {
 
   void setExperimental(bool experimental) override;
 
+  [[nodiscard]] folly::Optional<PacerSnapshot> snapshot() const override;
+
+  bool restore(const PacerSnapshot& snapshot) override;
+
  private:
   const QuicConnectionStateBase& conn_;
   uint64_t minCwndInMss_;
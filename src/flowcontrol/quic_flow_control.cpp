@@ -10,6 +10,7 @@
 #include "protocol/quic_exception.h"
 #include "logging/qlogger.h"
 #include "state/stream_data.h"
+#include "state/shard_memory_accountant.h"
 
 #include <limits>
 
@@ -17,18 +18,19 @@ namespace quic {
 namespace {
 folly::Optional<uint64_t> calculateNewWindowUpdate(uint64_t curReadOffset, uint64_t curAdvertisedOffset,
     uint64_t windowSize, const std::chrono::microseconds& srtt, const TransportSettings& transportSettings,
-    const folly::Optional<TimePoint>& lastSendTime, const TimePoint& updateTime) {
+    bool autotune, const folly::Optional<TimePoint>& lastSendTime, const TimePoint& updateTime) {
 
     //DCHECK_LE(curReadOffset, curAdvertisedOffset);
     auto nextAdvertisedOffset = curReadOffset + windowSize;
-    if (nextAdvertisedOffset == curAdvertisedOffset) {
-        // No change in flow control
+    if (nextAdvertisedOffset <= curAdvertisedOffset) {
+        // No change in flow control, or the window shrank under memory pressure
+        // and we can't take back what was advertised.
         return folly::none;
     }
     bool enoughTimeElapsed = lastSendTime && updateTime > *lastSendTime &&
         (updateTime - *lastSendTime) > transportSettings.flowControlRttFrequency * srtt;
     // If we are autotuning then frequent updates aren't required.
-    if (enoughTimeElapsed && !transportSettings.autotuneReceiveConnFlowControl) {
+    if (enoughTimeElapsed && !autotune) {
         return nextAdvertisedOffset;
     }
     bool enoughWindowElapsed = (curAdvertisedOffset - curReadOffset) * transportSettings.flowControlWindowFrequency < windowSize;
@@ -54,23 +56,57 @@ inline void decrementWithOverFlowCheck(T& num, T diff) {
     num -= diff;
 }
 
-inline uint64_t calculateMaximumData(const QuicStreamState& stream) {
-    return std::max(stream.currentReadOffset + stream.flowControlState.windowSize, stream.flowControlState.advertisedMaxOffset);
+// The receive window to advertise, shrunk while the shard is short of memory.
+inline uint64_t advertisedWindowSize(uint64_t windowSize) {
+    return ShardMemoryAccountant::getThreadLocalInstance().scaleReceiveWindow(windowSize);
 }
 
-} // namespace
+inline uint64_t calculateMaximumData(const QuicStreamState& stream) {
+    return std::max(stream.currentReadOffset + advertisedWindowSize(stream.flowControlState.windowSize),
+        stream.flowControlState.advertisedMaxOffset);
+}
 
-void maybeIncreaseConnectionFlowControlWindow(QuicConnectionStateBase::ConnectionFlowControlState& flowControlState,
-    TimePoint updateTime, std::chrono::microseconds srtt) {
-    if (!flowControlState.timeOfLastFlowControlUpdate || srtt == 0us) {
+// Grows windowSize to a multiple of the receive BDP, where the peer's send
+// rate is bytesReceived over the time since the last flow control update.
+// A window limited peer sends about half a window between updates, so this
+// keeps doubling the window until the peer is no longer limited by it.
+void increaseWindowToBdp(uint64_t& windowSize, uint64_t bytesReceived, TimePoint updateTime,
+    const folly::Optional<TimePoint>& lastUpdateTime, std::chrono::microseconds srtt, uint64_t maxWindowSize) {
+    if (!lastUpdateTime || srtt == 0us || updateTime <= *lastUpdateTime) {
         return;
     }
-    //CHECK(updateTime > *flowControlState.timeOfLastFlowControlUpdate);
-    if (std::chrono::duration_cast<decltype(srtt)>(updateTime - *flowControlState.timeOfLastFlowControlUpdate) < 2 * srtt) {
-        flowControlState.windowSize *= 2;
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(updateTime - *lastUpdateTime);
+    if (elapsed == 0us) {
+        return;
+    }
+    long double bdp = static_cast<long double>(bytesReceived) * srtt.count() / elapsed.count();
+    long double targetWindow = bdp * kFlowControlWindowBdpMultiplier;
+    auto newWindowSize = targetWindow >= static_cast<long double>(maxWindowSize)
+        ? maxWindowSize : static_cast<uint64_t>(targetWindow);
+    if (newWindowSize > windowSize) {
+        windowSize = newWindowSize;
     }
 }
 
+} // namespace
+
+void maybeIncreaseConnectionFlowControlWindow(QuicConnectionStateBase::ConnectionFlowControlState& flowControlState,
+    TimePoint updateTime, std::chrono::microseconds srtt, uint64_t maxWindowSize) {
+    increaseWindowToBdp(flowControlState.windowSize,
+        flowControlState.sumMaxObservedOffset - flowControlState.sumMaxObservedOffsetAtLastUpdate,
+        updateTime, flowControlState.timeOfLastFlowControlUpdate, srtt, maxWindowSize);
+}
+
+void maybeIncreaseStreamFlowControlWindow(QuicStreamState& stream, TimePoint updateTime) {
+    auto& flowControlState = stream.flowControlState;
+    // A stream can't usefully have more credit than the whole connection.
+    auto maxWindowSize = std::min(
+        stream.conn.transportSettings.totalBufferSpaceAvailable, stream.conn.flowControlState.windowSize);
+    increaseWindowToBdp(flowControlState.windowSize,
+        stream.maxOffsetObserved - flowControlState.maxOffsetObservedAtLastUpdate,
+        updateTime, flowControlState.timeOfLastFlowControlUpdate, stream.conn.lossState.srtt, maxWindowSize);
+}
+
 bool maybeSendConnWindowUpdate(QuicConnectionStateBase& conn, TimePoint updateTime) {
     if (conn.pendingEvents.connWindowUpdate) {
         // There is a pending flow control event already, and no point sending
@@ -79,8 +115,9 @@ bool maybeSendConnWindowUpdate(QuicConnectionStateBase& conn, TimePoint updateTi
     }
     auto& flowControlState = conn.flowControlState;
     auto newAdvertisedOffset = calculateNewWindowUpdate(flowControlState.sumCurReadOffset,
-        flowControlState.advertisedMaxOffset, flowControlState.windowSize, conn.lossState.srtt,
-        conn.transportSettings, flowControlState.timeOfLastFlowControlUpdate, updateTime);
+        flowControlState.advertisedMaxOffset, advertisedWindowSize(flowControlState.windowSize), conn.lossState.srtt,
+        conn.transportSettings, conn.transportSettings.autotuneReceiveConnFlowControl,
+        flowControlState.timeOfLastFlowControlUpdate, updateTime);
     if (newAdvertisedOffset) {
         conn.pendingEvents.connWindowUpdate = true;
         QUIC_STATS(conn.statsCallback, onConnFlowControlUpdate);
@@ -90,7 +127,9 @@ bool maybeSendConnWindowUpdate(QuicConnectionStateBase& conn, TimePoint updateTi
         }
         
         if (conn.transportSettings.autotuneReceiveConnFlowControl) {
-            maybeIncreaseConnectionFlowControlWindow(flowControlState, updateTime, conn.lossState.srtt);
+            maybeIncreaseConnectionFlowControlWindow(flowControlState, updateTime, conn.lossState.srtt,
+                std::max(conn.transportSettings.totalBufferSpaceAvailable,
+                    conn.transportSettings.advertisedInitialConnectionWindowSize));
         }
         return true;
     }
@@ -106,13 +145,17 @@ bool maybeSendStreamWindowUpdate(QuicStreamState& stream, TimePoint updateTime)
         return false;
     }
     auto newAdvertisedOffset = calculateNewWindowUpdate(stream.currentReadOffset,
-        flowControlState.advertisedMaxOffset, flowControlState.windowSize,
+        flowControlState.advertisedMaxOffset, advertisedWindowSize(flowControlState.windowSize),
         stream.conn.lossState.srtt, stream.conn.transportSettings,
+        stream.conn.transportSettings.autotuneReceiveStreamFlowControl,
         flowControlState.timeOfLastFlowControlUpdate, updateTime);
     if (newAdvertisedOffset) {
         //VLOG(10) << "Queued flow control update for stream=" << stream.id << " offset=" << *newAdvertisedOffset;
         stream.conn.streamManager->queueWindowUpdate(stream.id);
         QUIC_STATS(stream.conn.statsCallback, onStreamFlowControlUpdate);
+        if (stream.conn.transportSettings.autotuneReceiveStreamFlowControl) {
+            maybeIncreaseStreamFlowControlWindow(stream, updateTime);
+        }
         return true;
     }
     return false;
@@ -306,6 +349,7 @@ void onConnWindowUpdateSent(QuicConnectionStateBase& conn, uint64_t maximumDataS
     //DCHECK_GE(maximumDataSent, conn.flowControlState.advertisedMaxOffset);
     conn.flowControlState.advertisedMaxOffset = maximumDataSent;
     conn.flowControlState.timeOfLastFlowControlUpdate = sentTime;
+    conn.flowControlState.sumMaxObservedOffsetAtLastUpdate = conn.flowControlState.sumMaxObservedOffset;
     conn.pendingEvents.connWindowUpdate = false;
     //VLOG(4) << "sent window for conn";
 }
@@ -313,6 +357,7 @@ void onConnWindowUpdateSent(QuicConnectionStateBase& conn, uint64_t maximumDataS
 void onStreamWindowUpdateSent(QuicStreamState& stream, uint64_t maximumDataSent, TimePoint sentTime) {
     stream.flowControlState.advertisedMaxOffset = maximumDataSent;
     stream.flowControlState.timeOfLastFlowControlUpdate = sentTime;
+    stream.flowControlState.maxOffsetObservedAtLastUpdate = stream.maxOffsetObserved;
     stream.conn.streamManager->removeWindowUpdate(stream.id);
     //VLOG(4) << "sent window for stream=" << stream.id;
 }
@@ -351,7 +396,7 @@ void updateFlowControlStateWithSettings(
 
 MaxDataFrame generateMaxDataFrame(const QuicConnectionStateBase& conn) {
     return MaxDataFrame(std::max(
-        conn.flowControlState.sumCurReadOffset + conn.flowControlState.windowSize,
+        conn.flowControlState.sumCurReadOffset + advertisedWindowSize(conn.flowControlState.windowSize),
         conn.flowControlState.advertisedMaxOffset));
 }
 
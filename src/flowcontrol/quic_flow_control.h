@@ -13,10 +13,22 @@
 
 namespace quic {
 
+/**
+ * Grows the connection receive window towards twice the receive BDP, the
+ * peer's send rate since the last flow control update times srtt. The window
+ * never shrinks and does not grow past maxWindowSize.
+ */
 void maybeIncreaseConnectionFlowControlWindow(
     QuicConnectionStateBase::ConnectionFlowControlState& flowControlState,
     TimePoint updateTime,
-    std::chrono::microseconds srtt);
+    std::chrono::microseconds srtt,
+    uint64_t maxWindowSize);
+
+/**
+ * Same as above for a stream's receive window, capped at the connection
+ * window and totalBufferSpaceAvailable.
+ */
+void maybeIncreaseStreamFlowControlWindow(QuicStreamState& stream, TimePoint updateTime);
 
 bool maybeSendConnWindowUpdate(QuicConnectionStateBase& conn, TimePoint updateTime);
 
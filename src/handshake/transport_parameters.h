@@ -41,7 +41,12 @@ enum class TransportParameterId : uint64_t {
     max_receive_timestamps_per_ack = 0xff0a002,
     receive_timestamps_exponent = 0xff0a003,
     stream_groups_enabled = 0x0000ff99,
-    knob_frames_supported = 0x00005178
+    knob_frames_supported = 0x00005178,
+    // Never sent to the peer, only stored in session tickets. See
+    // encodeCongestionHint().
+    congestion_hint_bandwidth = 0xff5c0001,
+    congestion_hint_min_rtt = 0xff5c0002,
+    congestion_hint_loss = 0xff5c0003
 };
 
 struct TransportParameter {
@@ -22,6 +22,7 @@ constexpr auto kPersistentCongestion = "persistent congestion";
 constexpr auto kRemoveInflight = "remove bytes in flight";
 constexpr auto kCubicSkipLoss = "cubic skip loss";
 constexpr auto kCubicLoss = "cubic loss";
+constexpr auto kCubicCongestionExperienced = "cubic congestion experienced";
 constexpr auto kCubicSteadyCwnd = "cubic steady cwnd";
 constexpr auto kCubicSkipAck = "cubic skip ack";
 constexpr auto kCubicInit = "cubic init";
@@ -60,6 +60,15 @@ void onPTOAlarm(QuicConnectionStateBase& conn) {
     throw QuicInternalException(
         "Exceeded max PTO", LocalErrorCode::CONNECTION_ABANDONED);
   }
+  // Nothing came back since marking started, something on the path may drop
+  // ECT packets. Send the rest unmarked.
+  auto& ecnState = conn.ecnState;
+  if ((ecnState.state == ECNState::AttemptingECN ||
+       ecnState.state == ECNState::AttemptingL4S) &&
+      ecnState.validatedPackets == 0 &&
+      conn.lossState.ptoCount >= kEcnValidationMaxPtos) {
+    ecnState.state = ECNState::FailedValidation;
+  }
 
   // The first PTO after the oneRttWriteCipher is available is an opportunity to
   // retransmit unacknowledged 0-rtt data. It may be done only once.
@@ -281,16 +290,29 @@ bool processOutstandingsForLoss(
     CongestionController::LossEvent& lossEvent,
     folly::Optional<SocketObserverInterface::LossEvent>& observerLossEvent) {
   bool shouldSetTimer = false;
-  auto iter = getFirstOutstandingPacket(conn, pnSpace);
-  while (iter != conn.outstandings.packets.end()) {
+  auto& packets = conn.outstandings.packets[pnSpace];
+  // Packets below the cursor were declared lost by earlier calls, and are only
+  // kept around to detect spurious loss.
+  auto& scanStart = conn.outstandings.lossScanStart[pnSpace];
+  // Without DSR packets both the send time and the reordering distance of a
+  // packet only decrease along the ring, so the lost packets are a prefix of
+  // it: the scan stops at the first packet not lost, making its cost
+  // proportional to the number of newly lost packets.
+  const bool lostPacketsArePrefix =
+      conn.outstandings.dsrCount == 0 && largestDsrAcked.empty();
+  bool advanceScanStart = true;
+  auto iter = packets.lowerBound(scanStart);
+  while (iter != packets.end()) {
     auto& pkt = *iter;
     auto currentPacketNum = pkt.packet.header.getPacketSequenceNum();
     folly::Optional<uint64_t> maybeCurrentStreamPacketIdx;
     if (currentPacketNum >= largestAcked) {
       break;
     }
-    auto currentPacketNumberSpace = pkt.packet.header.getPacketNumberSpace();
-    if (currentPacketNumberSpace != pnSpace || iter->declaredLost) {
+    if (iter->declaredLost) {
+      if (advanceScanStart) {
+        scanStart = iter.packetNum() + 1;
+      }
       iter++;
       continue;
     }
@@ -347,6 +369,10 @@ bool processOutstandingsForLoss(
 
     if (!(lostByTimeout || lostByReorder)) {
       shouldSetTimer = true;
+      if (lostPacketsArePrefix) {
+        break;
+      }
+      advanceScanStart = false;
       iter++;
       continue;
     }
@@ -360,17 +386,17 @@ bool processOutstandingsForLoss(
       --conn.outstandings.clonedPacketCount[pnSpace];
     }
     // Invoke LossVisitor if the packet doesn't have a associated PacketEvent;
-    // or if the PacketEvent is present in conn.outstandings.packetEvents.
+    // or if its clone group is still pending.
     bool processed = pkt.associatedEvent &&
-        !conn.outstandings.packetEvents.count(*pkt.associatedEvent);
+        !conn.outstandings.cloneGroups.isPending(*pkt.associatedEvent);
     lossVisitor(conn, pkt.packet, processed);
-    // Remove the PacketEvent from the outstandings.packetEvents set
+    // The clone group of the packet is now processed
     if (pkt.associatedEvent) {
-      conn.outstandings.packetEvents.erase(*pkt.associatedEvent);
+      conn.outstandings.cloneGroups.markProcessed(*pkt.associatedEvent);
     }
     if (!processed) {
-      //CHECK(conn.outstandings.packetCount[currentPacketNumberSpace]);
-      --conn.outstandings.packetCount[currentPacketNumberSpace];
+      //CHECK(conn.outstandings.packetCount[pnSpace]);
+      --conn.outstandings.packetCount[pnSpace];
     }
     //VLOG(10) << __func__ << " lost packetNum=" << currentPacketNum<< " handshake=" << pkt.metadata.isHandshake << " " << conn;
     // Rather than erasing here, instead mark the packet as lost so we can
@@ -378,12 +404,13 @@ bool processOutstandingsForLoss(
     conn.lossState.totalPacketsMarkedLost++;
     if (lostByTimeout && rttSample.count() > 0) {
       conn.lossState.totalPacketsMarkedLostByTimeout++;
-      pkt.metadata.lossTimeoutDividend = (lossTime - pkt.metadata.time) *
+      pkt.metadata.cold.getOrCreate().lossTimeoutDividend =
+          (lossTime - pkt.metadata.time) *
           conn.transportSettings.timeReorderingThreshDivisor / rttSample;
     }
     if (lostByReorder) {
       conn.lossState.totalPacketsMarkedLostByReorderingThreshold++;
-      iter->metadata.lossReorderDistance = reorderDistance;
+      pkt.metadata.cold.getOrCreate().lossReorderDistance = reorderDistance;
     }
     lossEvent.addLostPacket(pkt);
     if (observerLossEvent) {
@@ -394,6 +421,9 @@ bool processOutstandingsForLoss(
     }
     conn.outstandings.declaredLostCount++;
     iter->declaredLost = true;
+    if (advanceScanStart) {
+      scanStart = iter.packetNum() + 1;
+    }
     iter++;
   }
   return shouldSetTimer;
@@ -495,17 +525,17 @@ folly::Optional<CongestionController::LossEvent> detectLossPackets(
   }
 
   auto earliest = getFirstOutstandingPacket(conn, pnSpace);
-  for (; earliest != conn.outstandings.packets.end();
-       earliest = getNextOutstandingPacket(conn, pnSpace, earliest + 1)) {
+  for (; earliest != conn.outstandings.packets[pnSpace].end();
+       earliest = getNextOutstandingPacket(conn, pnSpace, std::next(earliest))) {
     if (!earliest->associatedEvent ||
-        conn.outstandings.packetEvents.count(*earliest->associatedEvent)) {
+        conn.outstandings.cloneGroups.isPending(*earliest->associatedEvent)) {
       break;
     }
   }
-  if (shouldSetTimer && earliest != conn.outstandings.packets.end()) {
+  if (shouldSetTimer && earliest != conn.outstandings.packets[pnSpace].end()) {
     // We are eligible to set a loss timer and there are a few packets which
     // are unacked, so we can set the early retransmit timer for them.
-    //VLOG(10) << __func__ << " early retransmit timer outstanding=" << conn.outstandings.packets.empty() << " delayUntilLost" << delayUntilLost.count() << "us" << " " << conn;
+    //VLOG(10) << __func__ << " early retransmit timer outstanding=" << conn.outstandings.empty() << " delayUntilLost" << delayUntilLost.count() << "us" << " " << conn;
     getLossTime(conn, pnSpace) = delayUntilLost + earliest->metadata.time;
   }
   if (lossEvent.largestLostPacketNum.hasValue()) {
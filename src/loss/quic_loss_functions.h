@@ -133,7 +133,7 @@ void setLossDetectionAlarm(QuicConnectionStateBase& conn, Timeout& timeout) {
    * cwnd. So we must set the loss timer so that we can write this data with the
    * slack packet space for the clones.
    */
-  if (!hasDataToWrite && conn.outstandings.packetEvents.empty() &&
+  if (!hasDataToWrite && !conn.outstandings.cloneGroups.hasPending() &&
       totalPacketsOutstanding == conn.outstandings.numClonedPackets()) {
     /*
     //VLOG(10) << __func__ << " unset alarm pure ack or processed packets only"
@@ -180,7 +180,7 @@ void setLossDetectionAlarm(QuicConnectionStateBase& conn, Timeout& timeout) {
            << " haDataToWrite=" << hasDataToWrite
            << " outstanding=" << totalPacketsOutstanding
            << " outstanding clone=" << conn.outstandings.numClonedPackets()
-           << " packetEvents=" << conn.outstandings.packetEvents.size()
+           << " pending clone groups=" << conn.outstandings.cloneGroups.numPending()
            << " initialPackets="
            << conn.outstandings.packetCount[PacketNumberSpace::Initial]
            << " handshakePackets="
@@ -230,7 +230,7 @@ void onLossDetectionAlarm(
     QuicConnectionStateBase& conn,
     const LossVisitor& lossVisitor) {
   auto now = ClockType::now();
-  if (conn.outstandings.packets.empty()) {
+  if (conn.outstandings.empty()) {
     //VLOG(10) << "Transmission alarm fired with no outstanding packets " << conn;
     return;
   }
@@ -290,8 +290,9 @@ void markZeroRttPacketsLost(
     QuicConnectionStateBase& conn,
     const LossVisitor& lossVisitor) {
   CongestionController::LossEvent lossEvent(ClockType::now());
+  auto& appDataPackets = conn.outstandings.packets[PacketNumberSpace::AppData];
   auto iter = getFirstOutstandingPacket(conn, PacketNumberSpace::AppData);
-  while (iter != conn.outstandings.packets.end()) {
+  while (iter != appDataPackets.end()) {
     //DCHECK_EQ(iter->packet.header.getPacketNumberSpace(), PacketNumberSpace::AppData);
     auto isZeroRttPacket =
         iter->packet.header.getProtectionType() == ProtectionType::ZeroRtt;
@@ -299,11 +300,12 @@ void markZeroRttPacketsLost(
       auto& pkt = *iter;
       //DCHECK(!pkt.metadata.isHandshake);
       bool processed = pkt.associatedEvent &&
-          !conn.outstandings.packetEvents.count(*pkt.associatedEvent);
+          !conn.outstandings.cloneGroups.isPending(*pkt.associatedEvent);
       lossVisitor(conn, pkt.packet, processed);
-      // Remove the PacketEvent from the outstandings.packetEvents set
+      // The packet leaves the outstandings, and its clone group is processed
       if (pkt.associatedEvent) {
-        conn.outstandings.packetEvents.erase(*pkt.associatedEvent);
+        conn.outstandings.cloneGroups.markProcessed(*pkt.associatedEvent);
+        conn.outstandings.cloneGroups.release(*pkt.associatedEvent);
         //CHECK(conn.outstandings.clonedPacketCount[PacketNumberSpace::AppData]);
         --conn.outstandings.clonedPacketCount[PacketNumberSpace::AppData];
       }
@@ -312,11 +314,11 @@ void markZeroRttPacketsLost(
         //CHECK(conn.outstandings.packetCount[PacketNumberSpace::AppData]);
         --conn.outstandings.packetCount[PacketNumberSpace::AppData];
       }
-      iter = conn.outstandings.packets.erase(iter);
+      iter = appDataPackets.erase(iter);
       iter = getNextOutstandingPacket(conn, PacketNumberSpace::AppData, iter);
     } else {
-      iter =
-          getNextOutstandingPacket(conn, PacketNumberSpace::AppData, iter + 1);
+      iter = getNextOutstandingPacket(
+          conn, PacketNumberSpace::AppData, std::next(iter));
     }
   }
   conn.lossState.rtxCount += lossEvent.lostPackets;
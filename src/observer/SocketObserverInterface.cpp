@@ -11,7 +11,7 @@
 namespace quic {
 
 SocketObserverInterface::WriteEvent::Builder&&
-SocketObserverInterface::WriteEvent::Builder::setOutstandingPackets(const std::deque<OutstandingPacketWrapper>& outstandingPacketsIn) {
+SocketObserverInterface::WriteEvent::Builder::setOutstandingPackets(const OutstandingPacketRings& outstandingPacketsIn) {
     maybeOutstandingPacketsRef = outstandingPacketsIn;
     return std::move(*this);
 }
@@ -59,7 +59,7 @@ SocketObserverInterface::WriteEvent::WriteEvent(const WriteEvent::BuilderFields&
         maybeWritableBytes(builderFields.maybeWritableBytes) {}
 
 SocketObserverInterface::AppLimitedEvent::Builder&&
-SocketObserverInterface::AppLimitedEvent::Builder::setOutstandingPackets(const std::deque<OutstandingPacketWrapper>& outstandingPacketsIn) {
+SocketObserverInterface::AppLimitedEvent::Builder::setOutstandingPackets(const OutstandingPacketRings& outstandingPacketsIn) {
     maybeOutstandingPacketsRef = outstandingPacketsIn;
     return std::move(*this);
 }
@@ -108,94 +108,39 @@ SocketObserverInterface::AppLimitedEvent::AppLimitedEvent(
 
 void SocketObserverInterface::PacketsWrittenEvent::
     invokeForEachNewOutstandingPacketOrdered(const std::function<void(const OutstandingPacketWrapper&)>& fn) const {
-    //DCHECK_GE(outstandingPackets.size(), numAckElicitingPacketsWritten);
     if (numAckElicitingPacketsWritten == 0) {
         return; // nothing to do
     }
 
-    // The packets in the OutstandingPackets deque are sorted by their sequence
-    // nunber in their packet number space. As a result, the N packets at the end
-    // of the deque may not be the N most recently sent OutstandingPacketss.
-    // Furthermore, adjacent OutstandingPackets may have the same sequence
-    // number because they belong to different packet number spaces. Because
-    // packets in the deque are sorted only by sequence number, the ith packet
-    // in the deque may have actually been sent after the i+1th packet.
-    //
-    // However, the deque will typically only contain AppData packets, and thus
-    // we can expect that the last N elements in the deque will typically be the
-    // N most recently sent OutstandingPackets. We use this to avoid needing to
-    // scan the queue when the following is true:
-    //
-    //    (1) If the writeCount of the OutstandingPacketWrapper N packets from the
-    //    end of
-    //        the deque has a writeCount equal to that reported by this event, and
-    //    (2) If when scanning from the OutstandingPacketWrapper N packets from
-    //    the end
-    //        of the deque to the end of the deque, the numAckElicitingPacketsSent
-    //        recorded for each OutstandingPacketWrapper is one larger than that
-    //        of the previous OutstandingPacketWrapper, and writeCount recorded is
-    //        equal to the writeCount reported by this event.
-    //
-    // If the above is true, then the N OutstandingPackets from the end of the
-    // deque were all sent during this write operation, and they are already
-    // ordered such that packet i was sent before packet i+1.
-    {
-        const auto startIt = outstandingPackets.end() - static_cast<int64_t>(numAckElicitingPacketsWritten);
-        bool needFullWalk = false;
-        folly::Optional<uint64_t> maybePrevNumAckElicitingPacketsSent;
-
-        for (auto it = startIt; it != outstandingPackets.end(); it++) {
-            if (writeCount != it->metadata.writeCount) {
-                needFullWalk = true;
-                break;
-            }
-
-            if (!maybePrevNumAckElicitingPacketsSent) {
-                maybePrevNumAckElicitingPacketsSent = it->metadata.totalAckElicitingPacketsSent;
-                continue;
-            }
-
-            //CHECK_NE(maybePrevNumAckElicitingPacketsSent.value(), it->metadata.totalAckElicitingPacketsSent);
-            if (maybePrevNumAckElicitingPacketsSent.value() > it->metadata.totalAckElicitingPacketsSent) {
-                needFullWalk = true;
-                break;
-            }
-        }
-
-        if (!needFullWalk) {
-            for (auto it = startIt; it != outstandingPackets.end(); it++) {
-                fn(*it);
-            }
-            return; // we're done here
-        }
-    }
-
-    // It looks like a full walk is needed.
-    //
-    // From the front of the deque, find OutstandingPackets with the writeCount
-    // reported by this event and insert references to them into a vector.
+    // Within a packet number space packets are sent in packet number order, so
+    // the packets written by this write operation sit at the tail of each ring.
+    // Walk each ring backwards until we reach a packet from an earlier write.
+    // Only when the write spanned more than one packet number space do the
+    // collected packets need to be sorted into send order.
     std::vector<std::reference_wrapper<const OutstandingPacketWrapper>> newOutstandingPackets;
     newOutstandingPackets.reserve(numAckElicitingPacketsWritten);
-    for (const auto& packet : outstandingPackets) {
-        if (packet.metadata.writeCount == writeCount) {
-            newOutstandingPackets.emplace_back(packet);
+    size_t numSpacesWritten = 0;
+    for (const auto& ring : outstandingPackets) {
+        const auto prevSize = newOutstandingPackets.size();
+        for (auto it = ring.rbegin(); it != ring.rend() && it->metadata.writeCount == writeCount; ++it) {
+            newOutstandingPackets.emplace_back(*it);
+        }
+        if (newOutstandingPackets.size() != prevSize) {
+            std::reverse(newOutstandingPackets.begin() + prevSize, newOutstandingPackets.end());
+            ++numSpacesWritten;
         }
     }
     //DCHECK_EQ(numAckElicitingPacketsWritten, newOutstandingPackets.size());
 
-    // Now sort that vector by totalAckElicitingPacketsSent.
-    std::sort(
-        std::begin(newOutstandingPackets),
-        std::end(newOutstandingPackets),
-        [](const auto& pkt1, const auto& pkt2) {
-        const auto& pkt1TotalAckElicitingPacketsSent =
-            pkt1.get().metadata.totalAckElicitingPacketsSent;
-        const auto& pkt2TotalAckElicitingPacketsSent =
-            pkt2.get().metadata.totalAckElicitingPacketsSent;
-        return pkt1TotalAckElicitingPacketsSent <
-            pkt2TotalAckElicitingPacketsSent;
-        });
-    //DCHECK_EQ(numAckElicitingPacketsWritten, newOutstandingPackets.size());
+    if (numSpacesWritten > 1) {
+        std::sort(
+            std::begin(newOutstandingPackets),
+            std::end(newOutstandingPackets),
+            [](const auto& pkt1, const auto& pkt2) {
+            return pkt1.get().metadata.totalAckElicitingPacketsSent <
+                pkt2.get().metadata.totalAckElicitingPacketsSent;
+            });
+    }
 
     // Play the sorted list
     for (const auto& packet : newOutstandingPackets) {
@@ -205,7 +150,7 @@ void SocketObserverInterface::PacketsWrittenEvent::
 
 SocketObserverInterface::PacketsWrittenEvent::Builder&&
 SocketObserverInterface::PacketsWrittenEvent::Builder::setOutstandingPackets(
-    const std::deque<OutstandingPacketWrapper>& outstandingPacketsIn) {
+    const OutstandingPacketRings& outstandingPacketsIn) {
     maybeOutstandingPacketsRef = outstandingPacketsIn;
     return std::move(*this);
 }
@@ -10,7 +10,7 @@
 #include "protocol/quic_exception.h"
 #include "common/SmallCollections.h"
 #include "state/ack_event.h"
-#include "state/outstanding_packet.h"
+#include "state/outstanding_packet_ring.h"
 #include "state/quic_stream_utilities.h"
 
 #include <utility>
@@ -80,13 +80,13 @@ public:
     };
 
     struct WriteEvent {
-        [[nodiscard]] const std::deque<OutstandingPacketWrapper>&
+        [[nodiscard]] const OutstandingPacketRings&
         getOutstandingPackets() const {
             return outstandingPackets;
         }
 
-        // Reference to the current list of outstanding packets.
-        const std::deque<OutstandingPacketWrapper>& outstandingPackets;
+        // Reference to the current outstanding packets, per packet number space.
+        const OutstandingPacketRings& outstandingPackets;
 
         // Monotonically increasing number assigned to each write operation.
         const uint64_t writeCount;
@@ -105,7 +105,7 @@ public:
         const folly::Optional<uint64_t> maybeWritableBytes;
 
         struct BuilderFields {
-            folly::Optional<std::reference_wrapper<const std::deque<OutstandingPacketWrapper>>> maybeOutstandingPacketsRef;
+            folly::Optional<std::reference_wrapper<const OutstandingPacketRings>> maybeOutstandingPacketsRef;
             folly::Optional<uint64_t> maybeWriteCount;
             folly::Optional<TimePoint> maybeLastPacketSentTime;
             folly::Optional<uint64_t> maybeCwndInBytes;
@@ -114,7 +114,7 @@ public:
         };
 
         struct Builder : public BuilderFields {
-            Builder&& setOutstandingPackets(const std::deque<OutstandingPacketWrapper>& outstandingPacketsIn);
+            Builder&& setOutstandingPackets(const OutstandingPacketRings& outstandingPacketsIn);
             Builder&& setWriteCount(const uint64_t writeCountIn);
             Builder&& setLastPacketSentTime(const TimePoint& lastPacketSentTimeIn);
             Builder&& setLastPacketSentTime(const folly::Optional<TimePoint>& maybeLastPacketSentTimeIn);
@@ -140,7 +140,7 @@ public:
 
     struct AppLimitedEvent : public WriteEvent {
         struct Builder : public WriteEvent::BuilderFields {
-            Builder&& setOutstandingPackets(const std::deque<OutstandingPacketWrapper>& outstandingPacketsIn);
+            Builder&& setOutstandingPackets(const OutstandingPacketRings& outstandingPacketsIn);
             Builder&& setWriteCount(const uint64_t writeCountIn);
             Builder&& setLastPacketSentTime(const TimePoint& lastPacketSentTimeIn);
             Builder&& setLastPacketSentTime(const folly::Optional<TimePoint>& maybeLastPacketSentTimeIn);
@@ -179,7 +179,7 @@ public:
         };
 
         struct Builder : public BuilderFields {
-            Builder&& setOutstandingPackets(const std::deque<OutstandingPacketWrapper>& outstandingPacketsIn);
+            Builder&& setOutstandingPackets(const OutstandingPacketRings& outstandingPacketsIn);
             Builder&& setWriteCount(const uint64_t writeCountIn);
             Builder&& setLastPacketSentTime(const TimePoint& lastPacketSentTimeIn);
             Builder&& setLastPacketSentTime(const folly::Optional<TimePoint>& maybeLastPacketSentTimeIn);
@@ -307,8 +307,8 @@ public:
         void addLostPacket(
             const quic::OutstandingPacketMetadata& pktMetadata, const quic::PacketNum packetNum,
             const quic::PacketNumberSpace pnSpace) {
-            lostPackets.emplace_back(pktMetadata.lossTimeoutDividend.has_value(),
-                pktMetadata.lossReorderDistance.has_value(), pktMetadata, packetNum, pnSpace);
+            lostPackets.emplace_back(pktMetadata.lossTimeoutDividend().has_value(),
+                pktMetadata.lossReorderDistance().has_value(), pktMetadata, packetNum, pnSpace);
         }
         const TimePoint lossTime;
         std::vector<LostPacket> lostPackets;
@@ -337,8 +337,8 @@ public:
 
         void addSpuriousPacket(const quic::OutstandingPacketMetadata& pktMetadata,
             const quic::PacketNum packetNum, const quic::PacketNumberSpace pnSpace) {
-            spuriousPackets.emplace_back(pktMetadata.lossTimeoutDividend.has_value(),
-                pktMetadata.lossReorderDistance.has_value(), pktMetadata, packetNum, pnSpace);
+            spuriousPackets.emplace_back(pktMetadata.lossTimeoutDividend().has_value(),
+                pktMetadata.lossReorderDistance().has_value(), pktMetadata, packetNum, pnSpace);
         }
         const TimePoint rcvTime;
         std::vector<LostPacket> spuriousPackets;
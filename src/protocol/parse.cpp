@@ -5,6 +5,8 @@
 #include <folly/Conv.h>
 #include <folly/String.h>
 
+#include <array>
+
 namespace{
     quic::PacketNum nextAckedPacketGap(quic::PacketNum packetNum, uint64_t gap) {
         // Gap cannot overflow because of the definition of quic integer encoding, so
@@ -236,17 +238,33 @@ namespace quic{
         frame.ackDelay = std::chrono::microseconds(adjustedDelay);
 
         frame.ackBlocks.emplace_back(currentPacketNum, largestAcked);
-        for (uint64_t numBlocks = 0; numBlocks < additionalAckBlocks->first; ++numBlocks) {
-            auto currentGap = decodeQuicInteger(cursor);
-            if (!currentGap) {
-                throw QuicTransportException("Bad gap", quic::TransportErrorCode::FRAME_ENCODING_ERROR, quic::FrameType::ACK);
-            }
-            auto blockLen = decodeQuicInteger(cursor);
-            if (!blockLen) {
-                throw QuicTransportException("Bad block len", quic::TransportErrorCode::FRAME_ENCODING_ERROR, quic::FrameType::ACK);
+
+        // Gap and length of each additional block. Every integer takes at least
+        // a byte, which bounds the count before anything is allocated for it.
+        if (additionalAckBlocks->first > cursor.totalLength() / 2) {
+            throw QuicTransportException("Bad ack block count", quic::TransportErrorCode::FRAME_ENCODING_ERROR, quic::FrameType::ACK);
+        }
+        const size_t numBlockFields = 2 * additionalAckBlocks->first;
+        SmallVec<uint64_t, 64> blockFields(numBlockFields);
+        // The blocks are batch decoded when they are all in the cursor's current
+        // buffer, i.e. unless the packet is chained, and integer by integer
+        // otherwise.
+        const auto contiguous = cursor.peekBytes();
+        if (auto consumed = decodeQuicIntegers(contiguous.data(), contiguous.size(), blockFields.data(), numBlockFields)) {
+            cursor.skip(*consumed);
+        } else {
+            for (size_t i = 0; i < numBlockFields; ++i) {
+                auto field = decodeQuicInteger(cursor);
+                if (!field) {
+                    throw QuicTransportException(i % 2 ? "Bad block len" : "Bad gap", quic::TransportErrorCode::FRAME_ENCODING_ERROR, quic::FrameType::ACK);
+                }
+                blockFields[i] = field->first;
             }
-            PacketNum nextEndPacket = nextAckedPacketGap(currentPacketNum, currentGap->first);
-            currentPacketNum = nextAckedPacketLen(nextEndPacket, blockLen->first);
+        }
+        frame.ackBlocks.reserve(additionalAckBlocks->first + 1);
+        for (size_t i = 0; i < numBlockFields; i += 2) {
+            PacketNum nextEndPacket = nextAckedPacketGap(currentPacketNum, blockFields[i]);
+            currentPacketNum = nextAckedPacketLen(nextEndPacket, blockFields[i + 1]);
             // We don't need to add the entry when the block length is zero since we
             // already would have processed it in the previous iteration.
             frame.ackBlocks.emplace_back(currentPacketNum, nextEndPacket);
@@ -256,9 +274,7 @@ namespace quic{
     }
 
     ReadAckFrame decodeAckFrameWithECN(folly::io::Cursor& cursor, const PacketHeader& header, const CodecParameters& params) {
-        // TODO this is incomplete
-        auto readAckFrame = decodeAckFrame(cursor, header, params);
-        // TODO we simply ignore ECN blocks in ACK-ECN frames for now.
+        auto readAckFrame = decodeAckFrame(cursor, header, params, FrameType::ACK_ECN);
         auto ect_0 = decodeQuicInteger(cursor);
         if (!ect_0) {
             throw QuicTransportException("Bad ECT(0) value", quic::TransportErrorCode::FRAME_ENCODING_ERROR, quic::FrameType::ACK_ECN);
@@ -271,6 +287,9 @@ namespace quic{
         if (!ect_ce) {
             throw QuicTransportException("Bad ECT-CE value", quic::TransportErrorCode::FRAME_ENCODING_ERROR, quic::FrameType::ACK_ECN);
         }
+        readAckFrame.ecnECT0Count = ect_0->first;
+        readAckFrame.ecnECT1Count = ect_1->first;
+        readAckFrame.ecnCECount = ect_ce->first;
         return readAckFrame;
     }
 
@@ -396,51 +415,65 @@ namespace quic{
         const quic::FrameType frameType = isGroupFrame ? quic::FrameType::GROUP_STREAM : quic::FrameType::STREAM;
         folly::io::Cursor cursor(queue.front());
 
-        auto streamId = decodeQuicInteger(cursor);
-        if (!streamId) {
-            throw QuicTransportException("Invalid stream id", quic::TransportErrorCode::FRAME_ENCODING_ERROR, frameType);
+        // The stream id and whichever of group id, offset and length are
+        // present, in wire order.
+        std::array<uint64_t, 4> fields{};
+        std::array<const char*, 4> fieldErrors{};
+        size_t numFields = 0;
+        fieldErrors[numFields++] = "Invalid stream id";
+        if (isGroupFrame) {
+            fieldErrors[numFields++] = "Invalid group stream id";
+        }
+        if (frameTypeField.hasOffset()) {
+            fieldErrors[numFields++] = "Invalid offset";
+        }
+        if (frameTypeField.hasDataLength()) {
+            fieldErrors[numFields++] = "Invalid length";
+        }
+        const auto contiguous = cursor.peekBytes();
+        if (auto consumed = decodeQuicIntegers(contiguous.data(), contiguous.size(), fields.data(), numFields)) {
+            cursor.skip(*consumed);
+        } else {
+            // The header straddles buffers, or is truncated.
+            for (size_t i = 0; i < numFields; ++i) {
+                auto field = decodeQuicInteger(cursor);
+                if (!field) {
+                    throw QuicTransportException(fieldErrors[i], quic::TransportErrorCode::FRAME_ENCODING_ERROR, frameType);
+                }
+                fields[i] = field->first;
+            }
         }
 
+        size_t fieldIndex = 0;
+        const auto streamId = fields[fieldIndex++];
         folly::Optional<StreamGroupId> groupId;
         if (isGroupFrame) {
-            auto gId = decodeQuicInteger(cursor);
-            if (!gId) {
-                throw QuicTransportException("Invalid group stream id", quic::TransportErrorCode::FRAME_ENCODING_ERROR, frameType);
-            }
-            groupId = gId->first;
+            groupId = fields[fieldIndex++];
         }
-
         uint64_t offset = 0;
         if (frameTypeField.hasOffset()) {
-            auto optionalOffset = decodeQuicInteger(cursor);
-            if (!optionalOffset) {
-                throw QuicTransportException("Invalid offset", quic::TransportErrorCode::FRAME_ENCODING_ERROR, frameType);
-            }
-            offset = optionalOffset->first;
+            offset = fields[fieldIndex++];
         }
         auto fin = frameTypeField.hasFin();
-        folly::Optional<std::pair<uint64_t, size_t>> dataLength;
+        folly::Optional<uint64_t> dataLength;
         if (frameTypeField.hasDataLength()) {
-            dataLength = decodeQuicInteger(cursor);
-            if (!dataLength) {
-                throw QuicTransportException("Invalid length", quic::TransportErrorCode::FRAME_ENCODING_ERROR, frameType);
-            }
+            dataLength = fields[fieldIndex++];
         }
         Buf data;
         if (dataLength.has_value()) {
-            if (cursor.totalLength() < dataLength->first) {
+            if (cursor.totalLength() < *dataLength) {
                 throw QuicTransportException("Length mismatch", quic::TransportErrorCode::FRAME_ENCODING_ERROR, frameType);
             }
             // If dataLength > data's actual length then the cursor will throw.
             queue.trimStart(size_t(cursor - queue.front()));
-            data = queue.splitAtMost(size_t(dataLength->first));
+            data = queue.splitAtMost(size_t(*dataLength));
         } else {
             // Missing Data Length field doesn't mean no data. It means the rest of the
             // frame are all data.
             queue.trimStart(size_t(cursor - queue.front()));
             data = queue.move();
         }
-        return ReadStreamFrame(folly::to<StreamId>(streamId->first), offset, std::move(data), fin, groupId);
+        return ReadStreamFrame(folly::to<StreamId>(streamId), offset, std::move(data), fin, groupId);
     }
 
     MaxDataFrame decodeMaxDataFrame(folly::io::Cursor& cursor) {
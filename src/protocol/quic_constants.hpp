@@ -19,8 +19,28 @@
 
 namespace quic {
 
+#ifdef QUIC_VIRTUAL_CLOCK
+// Clock set by a discrete event simulator instead of read from the system, see
+// test/congestion_control_sim.cpp. Its time points are steady_clock ones, so
+// TimePoint is the same type with either clock.
+struct VirtualClock {
+    using duration = std::chrono::steady_clock::duration;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::steady_clock::time_point;
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept {
+        return current;
+    }
+
+    static inline time_point current{};
+};
+using Clock = VirtualClock;
+#else
 using Clock = std::chrono::steady_clock;
-using TimePoint = std::chrono::time_point<Clock>;
+#endif
+using TimePoint = Clock::time_point;
 using DurationRep = std::chrono::microseconds::rep;
 using namespace std::chrono_literals;
 
@@ -71,6 +91,37 @@ constexpr uint32_t kRetryIntegrityTagLen = 16;
 constexpr uint64_t kDefaultBufferSpaceAvailable =
     std::numeric_limits<uint64_t>::max();
 
+// Default number of closed stream states a connection keeps for reuse.
+constexpr uint64_t kDefaultMaxPooledStreamStates = 16;
+
+// Bytes that all the connections on a shard may hold in stream and datagram
+// buffers before ShardMemoryAccountant pushes back. Unlimited by default.
+constexpr uint64_t kDefaultShardMemoryLimit = std::numeric_limits<uint64_t>::max();
+// Fractions of the shard memory limit at which receive windows start to shrink
+// (moderate) and application writes are refused buffer space (severe).
+constexpr double kDefaultShardMemoryModeratePressure = 0.75;
+constexpr double kDefaultShardMemorySeverePressure = 0.9;
+
+// Peer address prefixes grouping connections into a CongestionGroup, and how
+// long a group's estimates stay usable after its last report.
+constexpr uint8_t kDefaultCongestionGroupV4PrefixLen = 24;
+constexpr uint8_t kDefaultCongestionGroupV6PrefixLen = 64;
+constexpr std::chrono::seconds kDefaultCongestionGroupEstimateTtl = 30s;
+
+// Congestion hints for reconnecting clients: per shard cache size, how long a
+// hint is used, and the fewest packets a connection must have sent for its
+// estimates to be remembered.
+constexpr size_t kDefaultCongestionHintCacheSize = 16384;
+constexpr std::chrono::seconds kDefaultCongestionHintTtl = 600s;
+constexpr uint64_t kMinCongestionHintPackets = 100;
+
+// Default minimum interval between two bandwidth estimates pushed to the app,
+// and the weight of a new ACK rate sample in the smoothed delivery rate.
+constexpr std::chrono::milliseconds kDefaultBandwidthEstimateInterval = 200ms;
+// Shorter intervals are raised to this, an estimate needs a few ACKs.
+constexpr std::chrono::milliseconds kMinBandwidthEstimateInterval = 10ms;
+constexpr double kBandwidthEstimateSmoothing = 0.25;
+
 // The default min rtt to use for a new connection
 constexpr std::chrono::microseconds kDefaultMinRtt =
     std::chrono::microseconds::max();
@@ -397,6 +448,7 @@ constexpr std::string_view kCongestionControlCopaStr = "copa";
 constexpr std::string_view kCongestionControlCopa2Str = "copa2";
 constexpr std::string_view kCongestionControlNewRenoStr = "newreno";
 constexpr std::string_view kCongestionControlStaticCwndStr = "staticcwnd";
+constexpr std::string_view kCongestionControlMediaStr = "media";
 constexpr std::string_view kCongestionControlNoneStr = "none";
 
 constexpr DurationRep kPersistentCongestionThreshold = 3;
@@ -409,6 +461,7 @@ enum class CongestionControlType : uint8_t {
     BBR2,
     BBRTesting,
     StaticCwnd,
+    Media,
     None,
     // NOTE: MAX should always be at the end
     MAX
@@ -447,6 +500,17 @@ constexpr std::chrono::microseconds kDelayIncreaseUpperBound(16ms);
 // Hystart's lower bound for DelayIncrease
 constexpr std::chrono::microseconds kDelayIncreaseLowerBound(4ms);
 
+/* HyStart++ (RFC 9406): */
+// The RTT increase threshold is the last round's min RTT divided by this,
+// within the DelayIncrease bounds above
+constexpr uint64_t kHystartPlusPlusRttThreshDivisor = 8;
+// Slow start growth is divided by this in conservative slow start
+constexpr uint64_t kCssGrowthDivisor = 4;
+// Rounds of conservative slow start before congestion avoidance
+constexpr uint8_t kCssRounds = 5;
+// Limit of the cwnd increase per ACK in slow start when not paced
+constexpr uint64_t kHystartUnpacedAckIncreaseInMss = 8;
+
 /* Cubic */
 // Time elapsed scaling factor
 constexpr double kTimeScalingFactor = 0.4;
@@ -461,10 +525,32 @@ constexpr float kDefaultLastMaxReductionFactor = 0.85f;
 constexpr float kCubicTCPFriendlyEstimateIncreaseFactor =
     3 * (1 - kDefaultCubicReductionFactor) / (1 + kDefaultCubicReductionFactor);
 
+/* ECN */
+// ECN codepoints in the two low bits of the IP TOS / traffic class.
+constexpr uint8_t kEcnNotECT = 0x00;
+constexpr uint8_t kEcnECT1 = 0x01;
+constexpr uint8_t kEcnECT0 = 0x02;
+constexpr uint8_t kEcnCE = 0x03;
+// Marked packets that have to be acked with consistent ECN counts before the
+// path is considered ECN capable (RFC 9000 Appendix A.4).
+constexpr uint64_t kEcnValidationPackets = 10;
+// Marking stops if this many PTOs fire before any ECN count comes back, in
+// case something on the path drops ECT packets.
+constexpr uint64_t kEcnValidationMaxPtos = 3;
+// Weight of the CE fraction of the last round in the L4S congestion estimate
+// alpha (Prague's g).
+constexpr double kL4sAlphaGain = 1.0 / 16;
+// With L4S, Cubic's slow start ends once more than this fraction of the
+// round so far is CE marked.
+constexpr double kCubicL4sSlowStartCeThreshold = 0.5;
+
 /* Flow Control */
 // Default flow control window for HTTP/2 + 1K for headers
 constexpr uint64_t kDefaultStreamWindowSize = (64 + 1) * 1024;
 constexpr uint64_t kDefaultConnectionWindowSize = 1024 * 1024;
+// Autotuned receive windows are grown to this multiple of the receive BDP, so
+// that a window update can arrive before the peer runs out of credit.
+constexpr uint64_t kFlowControlWindowBdpMultiplier = 2;
 
 /* Stream Limits */
 constexpr uint64_t kDefaultMaxStreamsBidirectional = 2048;
@@ -128,6 +128,11 @@ namespace quic{
         folly::Optional<std::chrono::microseconds> maybeLatestRecvdPacketTime;
         folly::Optional<PacketNum> maybeLatestRecvdPacketNum;
         RecvdPacketsTimestampsRangeVec recvdPacketsTimestampRanges;
+        // Total packets the peer received with each ECN codepoint in this
+        // packet number space. Only set in ACK_ECN frames.
+        uint64_t ecnECT0Count{0};
+        uint64_t ecnECT1Count{0};
+        uint64_t ecnCECount{0};
         bool operator==(const ReadAckFrame& /*rhs*/) const {
             // Can't compare ackBlocks, function is just here to appease compiler.
             return false;
@@ -8,6 +8,12 @@
 #include "quic_integer.hpp"
 #include "common/common.hpp"
 
+#include <folly/Portability.h>
+
+#if FOLLY_SSE >= 2
+#include <emmintrin.h>
+#endif
+
 namespace quic {
 
 folly::Expected<size_t, TransportErrorCode> getQuicIntegerSize(uint64_t value) {
@@ -76,6 +82,74 @@ folly::Optional<std::pair<uint64_t, size_t>> decodeQuicInteger(folly::io::Cursor
     return std::pair<uint64_t, size_t>{result, bytesExpected};
 }
 
+namespace {
+
+// Number of leading bytes of data[0, 16) which are one byte QUIC integers,
+// i.e. have both length bits clear.
+inline size_t countOneByteIntegers(const uint8_t* data) {
+#if FOLLY_SSE >= 2
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    const __m128i lengthBits = _mm_and_si128(bytes, _mm_set1_epi8(static_cast<char>(0xC0)));
+    const auto oneByte = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(lengthBits, _mm_setzero_si128())));
+    const auto multiByte = ~oneByte & 0xFFFF;
+    return multiByte ? folly::findFirstSet(multiByte) - 1 : 16;
+#else
+    uint64_t lo, hi;
+    std::memcpy(&lo, data, sizeof(lo));
+    std::memcpy(&hi, data + sizeof(lo), sizeof(hi));
+    // Works on the in-memory byte order, so the first byte is the low one.
+    lo = folly::Endian::little(lo) & 0xC0C0C0C0C0C0C0C0ull;
+    hi = folly::Endian::little(hi) & 0xC0C0C0C0C0C0C0C0ull;
+    if (lo) {
+        return (folly::findFirstSet(lo) - 1) / 8;
+    }
+    return hi ? 8 + (folly::findFirstSet(hi) - 1) / 8 : 16;
+#endif
+}
+
+} // namespace
+
+folly::Optional<size_t> decodeQuicIntegers(const uint8_t* data, size_t len, uint64_t* out, size_t count) {
+    constexpr uint64_t msbMask = ~(0b11ull << 62);
+    size_t pos = 0;
+    size_t decoded = 0;
+    while (decoded < count) {
+        // Copy out a run of one byte integers while a full 16 byte window is
+        // available.
+        if (count - decoded >= 16 && len - pos >= 16) {
+            const auto run = countOneByteIntegers(data + pos);
+            for (size_t i = 0; i < run; ++i) {
+                out[decoded + i] = data[pos + i];
+            }
+            decoded += run;
+            pos += run;
+            if (run == 16) {
+                continue;
+            }
+        }
+        if (decoded == count) {
+            break;
+        }
+        if (pos == len) {
+            return folly::none;
+        }
+        const size_t size = decodeQuicIntegerLength(data[pos]);
+        if (len - pos < size) {
+            return folly::none;
+        }
+        uint64_t result{0};
+        if (len - pos >= sizeof(result)) {
+            std::memcpy(&result, data + pos, sizeof(result));
+        } else {
+            std::memcpy(&result, data + pos, size);
+        }
+        result = folly::Endian::big(result) & msbMask;
+        out[decoded++] = result >> ((8 - size) << 3);
+        pos += size;
+    }
+    return pos;
+}
+
 folly::Optional<std::pair<uint64_t, size_t>> decodeQuicInteger(const char *buf, size_t &offset, size_t len, uint64_t atMost) {
     // checks
     if (atMost == 0 || len < 1) {
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <cstring>
+
 #include <folly/Expected.h>
 #include <folly/Optional.h>
 #include <folly/io/Cursor.h>
@@ -101,6 +103,19 @@ encodeQuicInteger(uint64_t value, BufOp bufop, int outputSize) {
 folly::Optional<std::pair<uint64_t, size_t>> decodeQuicInteger(folly::io::Cursor& cursor, uint64_t atMost = sizeof(uint64_t));
 folly::Optional<std::pair<uint64_t, size_t>> decodeQuicInteger(const char *buf, size_t &offset, size_t len, uint64_t atMost = sizeof(uint64_t));
 
+/**
+ * Decodes count consecutive QUIC integers from the contiguous buffer
+ * [data, data + len) into out. Returns the number of bytes consumed, or
+ * folly::none if the buffer ends before the last integer does, in which case
+ * the contents of out are unspecified.
+ *
+ * Unlike repeated decodeQuicInteger calls this does no per-integer Optional or
+ * cursor bookkeeping, and classifies integer lengths 16 prefix bytes at a time
+ * so that runs of one byte integers, the common case for ack block gaps and
+ * lengths, are copied out without decoding them one by one.
+ */
+folly::Optional<size_t> decodeQuicIntegers(const uint8_t* data, size_t len, uint64_t* out, size_t count);
+
 /**
  * Returns the length of a quic integer given the first byte
  */
@@ -120,6 +135,29 @@ folly::Expected<size_t, TransportErrorCode> getQuicIntegerSize(uint64_t value);
  */
 size_t getQuicIntegerSizeThrows(uint64_t value);
 
+/**
+ * Branch free getQuicIntegerSize for values known to be encodable, i.e. no
+ * larger than kEightByteLimit. Meant for sizing whole arrays of integers in a
+ * loop the compiler can vectorize.
+ */
+constexpr uint8_t getQuicIntegerSizeUnchecked(uint64_t value) {
+    return 1 + (value > kOneByteLimit) + 2 * (value > kTwoByteLimit) + 4 * (value > kFourByteLimit);
+}
+
+/**
+ * Encodes value as a QUIC integer of the given size, which must be
+ * getQuicIntegerSizeUnchecked(value), at out and returns the position right
+ * after it. Always stores 8 bytes, so out must have at least 8 writable bytes
+ * even when the integer is shorter.
+ */
+inline uint8_t* encodeQuicIntegerUnchecked(uint64_t value, uint8_t size, uint8_t* out) {
+    // The two leading bits are log2(size).
+    const uint64_t lengthBits = static_cast<uint64_t>(folly::findFirstSet(size) - 1) << 62;
+    const uint64_t encoded = folly::Endian::big((value << (64 - 8 * size)) | lengthBits);
+    std::memcpy(out, &encoded, sizeof(encoded));
+    return out + size;
+}
+
 /**
  * A better API for dealing with QUIC integers for encoding.
  */
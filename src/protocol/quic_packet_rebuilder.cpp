@@ -22,16 +22,11 @@ uint64_t PacketRebuilder::getHeaderBytes() const {
 }
 
 PacketEvent PacketRebuilder::cloneOutstandingPacket(OutstandingPacketWrapper& packet) {
-    // Either the packet has never been cloned before, or it's associatedEvent is
-    // still in the outstandings.packetEvents set.
-    //DCHECK(!packet.associatedEvent || conn_.outstandings.packetEvents.count(*packet.associatedEvent));
+    // Either the packet has never been cloned before, or its clone group is
+    // still pending.
+    //DCHECK(!packet.associatedEvent || conn_.outstandings.cloneGroups.isPending(*packet.associatedEvent));
     if (!packet.associatedEvent) {
-        auto packetNum = packet.packet.header.getPacketSequenceNum();
-        auto packetNumberSpace = packet.packet.header.getPacketNumberSpace();
-        PacketEvent event(packetNumberSpace, packetNum);
-        //DCHECK(!conn_.outstandings.packetEvents.count(event));
-        packet.associatedEvent = event;
-        conn_.outstandings.packetEvents.insert(event);
+        packet.associatedEvent = conn_.outstandings.cloneGroups.open();
         ++conn_.outstandings.clonedPacketCount[packet.packet.header.getPacketNumberSpace()];
     }
     return *packet.associatedEvent;
@@ -35,8 +35,8 @@ private:
     /**
      * A helper function that takes a OutstandingPacketWrapper that's not
      * processed, and return its associatedEvent. If this packet has never been
-     * cloned, then create the associatedEvent and add it into
-     * outstandings.packetEvents first.
+     * cloned, then open a clone group in outstandings.cloneGroups for it
+     * first.
      */
     PacketEvent cloneOutstandingPacket(OutstandingPacketWrapper& packet);
 
@@ -188,44 +188,69 @@ folly::Optional<WriteCryptoFrame> writeCryptoFrame(uint64_t offsetIn, const BufQ
     return WriteCryptoFrame(offsetIn, lengthVarInt.getValue());
 }
 
+// Wire encoding of the additional blocks of an ACK frame. Large enough for the
+// usual frame; those with many blocks under heavy reordering spill to the heap.
+using EncodedAckBlocks = SmallVec<uint8_t, 256>;
+
 /*
  * This function will fill the parameter ack frame with ack blocks from the
- * parameter ackBlocks until it runs out of space (bytesLimit). The largest
- * ack block should have been inserted by the caller.
+ * parameter ackBlocks until it runs out of space (bytesLimit), and encodes
+ * their gaps and lengths into encodedBlocks, ready to be written right after
+ * the frame's fixed fields. The largest ack block should have been inserted by
+ * the caller.
+ *
+ * Frames with many blocks are common under reordering, so rather than sizing
+ * each block's varints as it is appended, all sizes are computed in one branch
+ * free pass, the number of blocks that fit is picked on their prefix sum, and
+ * the chosen blocks are encoded in a single sweep.
  */
-static size_t fillFrameWithAckBlocks(const AckBlocks& ackBlocks, WriteAckFrame& ackFrame, uint64_t bytesLimit) {
+static size_t fillFrameWithAckBlocks(
+    const AckBlocks& ackBlocks, WriteAckFrame& ackFrame, uint64_t bytesLimit, EncodedAckBlocks& encodedBlocks) {
+    // Each block takes at least two bytes, there's no point in looking further.
+    const size_t maxAckBlocks = std::min<uint64_t>(ackBlocks.size() - 1, bytesLimit / 2);
+
+    // Gap and length of each additional block, in the order they are written.
+    SmallVec<uint64_t, 64> fields(2 * maxAckBlocks);
+    SmallVec<uint8_t, 64> fieldSizes(2 * maxAckBlocks);
     PacketNum currentSeqNum = ackBlocks.crbegin()->start;
+    auto blockItr = ackBlocks.crbegin() + 1;
+    for (size_t i = 0; i < maxAckBlocks; ++i, ++blockItr) {
+        // These must be true because of the properties of the interval set.
+        //CHECK_GE(currentSeqNum, blockItr->end + 2);
+        fields[2 * i] = currentSeqNum - blockItr->end - 2;
+        fields[2 * i + 1] = blockItr->end - blockItr->start;
+        currentSeqNum = blockItr->start;
+    }
+    for (size_t i = 0; i < fields.size(); ++i) {
+        fieldSizes[i] = getQuicIntegerSizeUnchecked(fields[i]);
+    }
 
-    // starts off with 0 which is what we assumed the initial ack block to be for
-    // the largest acked.
+    // The caller accounted for a one byte block count; a larger count also
+    // has to fit.
     size_t numAdditionalAckBlocks = 0;
-    size_t previousNumAckBlocks = 0;
-
-    // Skip the largest, as it has already been emplaced.
-    for (auto blockItr = ackBlocks.crbegin() + 1; blockItr != ackBlocks.crend(); ++blockItr) {
-        const auto& currBlock = *blockItr;
-        // These must be true because of the properties of the interval set.
-        //CHECK_GE(currentSeqNum, currBlock.end + 2);
-        PacketNum gap = currentSeqNum - currBlock.end - 2;
-        PacketNum currBlockLen = currBlock.end - currBlock.start;
-
-        // TODO this is still extra work, as we end up duplicating these
-        // calculations in the caller, we could store the results so they
-        // can be reused by the caller when writing the frame.
-        size_t gapSize = getQuicIntegerSizeThrows(gap);
-        size_t currBlockLenSize = getQuicIntegerSizeThrows(currBlockLen);
-        size_t numAdditionalAckBlocksSize = getQuicIntegerSizeThrows(numAdditionalAckBlocks + 1);
-        size_t previousNumAckBlocksSize = getQuicIntegerSizeThrows(previousNumAckBlocks);
-
-        size_t additionalSize = gapSize + currBlockLenSize + (numAdditionalAckBlocksSize - previousNumAckBlocksSize);
-        if (bytesLimit < additionalSize) {
+    uint64_t blocksSize = 0;
+    while (numAdditionalAckBlocks < maxAckBlocks) {
+        const uint64_t nextBlocksSize =
+            blocksSize + fieldSizes[2 * numAdditionalAckBlocks] + fieldSizes[2 * numAdditionalAckBlocks + 1];
+        if (nextBlocksSize + getQuicIntegerSizeUnchecked(numAdditionalAckBlocks + 1) - 1 > bytesLimit) {
             break;
         }
+        blocksSize = nextBlocksSize;
         numAdditionalAckBlocks++;
-        bytesLimit -= additionalSize;
-        previousNumAckBlocks = numAdditionalAckBlocks;
-        currentSeqNum = currBlock.start;
-        ackFrame.ackBlocks.emplace_back(currBlock.start, currBlock.end);
+    }
+
+    // Slack for the 8 byte stores of encodeQuicIntegerUnchecked.
+    encodedBlocks.resize(blocksSize + sizeof(uint64_t));
+    auto out = encodedBlocks.data();
+    for (size_t i = 0; i < 2 * numAdditionalAckBlocks; ++i) {
+        out = encodeQuicIntegerUnchecked(fields[i], fieldSizes[i], out);
+    }
+    encodedBlocks.resize(blocksSize);
+
+    ackFrame.ackBlocks.reserve(numAdditionalAckBlocks + 1);
+    blockItr = ackBlocks.crbegin() + 1;
+    for (size_t i = 0; i < numAdditionalAckBlocks; ++i, ++blockItr) {
+        ackFrame.ackBlocks.emplace_back(blockItr->start, blockItr->end);
     }
     return numAdditionalAckBlocks;
 }
@@ -339,7 +364,6 @@ folly::Optional<WriteAckFrame> writeAckFrameToPacketBuilder(
     WriteAckFrame ackFrame;
     ackFrame.frameType = frameType;
     uint64_t spaceLeft = builder.remainingSpaceInPkt();
-    ackFrame.ackBlocks.reserve(spaceLeft / 4);
 
     // We could technically split the range if the size of the representation of
     // the integer is too large, but that gets super tricky and is of dubious
@@ -384,7 +408,8 @@ folly::Optional<WriteAckFrame> writeAckFrameToPacketBuilder(
     spaceLeft -= (headerSize + minAdditionalAckReceiveTimestampsFieldsSize);
 
     ackFrame.ackBlocks.push_back(ackState.acks.back());
-    auto numAdditionalAckBlocks = fillFrameWithAckBlocks(ackState.acks, ackFrame, spaceLeft);
+    EncodedAckBlocks encodedBlocks;
+    auto numAdditionalAckBlocks = fillFrameWithAckBlocks(ackState.acks, ackFrame, spaceLeft, encodedBlocks);
 
     QuicInteger numAdditionalAckBlocksInt(numAdditionalAckBlocks);
     builder.write(encodedintFrameType);
@@ -392,17 +417,8 @@ folly::Optional<WriteAckFrame> writeAckFrameToPacketBuilder(
     builder.write(ackDelayInt);
     builder.write(numAdditionalAckBlocksInt);
     builder.write(firstAckBlockLengthInt);
-
-    PacketNum currentSeqNum = ackState.acks.back().start;
-    for (auto it = ackFrame.ackBlocks.cbegin() + 1; it != ackFrame.ackBlocks.cend(); ++it) {
-        //CHECK_GE(currentSeqNum, it->end + 2);
-        PacketNum gap = currentSeqNum - it->end - 2;
-        PacketNum currBlockLen = it->end - it->start;
-        QuicInteger gapInt(gap);
-        QuicInteger currentBlockLenInt(currBlockLen);
-        builder.write(gapInt);
-        builder.write(currentBlockLenInt);
-        currentSeqNum = it->start;
+    if (!encodedBlocks.empty()) {
+        builder.push(encodedBlocks.data(), encodedBlocks.size());
     }
     ackFrame.ackDelay = ackFrameMetaData.ackDelay;
     return ackFrame;
@@ -31,4 +31,24 @@ TicketTransportParameters createTicketTransportParameters(
     return params;
 }
 
+void encodeCongestionHint(TicketTransportParameters& params, const CongestionHint& hint) {
+    params.parameters.push_back(encodeIntegerParameter(TransportParameterId::congestion_hint_bandwidth, hint.bandwidthBytesPerSec));
+    params.parameters.push_back(encodeIntegerParameter(TransportParameterId::congestion_hint_min_rtt, uint64_t(hint.minRtt.count())));
+    params.parameters.push_back(encodeIntegerParameter(TransportParameterId::congestion_hint_loss, hint.lossPerMille));
+}
+
+folly::Optional<CongestionHint> decodeCongestionHint(const std::vector<TransportParameter>& parameters) {
+    auto bandwidth = getIntegerParameter(TransportParameterId::congestion_hint_bandwidth, parameters);
+    auto minRtt = getIntegerParameter(TransportParameterId::congestion_hint_min_rtt, parameters);
+    auto loss = getIntegerParameter(TransportParameterId::congestion_hint_loss, parameters);
+    if (!bandwidth || !minRtt || !loss || *loss > 1000) {
+        return folly::none;
+    }
+    CongestionHint hint;
+    hint.bandwidthBytesPerSec = *bandwidth;
+    hint.minRtt = std::chrono::microseconds(*minRtt);
+    hint.lossPerMille = static_cast<uint16_t>(*loss);
+    return hint;
+}
+
 } // namespace quic
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "protocol/quic_constants.hpp"
+#include "congestion_control/congestion_hint_cache.h"
 #include "handshake/transport_parameters.h"
 #include <folly/IPAddress.h>
 
@@ -26,6 +27,9 @@ struct AppToken {
     std::vector<folly::IPAddress> sourceAddresses;
     QuicVersion version;
     std::unique_ptr<folly::IOBuf> appParams;
+    // Path estimates of the connection issuing the ticket, so that a resumed
+    // connection starts warm even on another shard or host.
+    folly::Optional<CongestionHint> congestionHint;
 };
 
 TicketTransportParameters createTicketTransportParameters(
@@ -38,4 +42,14 @@ TicketTransportParameters createTicketTransportParameters(
     uint64_t initialMaxStreamsBidi,
     uint64_t initialMaxStreamsUni);
 
+/**
+ * Stores hint in a ticket's transport parameters, and reads it back from a
+ * resumed ticket's. The validator of a resumed ticket can insert the decoded
+ * hint into the shard's CongestionHintCache under the client address before
+ * the connection's congestion controller is made.
+ */
+void encodeCongestionHint(TicketTransportParameters& params, const CongestionHint& hint);
+
+folly::Optional<CongestionHint> decodeCongestionHint(const std::vector<TransportParameter>& parameters);
+
 } // namespace quic
@@ -1,4 +1,6 @@
 #include "server_state_machine.h"
+#include "congestion_control/congestion_control_factory.h"
+#include "congestion_control/congestion_hint_cache.h"
 
 namespace quic{
 
@@ -132,6 +134,12 @@ void onServerReadDataFromOpen(QuicServerConnectionState& conn, seastar::net::pac
         conn.readCodec->setInitialHeaderCipher(cryptoFactory.makeClientInitialHeaderCipher(initialDestinationConnectionId, version));
         conn.initialHeaderCipher = cryptoFactory.makeServerInitialHeaderCipher(initialDestinationConnectionId, version);
         conn.peerAddress = conn.originalPeerAddress;
+        // The controller was made before the peer was known, remake it now
+        // that it can start from the client's congestion hint.
+        if (conn.congestionController && conn.congestionControllerFactory && lookupCongestionHint(conn)) {
+            conn.congestionController =
+                conn.congestionControllerFactory->makeCongestionController(conn, conn.congestionController->type());
+        }
 
     } // end of !readCodec
 
@@ -125,6 +125,11 @@ struct AckEvent {
     // determine information about stream bytes.
     uint64_t ackedBytes{0};
 
+    // number of newly acked packets the peer reported as CE marked.
+    //
+    // only set for ACK_ECN frames while the connection marks its packets.
+    uint64_t ecnCEMarkedPackets{0};
+
     // total number of bytes acked on this connection after ACK processed.
     //
     // this value is the same as lossState.totalBytesAcked and does not
@@ -200,8 +205,10 @@ struct AckEvent {
             DupAckedStreamIntervals dupAckedStreamIntervals;
         };
 
-        // Structure with information about each stream with frames in ACKed packet
-        using MapType = InlineMap<StreamId, StreamDetails, 5>;
+        // Structure with information about each stream with frames in ACKed packet.
+        // Sized like OutstandingPacketMetadata::DetailsPerStream; packets rarely
+        // carry frames of more than one stream.
+        using MapType = InlineMap<StreamId, StreamDetails, 1>;
         class DetailsPerStream : private MapType {
             public:
             /**
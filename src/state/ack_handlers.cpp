@@ -8,6 +8,8 @@
 #include <folly/MapUtil.h>
 #include "loss/quic_loss_functions.h"
 #include "ack_handlers.h"
+#include "congestion_control/congestion_controller_calls.h"
+#include "state/quic_ack_frequency_function.h"
 #include "state/quic_state_function.h"
 #include "state/quic_stream_function.h"
 
@@ -36,15 +38,13 @@ struct OutstandingPacketWithHandlerContext {
  * Process ack frame and acked outstanding packets.
  *
  * This function process incoming ack blocks which is sorted in the descending
- * order of packet number. For each ack block, we try to find a continuous range
- * of outstanding packets in the connection's outstanding packets list that is
- * acked by the current ack block. The search is in the reverse order of the
- * outstandings.packets given that the list is sorted in the ascending order of
- * packet number. For each outstanding packet that is acked by current ack
- * frame, ack and loss visitors are invoked on the sent frames. The outstanding
- * packets may contain packets from all three packet number spaces. But ack is
- * always restrained to a single space. So we also need to skip packets that are
- * not in the current packet number space.
+ * order of packet number. Outstanding packets are kept in one ring per packet
+ * number space, indexed by packet number, so for each ack block we look up
+ * every packet number it covers (clamped to the outstanding range of the ring)
+ * directly instead of searching the outstanding list. The cost of processing an
+ * ack is therefore bounded by the acked ranges, not by the number of packets in
+ * flight. For each outstanding packet that is acked by current ack frame, ack
+ * and loss visitors are invoked on the sent frames.
  *
  */
 
@@ -70,15 +70,20 @@ AckEvent processAckFrame(
   // temporary storage to enable packets to be processed in sent order
   SmallVec<OutstandingPacketWithHandlerContext, 50> packetsWithHandlerContext;
 
-  auto currentPacketIt = getLastOutstandingPacketIncludingLost(conn, pnSpace);
+  auto& outstandingPackets = conn.outstandings.packets[pnSpace];
 
-  // Store first outstanding packet number to ignore old receive timestamps.
+  // Store first and last outstanding packet number to ignore receive
+  // timestamps of packets not outstanding.
   const auto& firstOutstandingPacket =
       getFirstOutstandingPacket(conn, PacketNumberSpace::AppData);
   folly::Optional<PacketNum> firstPacketNum =
-      (firstOutstandingPacket != conn.outstandings.packets.end())
+      (firstOutstandingPacket !=
+       conn.outstandings.packets[PacketNumberSpace::AppData].end())
       ? folly::make_optional(firstOutstandingPacket->getPacketSequenceNum())
       : folly::none;
+  const PacketNum lastPacketNum = firstPacketNum
+      ? conn.outstandings.packets[PacketNumberSpace::AppData].lastPacketNum()
+      : 0;
 
   uint64_t dsrPacketsAcked = 0;
   folly::Optional<decltype(conn.lossState.lastAckedPacketSentTime)>
@@ -94,87 +99,63 @@ AckEvent processAckFrame(
       spuriousLossEvent.emplace(ackReceiveTime);
     }
   }
-  auto ackBlockIt = frame.ackBlocks.cbegin();
-  while (ackBlockIt != frame.ackBlocks.cend() &&
-         currentPacketIt != conn.outstandings.packets.rend()) {
-    // In reverse order, find the first outstanding packet that has a packet
-    // number LE the endPacket of the current ack range.
-    auto rPacketIt = std::lower_bound(
-        currentPacketIt,
-        conn.outstandings.packets.rend(),
-        ackBlockIt->endPacket,
-        [&](const auto& packetWithTime, const auto& val) {
-          return packetWithTime.packet.header.getPacketSequenceNum() > val;
-        });
-    if (rPacketIt == conn.outstandings.packets.rend()) {
+  for (auto ackBlockIt = frame.ackBlocks.cbegin();
+       ackBlockIt != frame.ackBlocks.cend() && !outstandingPackets.empty();
+       ackBlockIt++) {
+    if (ackBlockIt->endPacket < outstandingPackets.firstPacketNum()) {
       // This means that all the packets are greater than the end packet.
       // Since we iterate the ACK blocks in reverse order of end packets, our
       // work here is done.
-      /*
-      //VLOG(10) << __func__ << " less than all outstanding packets outstanding="
-               << conn.outstandings.numOutstanding() << " range=["
-               << ackBlockIt->startPacket << ", " << ackBlockIt->endPacket
-               << "]"
-               << " " << conn;
-      */
-      ackBlockIt++;
       break;
     }
-
-    auto eraseEnd = rPacketIt;
-    while (rPacketIt != conn.outstandings.packets.rend()) {
-      auto currentPacketNum = rPacketIt->packet.header.getPacketSequenceNum();
-      auto currentPacketNumberSpace =
-          rPacketIt->packet.header.getPacketNumberSpace();
-      if (pnSpace != currentPacketNumberSpace) {
-        // When the next packet is not in the same packet number space, we need
-        // to skip it in current ack processing. If the iterator has moved, that
-        // means we have found packets in the current space that are acked by
-        // this ack block. So the code erases the current iterator range and
-        // move the iterator to be the next search point.
-        if (rPacketIt != eraseEnd) {
-          auto nextElem = conn.outstandings.packets.erase(
-              rPacketIt.base(), eraseEnd.base());
-          rPacketIt = std::reverse_iterator<decltype(nextElem)>(nextElem) + 1;
-          eraseEnd = rPacketIt;
-        } else {
-          rPacketIt++;
-          eraseEnd = rPacketIt;
-        }
+    if (ackBlockIt->startPacket > outstandingPackets.lastPacketNum()) {
+      continue;
+    }
+    const auto rangeStart =
+        std::max(ackBlockIt->startPacket, outstandingPackets.firstPacketNum());
+    const auto rangeEnd =
+        std::min(ackBlockIt->endPacket, outstandingPackets.lastPacketNum());
+    // Walk the range downwards so packets are visited in the same order as
+    // the ack blocks. Erasing may trim the ring, but the range stays valid
+    // since find() returns nullptr for anything outside of it.
+    for (auto currentPacketNum = rangeEnd + 1;
+         currentPacketNum-- > rangeStart;) {
+      auto ackedPacket = outstandingPackets.find(currentPacketNum);
+      if (!ackedPacket) {
         continue;
       }
-      if (currentPacketNum < ackBlockIt->startPacket) {
-        break;
-      }
       /*
       //VLOG(10) << __func__ << " acked packetNum=" << currentPacketNum
-               << " space=" << currentPacketNumberSpace << " handshake="
-               << (int)((rPacketIt->metadata.isHandshake) ? 1 : 0) << " "
+               << " space=" << pnSpace << " handshake="
+               << (int)((ackedPacket->metadata.isHandshake) ? 1 : 0) << " "
                << conn;
       */
       // If we hit a packet which has been lost we need to count the spurious
       // loss and ignore all other processing.
-      if (rPacketIt->declaredLost) {
+      if (ackedPacket->declaredLost) {
         //CHECK_GT(conn.outstandings.declaredLostCount, 0);
         conn.lossState.totalPacketsSpuriouslyMarkedLost++;
         if (conn.transportSettings.useAdaptiveLossReorderingThresholds) {
-          if (rPacketIt->metadata.lossReorderDistance.hasValue() &&
-              rPacketIt->metadata.lossReorderDistance.value() >
+          const auto lossReorderDistance =
+              ackedPacket->metadata.lossReorderDistance();
+          if (lossReorderDistance.hasValue() &&
+              lossReorderDistance.value() >
                   conn.lossState.reorderingThreshold) {
-            conn.lossState.reorderingThreshold =
-                rPacketIt->metadata.lossReorderDistance.value();
+            conn.lossState.reorderingThreshold = lossReorderDistance.value();
           }
         }
         if (conn.transportSettings.useAdaptiveLossTimeThresholds) {
-          if (rPacketIt->metadata.lossTimeoutDividend.hasValue() &&
-              rPacketIt->metadata.lossTimeoutDividend.value() >
+          const auto lossTimeoutDividend =
+              ackedPacket->metadata.lossTimeoutDividend();
+          if (lossTimeoutDividend.hasValue() &&
+              lossTimeoutDividend.value() >
                   conn.transportSettings.timeReorderingThreshDividend) {
             conn.transportSettings.timeReorderingThreshDividend =
-                rPacketIt->metadata.lossTimeoutDividend.value();
+                lossTimeoutDividend.value();
           }
         }
         if (conn.transportSettings.removeFromLossBufferOnSpurious) {
-          for (auto& f : rPacketIt->packet.frames) {
+          for (auto& f : ackedPacket->packet.frames) {
             auto streamFrame = f.asWriteStreamFrame();
             if (streamFrame) {
               auto stream =
@@ -190,31 +171,32 @@ AckEvent processAckFrame(
           }
         }
         QUIC_STATS(conn.statsCallback, onPacketSpuriousLoss);
-        // Decrement the counter, trust that we will erase this as part of
-        // the bulk erase.
         //CHECK_GT(conn.outstandings.declaredLostCount, 0);
         conn.outstandings.declaredLostCount--;
         if (spuriousLossEvent) {
           spuriousLossEvent->addSpuriousPacket(
-              rPacketIt->metadata,
-              rPacketIt->packet.header.getPacketSequenceNum(),
-              rPacketIt->packet.header.getPacketNumberSpace());
+              ackedPacket->metadata,
+              ackedPacket->packet.header.getPacketSequenceNum(),
+              ackedPacket->packet.header.getPacketNumberSpace());
+        }
+        if (ackedPacket->associatedEvent) {
+          conn.outstandings.cloneGroups.release(*ackedPacket->associatedEvent);
         }
-        rPacketIt++;
+        outstandingPackets.erase(currentPacketNum);
         continue;
       }
-      bool needsProcess = !rPacketIt->associatedEvent ||
-          conn.outstandings.packetEvents.count(*rPacketIt->associatedEvent);
+      bool needsProcess = !ackedPacket->associatedEvent ||
+          conn.outstandings.cloneGroups.isPending(*ackedPacket->associatedEvent);
       if (needsProcess) {
-        //CHECK(conn.outstandings.packetCount[currentPacketNumberSpace]);
-        --conn.outstandings.packetCount[currentPacketNumberSpace];
+        //CHECK(conn.outstandings.packetCount[pnSpace]);
+        --conn.outstandings.packetCount[pnSpace];
       }
-      ack.ackedBytes += rPacketIt->metadata.encodedSize;
-      if (rPacketIt->associatedEvent) {
-        //CHECK(conn.outstandings.clonedPacketCount[currentPacketNumberSpace]);
-        --conn.outstandings.clonedPacketCount[currentPacketNumberSpace];
+      ack.ackedBytes += ackedPacket->metadata.encodedSize;
+      if (ackedPacket->associatedEvent) {
+        //CHECK(conn.outstandings.clonedPacketCount[pnSpace]);
+        --conn.outstandings.clonedPacketCount[pnSpace];
       }
-      if (rPacketIt->isDSRPacket) {
+      if (ackedPacket->isDSRPacket) {
         ++dsrPacketsAcked;
       }
 
@@ -226,7 +208,7 @@ AckEvent processAckFrame(
       // estimates if it does not newly acknowledge the largest acknowledged
       // packet (RFC9002). This includes for minRTT estimates.
       if (!ack.implicit && currentPacketNum == frame.largestAcked) {
-        auto ackReceiveTimeOrNow = ackReceiveTime > rPacketIt->metadata.time
+        auto ackReceiveTimeOrNow = ackReceiveTime > ackedPacket->metadata.time
             ? ackReceiveTime
             : nowTime;
 
@@ -235,7 +217,7 @@ AckEvent processAckFrame(
         // While unlikely, it's still technically possible for the RTT to be
         // zero; ignore if this is the case.
         auto rttSample = std::chrono::ceil<std::chrono::microseconds>(
-            ackReceiveTimeOrNow - rPacketIt->metadata.time);
+            ackReceiveTimeOrNow - ackedPacket->metadata.time);
         if (rttSample != rttSample.zero()) {
           // notify observers
           {
@@ -250,7 +232,7 @@ AckEvent processAckFrame(
                        ackReceiveTimeOrNow,
                        rttSample,
                        frame.ackDelay,
-                       *rPacketIt)](auto observer, auto observed) {
+                       *ackedPacket)](auto observer, auto observed) {
                     observer->rttSampleGenerated(observed, event);
                   });
             }
@@ -271,25 +253,27 @@ AckEvent processAckFrame(
         } // if (rttSample != rttSample.zero())
       } // if (!ack.implicit && currentPacketNum == frame.largestAcked)
 
-      // Remove this PacketEvent from the outstandings.packetEvents set
-      if (rPacketIt->associatedEvent) {
-        conn.outstandings.packetEvents.erase(*rPacketIt->associatedEvent);
+      // The packet leaves the outstandings, and its clone group is processed
+      if (ackedPacket->associatedEvent) {
+        conn.outstandings.cloneGroups.markProcessed(
+            *ackedPacket->associatedEvent);
+        conn.outstandings.cloneGroups.release(*ackedPacket->associatedEvent);
       }
       if (!ack.largestNewlyAckedPacket ||
           *ack.largestNewlyAckedPacket < currentPacketNum) {
         ack.largestNewlyAckedPacket = currentPacketNum;
-        ack.largestNewlyAckedPacketSentTime = rPacketIt->metadata.time;
-        ack.largestNewlyAckedPacketAppLimited = rPacketIt->isAppLimited;
+        ack.largestNewlyAckedPacketSentTime = ackedPacket->metadata.time;
+        ack.largestNewlyAckedPacketAppLimited = ackedPacket->isAppLimited;
       }
       if (!ack.implicit) {
-        conn.lossState.totalBytesAcked += rPacketIt->metadata.encodedSize;
+        conn.lossState.totalBytesAcked += ackedPacket->metadata.encodedSize;
         conn.lossState.totalBytesSentAtLastAck = conn.lossState.totalBytesSent;
         conn.lossState.totalBytesAckedAtLastAck =
             conn.lossState.totalBytesAcked;
         conn.lossState.totalBodyBytesAcked +=
-            rPacketIt->metadata.encodedBodySize;
+            ackedPacket->metadata.encodedBodySize;
         if (!lastAckedPacketSentTime) {
-          lastAckedPacketSentTime = rPacketIt->metadata.time;
+          lastAckedPacketSentTime = ackedPacket->metadata.time;
         }
         conn.lossState.lastAckedTime = ackReceiveTime;
         conn.lossState.adjustedLastAckedTime = ackReceiveTime - frame.ackDelay;
@@ -306,36 +290,29 @@ AckEvent processAckFrame(
                              .header.getPacketSequenceNum() > currentPacketNum;
                 })
                 .base(),
-            std::move(*rPacketIt));
+            std::move(*ackedPacket));
         tmpIt->processAllFrames = needsProcess;
       }
 
-      rPacketIt++;
+      outstandingPackets.erase(currentPacketNum);
     }
-    // Done searching for acked outstanding packets in current ack block. Erase
-    // the current iterator range which is the last batch of continuous
-    // outstanding packets that are in this ack block. Move the iterator to be
-    // the next search point.
-    if (rPacketIt != eraseEnd) {
-      auto nextElem =
-          conn.outstandings.packets.erase(rPacketIt.base(), eraseEnd.base());
-      currentPacketIt = std::reverse_iterator<decltype(nextElem)>(nextElem);
-    } else {
-      currentPacketIt = rPacketIt;
-    }
-    ackBlockIt++;
   }
 
   // Store any (new) Rx timestamps reported by the peer.
-  folly::F14FastMap<PacketNum, uint64_t> packetReceiveTimeStamps;
+  auto& packetReceiveTimeStamps = conn.ackReceiveTimestamps;
+  packetReceiveTimeStamps.reset(0, 0);
   if (pnSpace == PacketNumberSpace::AppData) {
     parseAckReceiveTimestamps(
-        conn, frame, packetReceiveTimeStamps, firstPacketNum);
+        conn, frame, packetReceiveTimeStamps, firstPacketNum, lastPacketNum);
   }
 
   // Invoke AckVisitor for WriteAckFrames all the time. Invoke it for other
   // frame types only if the packet doesn't have an associated PacketEvent;
-  // or the PacketEvent is in conn.outstandings.packetEvents
+  // or its clone group was still pending
+  if (!conn.recycledAckedPackets.empty()) {
+    ack.ackedPackets = std::move(conn.recycledAckedPackets.back());
+    conn.recycledAckedPackets.pop_back();
+  }
   ack.ackedPackets.reserve(packetsWithHandlerContext.size());
   for (auto packetWithHandlerContextItr = packetsWithHandlerContext.rbegin();
        packetWithHandlerContextItr != packetsWithHandlerContext.rend();
@@ -403,6 +380,11 @@ AckEvent processAckFrame(
 
         // determine if this frame was a retransmission
         const bool retransmission = ([&outstandingPacket, &ackedFrame]() {
+          // packets which only carried new stream data can skip the per
+          // stream lookup
+          if (!outstandingPacket.metadata.hasRetransmittedStreamData) {
+            return false;
+          }
           // in some cases (some unit tests), stream details are not available
           // in these cases, we assume it is not a retransmission
           if (const auto* maybeStreamDetails = folly::get_ptr(
@@ -444,8 +426,10 @@ AckEvent processAckFrame(
         }
       }
     }
-    auto maybeRxTimestamp = packetReceiveTimeStamps.find(
-        outstandingPacket.packet.header.getPacketSequenceNum());
+    auto maybeRxTimestamp = packetReceiveTimeStamps.empty()
+        ? folly::none
+        : packetReceiveTimeStamps.get(
+              outstandingPacket.packet.header.getPacketSequenceNum());
     ack.ackedPackets.emplace_back(
         CongestionController::AckEvent::AckPacket::Builder()
             .setPacketNum(
@@ -458,18 +442,25 @@ AckEvent processAckFrame(
                 std::move(outstandingPacket.lastAckedPacketInfo))
             .setAppLimited(outstandingPacket.isAppLimited)
             .setReceiveDeltaTimeStamp(
-                maybeRxTimestamp != packetReceiveTimeStamps.end()
+                maybeRxTimestamp
                     ? folly::make_optional(
-                          std::chrono::microseconds(maybeRxTimestamp->second))
+                          std::chrono::microseconds(*maybeRxTimestamp))
                     : folly::none)
             .build());
   }
   if (lastAckedPacketSentTime) {
     conn.lossState.lastAckedPacketSentTime = *lastAckedPacketSentTime;
+    // The sent time above is the one of the largest newly acked packet.
+    auto peerReceiveTime = packetReceiveTimeStamps.empty()
+        ? folly::none
+        : packetReceiveTimeStamps.get(*ack.largestNewlyAckedPacket);
+    conn.lossState.lastAckedPacketPeerReceiveTime = peerReceiveTime
+        ? folly::make_optional(std::chrono::microseconds(*peerReceiveTime))
+        : folly::none;
   }
   //CHECK_GE(conn.outstandings.dsrCount, dsrPacketsAcked);
   conn.outstandings.dsrCount -= dsrPacketsAcked;
-  //CHECK_GE(conn.outstandings.packets.size(), conn.outstandings.declaredLostCount);
+  //CHECK_GE(conn.outstandings.numPackets(), conn.outstandings.declaredLostCount);
   auto updatedOustandingPacketsCount = conn.outstandings.numOutstanding();
   const auto& packetCount = conn.outstandings.packetCount;
   /*
@@ -490,6 +481,7 @@ AckEvent processAckFrame(
       << originalPacketCount[PacketNumberSpace::AppData] << "}";
   //CHECK_GE(updatedOustandingPacketsCount, conn.outstandings.numClonedPackets());
   */
+  updateEcnState(conn, pnSpace, frame, ack);
   auto lossEvent = handleAckForLoss(conn, lossVisitor, ack, pnSpace);
   if (conn.congestionController &&
       (ack.largestNewlyAckedPacket.has_value() || lossEvent)) {
@@ -510,11 +502,15 @@ AckEvent processAckFrame(
         QUIC_STATS(conn.statsCallback, onPersistentCongestion);
       }
     }
-    conn.congestionController->onPacketAckOrLoss(&ack, lossEvent.get_pointer());
+    congestionControllerOnPacketAckOrLoss(conn, &ack, lossEvent.get_pointer());
     for (auto& packetProcessor : conn.packetProcessors) {
       packetProcessor->onPacketAck(&ack);
     }
     ack.ccState = conn.congestionController->getState();
+    if (pnSpace == PacketNumberSpace::AppData) {
+      updatePeerAckFrequency(conn, ackReceiveTime);
+      updateBandwidthEstimate(conn, ackReceiveTime);
+    }
   }
   clearOldOutstandingPackets(conn, ackReceiveTime, pnSpace);
 
@@ -543,43 +539,35 @@ void clearOldOutstandingPackets(
   if (conn.outstandings.declaredLostCount) {
     // Reap any old packets declared lost that are unlikely to be ACK'd.
     auto threshold = calculatePTO(conn);
-    auto opItr = conn.outstandings.packets.begin();
-    auto eraseBegin = opItr;
-    while (opItr != conn.outstandings.packets.end()) {
+    auto& packets = conn.outstandings.packets[pnSpace];
+    auto opItr = packets.begin();
+    while (opItr != packets.end()) {
       // This case can happen when we have buffered an undecryptable ACK and
       // are able to decrypt it later.
       if (time < opItr->metadata.time) {
         break;
       }
-      if (opItr->packet.header.getPacketNumberSpace() != pnSpace) {
-        if (eraseBegin != opItr) {
-          // We want to keep [eraseBegin, opItr) within a single PN space.
-          opItr = conn.outstandings.packets.erase(eraseBegin, opItr);
-        }
-        opItr++;
-        eraseBegin = opItr;
-        continue;
-      }
       auto timeSinceSent = time - opItr->metadata.time;
       if (opItr->declaredLost && timeSinceSent > threshold) {
-        opItr++;
+        if (opItr->associatedEvent) {
+          conn.outstandings.cloneGroups.release(*opItr->associatedEvent);
+        }
+        opItr = packets.erase(opItr);
         //CHECK_GT(conn.outstandings.declaredLostCount, 0);
         conn.outstandings.declaredLostCount--;
       } else {
         break;
       }
     }
-    if (eraseBegin != opItr) {
-      conn.outstandings.packets.erase(eraseBegin, opItr);
-    }
   }
 }
 
 void parseAckReceiveTimestamps(
     const QuicConnectionStateBase& conn,
     const quic::ReadAckFrame& frame,
-    folly::F14FastMap<PacketNum, uint64_t>& packetReceiveTimeStamps,
-    folly::Optional<PacketNum> firstPacketNum) {
+    AckReceiveTimestamps& packetReceiveTimeStamps,
+    folly::Optional<PacketNum> firstPacketNum,
+    PacketNum lastPacketNum) {
   if (frame.frameType != FrameType::ACK_RECEIVE_TIMESTAMPS) {
     return;
   }
@@ -606,6 +594,7 @@ void parseAckReceiveTimestamps(
     return;
   }
 
+  packetReceiveTimeStamps.reset(firstPacketNum.value(), lastPacketNum);
   const auto& maxReceiveTimestampsRequestedFromPeer =
       conn.transportSettings.maybeAckReceiveTimestampsConfigSentToPeer.value()
           .maxReceiveTimestampsPerAck;
@@ -629,6 +618,9 @@ void parseAckReceiveTimestamps(
   // 2D0 - D0 = D0 for the first timestamp.
   // Tn = Tn-1 - Dn for other timestamps.
   auto receiveTimeStamp = 2 * frame.recvdPacketsTimestampRanges[0].deltas[0];
+  // Timestamps of packets past the last outstanding one count against the
+  // limit too, though they aren't recorded.
+  uint64_t numTimestamps = 0;
   // Walk through each timestamp range (separated by gaps) and calculate the
   // Rx timestamp.
   for (auto& timeStampRange : frame.recvdPacketsTimestampRanges) {
@@ -642,10 +634,10 @@ void parseAckReceiveTimestamps(
       }
       // We don't need to process more than the requested Receive timestamps
       // sent by peer.
-      if (packetReceiveTimeStamps.size() >= maxReceiveTimestampsRequestedFromPeer) {
+      if (numTimestamps >= maxReceiveTimestampsRequestedFromPeer) {
         /*
         //LOG(ERROR) << " Received more timestamps "
-                   << packetReceiveTimeStamps.size()
+                   << numTimestamps
                    << " than requested timestamps from peer: "
                    << maxReceiveTimestampsRequestedFromPeer << " current PN "
                    << receivedPacketNum << " largest PN "
@@ -655,7 +647,8 @@ void parseAckReceiveTimestamps(
         return;
       }
       receiveTimeStamp -= delta;
-      packetReceiveTimeStamps[receivedPacketNum] = receiveTimeStamp;
+      packetReceiveTimeStamps.set(receivedPacketNum, receiveTimeStamp);
+      ++numTimestamps;
       receivedPacketNum = decrementPacketNum(receivedPacketNum);
     }
     // Additional decrement to maintain a gap of "2" for subsequent timestamp
@@ -664,6 +657,18 @@ void parseAckReceiveTimestamps(
   }
 }
 
+void recycleAckEvent(QuicConnectionStateBase& conn, AckEvent& ack) {
+  // A handful of buffers covers the ACKs processed in one read loop; anything
+  // beyond that is freed as usual.
+  constexpr size_t kMaxRecycledAckedPackets = 4;
+  if (ack.ackedPackets.capacity() == 0 ||
+      conn.recycledAckedPackets.size() >= kMaxRecycledAckedPackets) {
+    return;
+  }
+  ack.ackedPackets.clear();
+  conn.recycledAckedPackets.emplace_back(std::move(ack.ackedPackets));
+}
+
 void commonAckVisitorForAckFrame(
     AckState& ackState,
     const WriteAckFrame& frame) {
@@ -12,11 +12,13 @@
 #include "protocol/quic_frame.hpp"
 #include "state/state_data.h"
 
-#include <functional>
+#include <folly/Function.h>
 
 namespace quic {
 
-using AckVisitor = std::function<void(
+// Non-owning, like LossVisitor: the visitor is only invoked while
+// processAckFrame runs, so callers' lambdas are never copied or allocated.
+using AckVisitor = folly::FunctionRef<void(
     const OutstandingPacketWrapper&,
     const QuicWriteFrame&,
     const ReadAckFrame&)>;
@@ -35,6 +37,13 @@ AckEvent processAckFrame(
     const LossVisitor& lossVisitor,
     const TimePoint& ackReceiveTime);
 
+/**
+ * Hands the acked packet storage of an AckEvent which is no longer needed back
+ * to the connection, so that the next processAckFrame reuses it rather than
+ * allocating a new one.
+ */
+void recycleAckEvent(QuicConnectionStateBase& conn, AckEvent& ack);
+
 /**
  * Clears outstanding packets marked as lost that are not likely to be ACKed
  * (have been lost for >= 1 PTO).
@@ -53,13 +62,14 @@ void commonAckVisitorForAckFrame(
     const WriteAckFrame& frame);
 
 /**
- * Parse Receive timestamps from ACK frame into a folly::F14FastMap of packet
- * number to timestamps and return the latest received packet with timestamp if
- * any.
+ * Parse Receive timestamps from ACK frame into packetReceiveTimeStamps, for
+ * the packets numbered firstPacketNum to lastPacketNum, i.e. the ones which
+ * were outstanding when the ACK arrived.
  */
 void parseAckReceiveTimestamps(
     const QuicConnectionStateBase& conn,
     const quic::ReadAckFrame& frame,
-    folly::F14FastMap<PacketNum, uint64_t>& packetReceiveTimeStamps,
-    folly::Optional<PacketNum> firstPacketNum);
+    AckReceiveTimestamps& packetReceiveTimeStamps,
+    folly::Optional<PacketNum> firstPacketNum,
+    PacketNum lastPacketNum);
 } // namespace quic
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <folly/Optional.h>
+#include "protocol/quic_packet_num.hpp"
+
+namespace quic {
+
+/**
+ * Peer receive timestamps decoded from a single ACK_RECEIVE_TIMESTAMPS frame.
+ * The frame lists them as runs of consecutive packet numbers going down from
+ * the latest received packet, so they are kept in that order: one vector of
+ * timestamps and one entry per run, rather than a hash map. Decoding costs
+ * the number of timestamps in the frame, whatever the outstanding window, and
+ * both vectors are kept across ACKs so it doesn't allocate once they have
+ * grown to the peer's timestamps per ACK.
+ */
+class AckReceiveTimestamps {
+public:
+    // Drops all timestamps. Only packet numbers in [firstPacketNum,
+    // lastPacketNum] can be recorded until the next reset.
+    void reset(PacketNum firstPacketNum, PacketNum lastPacketNum) {
+        timestamps_.clear();
+        ranges_.clear();
+        firstPacketNum_ = firstPacketNum;
+        lastPacketNum_ = lastPacketNum;
+    }
+
+    // Records the timestamp of packetNum, if it is in range. Packet numbers
+    // are recorded in decreasing order, others are dropped.
+    void set(PacketNum packetNum, uint64_t timestamp) {
+        if (packetNum < firstPacketNum_ || packetNum > lastPacketNum_) {
+            return;
+        }
+        if (ranges_.empty() || packetNum + 1 < ranges_.back().smallest) {
+            ranges_.push_back({packetNum, packetNum, timestamps_.size()});
+        } else if (packetNum + 1 == ranges_.back().smallest) {
+            ranges_.back().smallest = packetNum;
+        } else {
+            return;
+        }
+        timestamps_.push_back(timestamp);
+    }
+
+    [[nodiscard]] folly::Optional<uint64_t> get(PacketNum packetNum) const {
+        for (const auto& range : ranges_) {
+            if (packetNum > range.largest) {
+                // Ranges only go down from here.
+                return folly::none;
+            }
+            if (packetNum >= range.smallest) {
+                return timestamps_[range.begin + (range.largest - packetNum)];
+            }
+        }
+        return folly::none;
+    }
+
+    // Number of packets with a timestamp.
+    [[nodiscard]] size_t size() const {
+        return timestamps_.size();
+    }
+
+    [[nodiscard]] bool empty() const {
+        return timestamps_.empty();
+    }
+
+private:
+    // Consecutive packet numbers, whose timestamps start at begin in
+    // timestamps_, the largest packet number's first.
+    struct Range {
+        PacketNum largest;
+        PacketNum smallest;
+        size_t begin;
+    };
+
+    std::vector<uint64_t> timestamps_;
+    std::vector<Range> ranges_;
+    PacketNum firstPacketNum_{0};
+    PacketNum lastPacketNum_{0};
+};
+
+} // namespace quic
@@ -29,6 +29,10 @@ struct AckState : WriteAckFrameState {
     folly::Optional<PacketNum> largestRecvdPacketNum;
     // Latest packet number acked by peer
     folly::Optional<PacketNum> largestAckedByPeer;
+    // ECN counts of the last ACK_ECN frame from the peer.
+    uint64_t ecnECT0CountEchoed{0};
+    uint64_t ecnECT1CountEchoed{0};
+    uint64_t ecnCECountEchoed{0};
     // Largest received packet number at the time we sent our last close message.
     folly::Optional<PacketNum> largestReceivedAtLastCloseSent;
     // Next PacketNum we will send for packet in this packet number space
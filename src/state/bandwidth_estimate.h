@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include <folly/Optional.h>
+#include "protocol/quic_constants.hpp"
+
+namespace quic {
+
+/**
+ * What the connection measured of its path over the last interval, for the
+ * app to choose a bitrate from. See QuicSocket::setBandwidthEstimateCallback.
+ */
+struct BandwidthEstimate {
+    // Smoothed delivery rate in bits per second. From the bandwidth sampler for
+    // BBR and BBR2, from the ACK rate otherwise.
+    uint64_t deliveryRateBitsPerSec{0};
+    // Zero until there is an RTT sample.
+    std::chrono::microseconds minRtt{0us};
+    uint64_t congestionWindow{0};
+    // The cwnd blocked writes during the interval, so more data would have
+    // queued rather than gone out faster.
+    bool cwndLimited{false};
+    // The app didn't fill the cwnd, so the delivery rate is a lower bound of
+    // what the path can carry.
+    bool appLimited{false};
+    // Fraction of the packets sent during the interval declared lost in it.
+    double lossRate{0};
+};
+
+/**
+ * Counters at the start of the current estimate interval.
+ */
+struct BandwidthEstimateState {
+    // Set while the app is subscribed.
+    folly::Optional<std::chrono::microseconds> interval;
+    folly::Optional<TimePoint> intervalStart;
+    uint64_t totalBytesAckedAtStart{0};
+    uint64_t totalPacketsSentAtStart{0};
+    uint64_t totalPacketsMarkedLostAtStart{0};
+    bool cwndLimited{false};
+    // Bytes per second.
+    double smoothedDeliveryRate{0};
+};
+
+} // namespace quic
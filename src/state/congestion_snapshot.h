@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+#include <folly/Optional.h>
+#include "congestion_control/congestion_controller.h"
+#include "protocol/quic_constants.hpp"
+
+namespace quic {
+
+/**
+ * The pacing rate a pacer was using. The time of its last write isn't kept,
+ * the first write after a restore goes out right away.
+ */
+struct PacerSnapshot {
+    uint64_t batchSize{0};
+    std::chrono::microseconds writeInterval{0us};
+    uint64_t maxPacingRateBytesPerSec{std::numeric_limits<uint64_t>::max()};
+    uint8_t rttFactorNumerator{1};
+    uint8_t rttFactorDenominator{1};
+};
+
+/**
+ * A connection's congestion state, for the connection to go on at the same
+ * rate when it is rebuilt on another shard, e.g. after a NAT rebinding lands
+ * its packets there. See QuicSocket::getCongestionStateSnapshot.
+ *
+ * TimePoints are steady clock times, only meaningful within the process.
+ */
+struct CongestionStateSnapshot {
+    CongestionControllerSnapshot congestionController;
+    folly::Optional<PacerSnapshot> pacer;
+    std::chrono::microseconds srtt{0us};
+    std::chrono::microseconds lrtt{0us};
+    std::chrono::microseconds rttvar{0us};
+    std::chrono::microseconds mrtt{kDefaultMinRtt};
+};
+
+} // namespace quic
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <folly/Optional.h>
+#include "protocol/quic_constants.hpp"
+#include "protocol/quic_packet_num.hpp"
+
+namespace quic {
+
+enum class ECNState : uint8_t {
+    // Packets aren't marked.
+    NotAttempted,
+    // Packets are marked ECT(0) but the peer's counts aren't validated yet.
+    AttemptingECN,
+    ValidatedECN,
+    // Same with ECT(1).
+    AttemptingL4S,
+    ValidatedL4S,
+    // The peer's counts were missing or inconsistent, packets aren't marked
+    // anymore.
+    FailedValidation,
+};
+
+/**
+ * ECN on the send side: validation of the counts the peer echoes in its
+ * ACK_ECN frames (RFC 9000 section 13.4.2), and for L4S, the fraction of
+ * packets the path marks CE, from which Cubic and BBR2 size their response.
+ */
+struct EcnState {
+    ECNState state{ECNState::NotAttempted};
+    // Marked packets acked with consistent counts, up to kEcnValidationPackets.
+    uint64_t validatedPackets{0};
+
+    // Prague style congestion estimate: EWMA of the fraction of acked packets
+    // marked CE per round, between 0 and 1. It is 1 until a round sees marks,
+    // so the first response halves the cwnd like DCTCP's, and that round's
+    // fraction then replaces it outright rather than being averaged in.
+    double l4sAlpha{1.0};
+    bool l4sAlphaSampled{false};
+    uint64_t ackedPacketsInRound{0};
+    uint64_t ceMarkedPacketsInRound{0};
+    // The round ends once a packet sent after this one is acked.
+    folly::Optional<PacketNum> roundEndPacketNum;
+    // The last packet of the first flight, which may go out in one burst
+    // before there is an RTT to pace it by. An L4S bottleneck marks such a
+    // burst even on an idle path, so its marks are ignored.
+    folly::Optional<PacketNum> firstFlightEndPacketNum;
+
+    [[nodiscard]] bool isMarking() const noexcept {
+        return state != ECNState::NotAttempted && state != ECNState::FailedValidation;
+    }
+
+    [[nodiscard]] bool isL4s() const noexcept {
+        return state == ECNState::AttemptingL4S || state == ECNState::ValidatedL4S;
+    }
+
+    // The codepoint outgoing packets are marked with.
+    [[nodiscard]] uint8_t codepoint() const noexcept {
+        if (!isMarking()) {
+            return kEcnNotECT;
+        }
+        return isL4s() ? kEcnECT1 : kEcnECT0;
+    }
+
+    /**
+     * Counts an ACK of newlyAcked AppData packets, ceMarked of them CE, and
+     * folds the CE fraction of the round into l4sAlpha once a packet sent
+     * after the round started is acked. lastSentPacketNum ends the next round.
+     * Returns the CE marks to respond to, none for an ACK of the first flight.
+     */
+    uint64_t updateL4sAlpha(
+        uint64_t newlyAcked, uint64_t ceMarked, PacketNum largestNewlyAcked, PacketNum lastSentPacketNum) noexcept {
+        if (!firstFlightEndPacketNum) {
+            firstFlightEndPacketNum = lastSentPacketNum;
+        }
+        if (largestNewlyAcked <= *firstFlightEndPacketNum) {
+            ceMarked = 0;
+        }
+        ackedPacketsInRound += newlyAcked;
+        ceMarkedPacketsInRound += ceMarked;
+        if (roundEndPacketNum && largestNewlyAcked <= *roundEndPacketNum) {
+            return ceMarked;
+        }
+        if (ceMarkedPacketsInRound > 0 || l4sAlphaSampled) {
+            auto ceFraction = static_cast<double>(ceMarkedPacketsInRound) / static_cast<double>(ackedPacketsInRound);
+            l4sAlpha = l4sAlphaSampled ? (1 - kL4sAlphaGain) * l4sAlpha + kL4sAlphaGain * ceFraction : ceFraction;
+            l4sAlphaSampled = true;
+        }
+        ackedPacketsInRound = 0;
+        ceMarkedPacketsInRound = 0;
+        roundEndPacketNum = lastSentPacketNum;
+        return ceMarked;
+    }
+};
+
+} // namespace quic
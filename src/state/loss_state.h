@@ -38,6 +38,9 @@ struct LossState {
     std::chrono::microseconds rttvar{0us};
     // The sent time of the latest acked packet.
     folly::Optional<TimePoint> lastAckedPacketSentTime;
+    // The peer receive timestamp of the latest acked packet, if the peer sent
+    // one in its ACK.
+    folly::Optional<std::chrono::microseconds> lastAckedPacketPeerReceiveTime;
     // The latest time a packet is acked.
     folly::Optional<TimePoint> lastAckedTime;
     // The latest time a packet is acked, minus ack delay.
@@ -19,52 +19,27 @@
 
 #include "loss_state.h"
 #include "packet_event.h"
+#include <algorithm>
 #include <chrono>
+#include <memory>
 
 namespace quic {
 
+/**
+ * Per packet bookkeeping kept for every outstanding packet. The fields are
+ * split by access pattern: what ack, loss and congestion control processing
+ * read is stored inline, while the fields which are only written when a packet
+ * is sent with cmsgs or declared lost, and read back on spurious loss or by
+ * observers, live in a separately allocated Cold block that most packets never
+ * allocate. This keeps each outstanding packet, and every AckEvent::AckPacket
+ * built from it, a few cache lines long.
+ */
 struct OutstandingPacketMetadata {
-    // Time that the packet was sent.
-    TimePoint time;
-    // Size of the packet sent on the wire.
-    uint32_t encodedSize;
-    // Size of only the body within the packet sent on the wire.
-    uint32_t encodedBodySize;
-    // Whether this packet has any data from stream 0
-    bool isHandshake;
-    // Total sent bytes on this connection including this packet itself when this
-    // packet is sent.
-    uint64_t totalBytesSent;
-    // Total sent body bytes on this connection including this packet itself when
-    // this packet is sent.
-    uint64_t totalBodyBytesSent;
-    // Bytes in flight on this connection including this packet itself when this
-    // packet is sent.
-    uint64_t inflightBytes;
-    // Packets in flight on this connection including this packet itself.
-    uint64_t packetsInflight;
-    // Total number of packets sent on this connection.
-    uint32_t totalPacketsSent{0};
-    // Total number of ack-eliciting packets sent on this connection.
-    uint32_t totalAckElicitingPacketsSent{0};
-    // Write Count is the value of the monotonically increasing counter which
-    // tracks the number of writes on this socket.
-    uint64_t writeCount{0};
-    // Cmsgs added by the QuicSocket when this packet was written
-    folly::Optional<folly::SocketOptionMap> cmsgs;
-
-    // Has value if the packet is lost by timout. The value is the loss timeout
-    // dividend that was used to declare this packet.
-    folly::Optional<DurationRep> lossTimeoutDividend;
-
-    // Has value if the packet is lost by reorder. The value is the distance
-    // between this packet and the acknowleded packet when it was declared lost
-    // due to reordering
-    folly::Optional<uint32_t> lossReorderDistance;
-
     struct StreamDetails {
+        // A packet normally carries a single contiguous range per stream, so
+        // keep one interval inline and spill to the heap otherwise.
         template <class T>
-        using IntervalSetVec = SmallVec<T, 4 /* stack size */>;
+        using IntervalSetVec = SmallVec<T, 1 /* stack size */>;
         using StreamIntervals = IntervalSet<uint64_t, 1, IntervalSetVec>;
         StreamIntervals streamIntervals;
 
@@ -74,7 +49,10 @@ struct OutstandingPacketMetadata {
         folly::Optional<uint64_t> maybeFirstNewStreamByteOffset;
     };
 
-    using MapType = InlineMap<StreamId, StreamDetails, 5>;
+    // Two streams inline: a packet often packs the tail of one stream's data
+    // with the next stream's, e.g. audio and video. Packets with more streams
+    // spill to the heap.
+    using MapType = InlineMap<StreamId, StreamDetails, 2>;
     class DetailsPerStream : private MapType {
     public:
         void addFrame(const WriteStreamFrame& frame, const bool newData) {
@@ -99,6 +77,16 @@ struct OutstandingPacketMetadata {
             }
         }
 
+        // Whether any stream in the packet carried data that had been sent
+        // before. A stream with no new data counts even if it sent no bytes: a
+        // retransmitted FIN-only frame is a retransmission to ack processing.
+        [[nodiscard]] bool hasRetransmittedData() const {
+            return std::any_of(begin(), end(), [](const auto& entry) {
+                return !entry.second.maybeFirstNewStreamByteOffset.has_value() ||
+                    entry.second.streamBytesSent != entry.second.newStreamBytesSent;
+            });
+        }
+
         [[nodiscard]] auto at(StreamId id) const {
             return MapType::at(id);
         }
@@ -115,34 +103,149 @@ struct OutstandingPacketMetadata {
         using MapType::value_type;
     };
 
-    // Details about each stream with frames in this packet
-    DetailsPerStream detailsPerStream;
+    // Rarely accessed fields, see above.
+    struct Cold {
+        // Cmsgs added by the QuicSocket when this packet was written
+        folly::Optional<folly::SocketOptionMap> cmsgs;
+
+        // Has value if the packet is lost by timout. The value is the loss timeout
+        // dividend that was used to declare this packet.
+        folly::Optional<DurationRep> lossTimeoutDividend;
+
+        // Has value if the packet is lost by reorder. The value is the distance
+        // between this packet and the acknowleded packet when it was declared lost
+        // due to reordering
+        folly::Optional<uint32_t> lossReorderDistance;
+    };
+
+    // Owning pointer to the Cold block. Copies are deep so that observers can
+    // keep holding metadata by value.
+    class ColdPtr {
+    public:
+        ColdPtr() = default;
+        ColdPtr(ColdPtr&&) noexcept = default;
+        ColdPtr& operator=(ColdPtr&&) noexcept = default;
+
+        ColdPtr(const ColdPtr& other) : ptr_(other.ptr_ ? std::make_unique<Cold>(*other.ptr_) : nullptr) {}
+
+        ColdPtr& operator=(const ColdPtr& other) {
+            if (this != &other) {
+                ptr_ = other.ptr_ ? std::make_unique<Cold>(*other.ptr_) : nullptr;
+            }
+            return *this;
+        }
+
+        [[nodiscard]] const Cold* get() const {
+            return ptr_.get();
+        }
+
+        Cold& getOrCreate() {
+            if (!ptr_) {
+                ptr_ = std::make_unique<Cold>();
+            }
+            return *ptr_;
+        }
+
+    private:
+        std::unique_ptr<Cold> ptr_;
+    };
 
+    // Time that the packet was sent.
+    TimePoint time;
+    // Size of the packet sent on the wire.
+    uint32_t encodedSize;
+    // Size of only the body within the packet sent on the wire.
+    uint32_t encodedBodySize;
+    // Total sent bytes on this connection including this packet itself when this
+    // packet is sent.
+    uint64_t totalBytesSent;
+    // Total sent body bytes on this connection including this packet itself when
+    // this packet is sent.
+    uint64_t totalBodyBytesSent;
+    // Bytes in flight on this connection including this packet itself when this
+    // packet is sent.
+    uint64_t inflightBytes;
+    // Packets in flight on this connection including this packet itself.
+    uint64_t packetsInflight;
+    // Total number of packets sent on this connection.
+    uint32_t totalPacketsSent{0};
+    // Total number of ack-eliciting packets sent on this connection.
+    uint32_t totalAckElicitingPacketsSent{0};
+    // Write Count is the value of the monotonically increasing counter which
+    // tracks the number of writes on this socket.
+    uint64_t writeCount{0};
     // Total time spent app limited on this connection including when this packet
     // was sent.
     std::chrono::microseconds totalAppLimitedTimeUsecs{0};
+    // Whether this packet has any data from stream 0
+    bool isHandshake;
+    // Whether any stream frame in this packet resent previously sent data,
+    // including a FIN. Lets ack processing skip the per stream details for
+    // packets which only carried new data.
+    bool hasRetransmittedStreamData{false};
+
+    ColdPtr cold;
+
+    // Details about each stream with frames in this packet. Only read on ack
+    // for packets with hasRetransmittedStreamData set, and by observers.
+    DetailsPerStream detailsPerStream;
 
     OutstandingPacketMetadata(TimePoint timeIn, uint32_t encodedSizeIn, uint32_t encodedBodySizeIn,
         bool isHandshakeIn, uint64_t totalBytesSentIn, uint64_t totalBodyBytesSentIn,
         uint64_t inflightBytesIn, uint64_t packetsInflightIn, const LossState& lossStateIn,
         uint64_t writeCount, DetailsPerStream detailsPerStream, std::chrono::microseconds totalAppLimitedTimeUsecsIn = 0us)
             : time(timeIn), encodedSize(encodedSizeIn), encodedBodySize(encodedBodySizeIn),
-            isHandshake(isHandshakeIn), totalBytesSent(totalBytesSentIn), totalBodyBytesSent(totalBodyBytesSentIn),
+            totalBytesSent(totalBytesSentIn), totalBodyBytesSent(totalBodyBytesSentIn),
             inflightBytes(inflightBytesIn), packetsInflight(packetsInflightIn), totalPacketsSent(lossStateIn.totalPacketsSent), 
             totalAckElicitingPacketsSent(lossStateIn.totalAckElicitingPacketsSent),
-            writeCount(writeCount), detailsPerStream(std::move(detailsPerStream)), totalAppLimitedTimeUsecs(totalAppLimitedTimeUsecsIn) {}
+            writeCount(writeCount), totalAppLimitedTimeUsecs(totalAppLimitedTimeUsecsIn), isHandshake(isHandshakeIn),
+            hasRetransmittedStreamData(detailsPerStream.hasRetransmittedData()),
+            detailsPerStream(std::move(detailsPerStream)) {}
+
+    [[nodiscard]] folly::Optional<DurationRep> lossTimeoutDividend() const {
+        return cold.get() ? cold.get()->lossTimeoutDividend : folly::none;
+    }
+
+    [[nodiscard]] folly::Optional<uint32_t> lossReorderDistance() const {
+        return cold.get() ? cold.get()->lossReorderDistance : folly::none;
+    }
 };
 
 // Data structure to represent outstanding retransmittable packets
 struct OutstandingPacket {
     using Metadata = OutstandingPacketMetadata;
 
-    // Structure representing the frames that are outstanding including the header
-    // that was sent.
-    RegularQuicWritePacket packet;
+    // The fields read for every packet walked by ack and loss processing come
+    // first so they share the leading cache lines of the object.
+
     // Structure representing a collection of metrics and important information
     // about the packet.
     OutstandingPacketMetadata metadata;
+
+    // Clone group of this OutstandingPacketWrapper. This will be a folly::none
+    // if the packet isn't a clone and hasn't been cloned.
+    folly::Optional<PacketEvent> associatedEvent;
+
+    // Whether this is a DSR packet. A DSR packet's stream data isn't written
+    // by transport directly.
+    bool isDSRPacket{false};
+
+    /**
+     * Whether the packet is sent when congestion controller is in app-limited
+     * state.
+     */
+    bool isAppLimited{false};
+
+    // True if spurious loss detection is enabled and this packet was declared
+    // lost.
+    bool declaredLost{false};
+
+    folly::Optional<uint64_t> nonDsrPacketSequenceNumber;
+
+    // Structure representing the frames that are outstanding including the header
+    // that was sent.
+    RegularQuicWritePacket packet;
+
     // Information regarding the last acked packet on this connection when this
     // packet is sent.
     struct LastAckedPacketInfo {
@@ -154,6 +257,9 @@ struct OutstandingPacket {
     // Total acked bytes on this connection when last acked packet is acked,
     // including the last acked packet.
     uint64_t totalBytesAcked;
+    // Peer receive timestamp of the last acked packet, from ACK receive
+    // timestamps.
+    folly::Optional<std::chrono::microseconds> peerReceiveTime;
     LastAckedPacketInfo(TimePoint sentTimeIn, TimePoint ackTimeIn,
         TimePoint adjustedAckTimeIn, uint64_t totalBytesSentIn, uint64_t totalBytesAckedIn)
         : sentTime(sentTimeIn), ackTime(ackTimeIn), adjustedAckTime(adjustedAckTimeIn),
@@ -161,26 +267,6 @@ struct OutstandingPacket {
     };
     folly::Optional<LastAckedPacketInfo> lastAckedPacketInfo;
 
-    // PacketEvent associated with this OutstandingPacketWrapper. This will be a
-    // folly::none if the packet isn't a clone and hasn't been cloned.
-    folly::Optional<PacketEvent> associatedEvent;
-
-    // Whether this is a DSR packet. A DSR packet's stream data isn't written
-    // by transport directly.
-    bool isDSRPacket{false};
-
-    folly::Optional<uint64_t> nonDsrPacketSequenceNumber;
-
-    /**
-     * Whether the packet is sent when congestion controller is in app-limited
-     * state.
-     */
-    bool isAppLimited{false};
-
-    // True if spurious loss detection is enabled and this packet was declared
-    // lost.
-    bool declaredLost{false};
-
     quic::PacketNum getPacketSequenceNum() const {
     return packet.header.getPacketSequenceNum();
     }
@@ -191,10 +277,10 @@ struct OutstandingPacket {
         uint32_t encodedBodySizeIn, bool isHandshakeIn, uint64_t totalBytesSentIn, uint64_t totalBodyBytesSentIn,
         uint64_t inflightBytesIn, uint64_t packetsInflightIn, const LossState& lossStateIn,
         uint64_t writeCount, Metadata::DetailsPerStream detailsPerStream, std::chrono::microseconds totalAppLimitedTimeUsecs = 0us)
-            : packet(std::move(packetIn)),
-            metadata(OutstandingPacketMetadata(timeIn, encodedSizeIn, encodedBodySizeIn,
+            : metadata(OutstandingPacketMetadata(timeIn, encodedSizeIn, encodedBodySizeIn,
                 isHandshakeIn, totalBytesSentIn, totalBodyBytesSentIn, inflightBytesIn,
-                packetsInflightIn, lossStateIn, writeCount, std::move(detailsPerStream), totalAppLimitedTimeUsecs)) {
+                packetsInflightIn, lossStateIn, writeCount, std::move(detailsPerStream), totalAppLimitedTimeUsecs)),
+            packet(std::move(packetIn)) {
     }
 
     OutstandingPacket(OutstandingPacket&&) = default;
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include <boost/iterator/iterator_facade.hpp>
+#include <folly/Optional.h>
+#include "common/CircularDeque.h"
+#include "common/EnumArray.h"
+#include "outstanding_packet.h"
+
+namespace quic {
+
+/**
+ * Outstanding packets of a single packet number space, indexed by packet
+ * number. Slot i of the ring holds packet basePacketNum + i, so a packet is
+ * located with one subtraction instead of a search. Packet numbers which are
+ * not outstanding (acked, never ack-eliciting, or sent in another space) are
+ * empty slots. Empty slots at either end are trimmed eagerly, so whenever the
+ * ring is non-empty its first and last slots hold a packet.
+ *
+ * Iterators address packets by packet number rather than by slot, so they stay
+ * valid across emplace() and across erase() of other packets.
+ */
+class OutstandingPacketRing {
+    using Slot = folly::Optional<OutstandingPacketWrapper>;
+    static constexpr PacketNum kEndPacketNum = std::numeric_limits<PacketNum>::max();
+
+    template <typename RingT, typename ValueT>
+    class IteratorImpl : public boost::iterator_facade<IteratorImpl<RingT, ValueT>, ValueT,
+                             boost::bidirectional_traversal_tag> {
+    public:
+        IteratorImpl() = default;
+
+        IteratorImpl(RingT* ring, PacketNum packetNum) : ring_(ring), packetNum_(packetNum) {}
+
+        template <typename OtherRingT, typename OtherValueT,
+            typename = std::enable_if_t<std::is_convertible_v<OtherValueT*, ValueT*>>>
+        IteratorImpl(const IteratorImpl<OtherRingT, OtherValueT>& other)
+            : ring_(other.ring_), packetNum_(other.packetNum_) {}
+
+        [[nodiscard]] PacketNum packetNum() const {
+            return packetNum_;
+        }
+
+    private:
+        friend class boost::iterator_core_access;
+        friend class OutstandingPacketRing;
+        template <typename, typename>
+        friend class IteratorImpl;
+
+        [[nodiscard]] ValueT& dereference() const {
+            return **ring_->slotFor(packetNum_);
+        }
+
+        template <typename OtherRingT, typename OtherValueT>
+        [[nodiscard]] bool equal(const IteratorImpl<OtherRingT, OtherValueT>& other) const {
+            return packetNum_ == other.packetNum_;
+        }
+
+        void increment() {
+            packetNum_ = ring_->nextPacketNum(packetNum_);
+        }
+
+        void decrement() {
+            packetNum_ = ring_->prevPacketNum(packetNum_);
+        }
+
+        RingT* ring_{nullptr};
+        PacketNum packetNum_{kEndPacketNum};
+    };
+
+public:
+    using value_type = OutstandingPacketWrapper;
+    using iterator = IteratorImpl<OutstandingPacketRing, OutstandingPacketWrapper>;
+    using const_iterator = IteratorImpl<const OutstandingPacketRing, const OutstandingPacketWrapper>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    OutstandingPacketRing() = default;
+    OutstandingPacketRing(OutstandingPacketRing&& other) noexcept
+        : slots_(std::move(other.slots_)), basePacketNum_(other.basePacketNum_),
+          size_(std::exchange(other.size_, 0)) {}
+
+    OutstandingPacketRing& operator=(OutstandingPacketRing&& other) noexcept {
+        slots_ = std::move(other.slots_);
+        basePacketNum_ = other.basePacketNum_;
+        size_ = std::exchange(other.size_, 0);
+        return *this;
+    }
+
+    OutstandingPacketRing(const OutstandingPacketRing&) = delete;
+    OutstandingPacketRing& operator=(const OutstandingPacketRing&) = delete;
+
+    [[nodiscard]] bool empty() const {
+        return size_ == 0;
+    }
+
+    // Number of packets held, not the number of slots.
+    [[nodiscard]] size_t size() const {
+        return size_;
+    }
+
+    // Smallest and largest outstanding packet number. Only valid if !empty().
+    [[nodiscard]] PacketNum firstPacketNum() const {
+        return basePacketNum_;
+    }
+
+    [[nodiscard]] PacketNum lastPacketNum() const {
+        return basePacketNum_ + slots_.size() - 1;
+    }
+
+    iterator begin() {
+        return iterator(this, empty() ? kEndPacketNum : firstPacketNum());
+    }
+
+    iterator end() {
+        return iterator(this, kEndPacketNum);
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, empty() ? kEndPacketNum : firstPacketNum());
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, kEndPacketNum);
+    }
+
+    reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+
+    reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+
+    // First packet numbered packetNum or above, or end().
+    iterator lowerBound(PacketNum packetNum) {
+        if (empty() || packetNum <= firstPacketNum()) {
+            return begin();
+        }
+        if (packetNum > lastPacketNum()) {
+            return end();
+        }
+        return iterator(this, slots_[packetNum - basePacketNum_].has_value() ? packetNum : nextPacketNum(packetNum));
+    }
+
+    // Returns nullptr if packetNum isn't outstanding.
+    OutstandingPacketWrapper* find(PacketNum packetNum) {
+        auto slot = slotFor(packetNum);
+        return slot ? slot->get_pointer() : nullptr;
+    }
+
+    const OutstandingPacketWrapper* find(PacketNum packetNum) const {
+        auto slot = slotFor(packetNum);
+        return slot ? slot->get_pointer() : nullptr;
+    }
+
+    /**
+     * Inserts the packet numbered packetNum. Packets are normally sent in
+     * increasing order so this is an append, but inserting below the first
+     * packet or into an empty slot is also supported.
+     */
+    template <typename... Args>
+    OutstandingPacketWrapper& emplace(PacketNum packetNum, Args&&... args) {
+        if (slots_.empty()) {
+            basePacketNum_ = packetNum;
+            slots_.emplace_back();
+        } else if (packetNum > lastPacketNum()) {
+            while (lastPacketNum() < packetNum) {
+                slots_.emplace_back();
+            }
+        } else {
+            while (packetNum < basePacketNum_) {
+                slots_.emplace_front();
+                --basePacketNum_;
+            }
+        }
+        auto& slot = slots_[packetNum - basePacketNum_];
+        //DCHECK(!slot.has_value());
+        slot.emplace(std::forward<Args>(args)...);
+        ++size_;
+        return *slot;
+    }
+
+    // Removes the packet at it and returns the iterator following it.
+    iterator erase(iterator it) {
+        auto next = nextPacketNum(it.packetNum_);
+        erase(it.packetNum_);
+        return iterator(this, next);
+    }
+
+    void erase(PacketNum packetNum) {
+        auto slot = slotFor(packetNum);
+        if (!slot || !slot->has_value()) {
+            return;
+        }
+        slot->reset();
+        --size_;
+        while (!slots_.empty() && !slots_.front().has_value()) {
+            slots_.pop_front();
+            ++basePacketNum_;
+        }
+        while (!slots_.empty() && !slots_.back().has_value()) {
+            slots_.pop_back();
+        }
+    }
+
+    void clear() {
+        slots_.clear();
+        size_ = 0;
+    }
+
+private:
+    Slot* slotFor(PacketNum packetNum) {
+        return const_cast<Slot*>(static_cast<const OutstandingPacketRing*>(this)->slotFor(packetNum));
+    }
+
+    const Slot* slotFor(PacketNum packetNum) const {
+        if (slots_.empty() || packetNum < basePacketNum_ || packetNum > lastPacketNum()) {
+            return nullptr;
+        }
+        return &slots_[packetNum - basePacketNum_];
+    }
+
+    // Next outstanding packet number after packetNum, or kEndPacketNum.
+    [[nodiscard]] PacketNum nextPacketNum(PacketNum packetNum) const {
+        if (packetNum == kEndPacketNum || empty()) {
+            return kEndPacketNum;
+        }
+        const auto numSlots = slots_.size();
+        for (auto index = packetNum < basePacketNum_ ? 0 : packetNum + 1 - basePacketNum_; index < numSlots; ++index) {
+            if (slots_[index].has_value()) {
+                return basePacketNum_ + index;
+            }
+        }
+        return kEndPacketNum;
+    }
+
+    // Previous outstanding packet number before packetNum. Decrementing end()
+    // yields the last packet.
+    [[nodiscard]] PacketNum prevPacketNum(PacketNum packetNum) const {
+        if (empty()) {
+            return kEndPacketNum;
+        }
+        if (packetNum == kEndPacketNum || packetNum > lastPacketNum()) {
+            return lastPacketNum();
+        }
+        for (auto pn = packetNum; pn > basePacketNum_; --pn) {
+            if (slots_[pn - 1 - basePacketNum_].has_value()) {
+                return pn - 1;
+            }
+        }
+        return kEndPacketNum;
+    }
+
+    CircularDeque<Slot> slots_;
+    PacketNum basePacketNum_{0};
+    size_t size_{0};
+};
+
+// One ring per packet number space.
+using OutstandingPacketRings = EnumArray<PacketNumberSpace, OutstandingPacketRing>;
+
+} // namespace quic
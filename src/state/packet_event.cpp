@@ -7,23 +7,61 @@
 
 #include "packet_event.h"
 
-#include <folly/hash/Hash.h>
-#include <functional>
-
 namespace quic {
 
-PacketEvent::PacketEvent(PacketNumberSpace packetNumberSpaceIn, PacketNum packetNumberIn)
-    : packetNumberSpace(packetNumberSpaceIn), packetNumber(packetNumberIn) {}
+PacketEvent::PacketEvent(CloneGroupId cloneGroupIn) : cloneGroup(cloneGroupIn) {}
 
 bool operator==(const PacketEvent& lhs, const PacketEvent& rhs) {
-    return static_cast<std::underlying_type_t<PacketNumberSpace>>(lhs.packetNumberSpace) 
-        == static_cast<std::underlying_type_t<PacketNumberSpace>>(rhs.packetNumberSpace) 
-        && lhs.packetNumber == rhs.packetNumber;
+    return lhs.cloneGroup == rhs.cloneGroup;
+}
+
+PacketEvent CloneGroupTable::open() {
+    CloneGroupId id;
+    if (freeIds_.empty()) {
+        id = static_cast<CloneGroupId>(groups_.size());
+        groups_.emplace_back();
+    } else {
+        id = freeIds_.back();
+        freeIds_.pop_back();
+    }
+    groups_[id].refCount = 1;
+    groups_[id].pending = true;
+    ++numPending_;
+    return PacketEvent(id);
+}
+
+void CloneGroupTable::addRef(const PacketEvent& event) {
+    //DCHECK_LT(event.cloneGroup, groups_.size());
+    ++groups_[event.cloneGroup].refCount;
+}
+
+void CloneGroupTable::release(const PacketEvent& event) {
+    // Ignore groups this table holds no reference for.
+    if (event.cloneGroup >= groups_.size() || groups_[event.cloneGroup].refCount == 0) {
+        return;
+    }
+    auto& group = groups_[event.cloneGroup];
+    if (--group.refCount == 0) {
+        markProcessed(event);
+        freeIds_.push_back(event.cloneGroup);
+    }
+}
+
+bool CloneGroupTable::isPending(const PacketEvent& event) const {
+    return event.cloneGroup < groups_.size() && groups_[event.cloneGroup].pending;
+}
+
+void CloneGroupTable::markProcessed(const PacketEvent& event) {
+    if (isPending(event)) {
+        groups_[event.cloneGroup].pending = false;
+        --numPending_;
+    }
 }
 
-size_t PacketEventHash::operator()(const PacketEvent& packetEvent) const noexcept {
-    return folly::hash::hash_combine(
-        static_cast<std::underlying_type_t<PacketNumberSpace>>(packetEvent.packetNumberSpace), packetEvent.packetNumber);
+void CloneGroupTable::clear() {
+    groups_.clear();
+    freeIds_.clear();
+    numPending_ = 0;
 }
 
 } // namespace quic
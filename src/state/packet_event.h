@@ -7,43 +7,79 @@
 
 #pragma once
 
-#include "protocol/quic_header.hpp"
-#include "protocol/quic_packet_num.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace quic {
 
+using CloneGroupId = uint32_t;
+
 /**
  * There are cases that we may clone an outstanding packet and resend it as is.
- * When that happens, we assign a PacketEvent to both the original and cloned
- * packet if no PacketEvent is already associated with the original packet. If
- * the original packet already has a PacketEvent, we copy that value into the
- * cloned packet.
- * A connection maintains a set of PacketEvents. When a packet with a
- * PacketEvent is acked or lost, we search the set. If the PacketEvent is
- * present in the set, we process the ack or loss event (e.g. update RTT, notify
- * CongestionController, and detect loss with this packet) as well as frames in
- * the packet. Then we remove the PacketEvent from the set. If the PacketEvent
- * is absent in the set, we consider all frames contained in the packet are
- * already processed. We will still handle the ack or loss event and update the
- * connection. But no frame will be processed.
+ * When that happens, the original and all of its clones form a clone group,
+ * and each of them carries a PacketEvent naming the group. If the original
+ * packet already has a PacketEvent, we copy that value into the cloned packet.
  *
- * TODO: Current PacketNum is an alias to uint64_t. We should just make
- * PacketNum be a type with both the space and the number, then PacketEvent will
- * just be an alias to this type.
+ * A connection keeps a CloneGroupTable. When a packet with a PacketEvent is
+ * acked or lost, we check whether its group is still pending in the table. If
+ * it is, we process the ack or loss event (e.g. update RTT, notify
+ * CongestionController, and detect loss with this packet) as well as frames in
+ * the packet, then mark the group processed. If the group was already
+ * processed, we consider all frames contained in the packet already processed.
+ * We will still handle the ack or loss event and update the connection. But no
+ * frame will be processed.
  */
 struct PacketEvent {
-    PacketNumberSpace packetNumberSpace;
-    PacketNum packetNumber;
+    CloneGroupId cloneGroup;
 
     PacketEvent() = delete;
-    PacketEvent(PacketNumberSpace packetNumberSpaceIn, PacketNum packetNumberIn);
+    explicit PacketEvent(CloneGroupId cloneGroupIn);
 };
 
-// To work with F14 Set:
 bool operator==(const PacketEvent& lhs, const PacketEvent& rhs);
 
-struct PacketEventHash {
-    size_t operator()(const PacketEvent& packetEvent) const noexcept;
+/**
+ * Clone groups of a connection, indexed by group id. Each group counts the
+ * outstanding packets carrying its PacketEvent and the id is reused once the
+ * last of them leaves the outstandings, so the table stays as small as the
+ * number of clone groups in flight, and checking a group takes no hashing.
+ */
+class CloneGroupTable {
+public:
+    // Opens a pending group referenced by the packet being cloned.
+    PacketEvent open();
+
+    // Another outstanding packet, i.e. a clone, now carries event.
+    void addRef(const PacketEvent& event);
+
+    // An outstanding packet carrying event was removed from the outstandings.
+    void release(const PacketEvent& event);
+
+    // Whether the frames of the group still need processing on ack or loss.
+    [[nodiscard]] bool isPending(const PacketEvent& event) const;
+
+    void markProcessed(const PacketEvent& event);
+
+    [[nodiscard]] size_t numPending() const {
+        return numPending_;
+    }
+
+    [[nodiscard]] bool hasPending() const {
+        return numPending_ != 0;
+    }
+
+    void clear();
+
+private:
+    struct Group {
+        uint32_t refCount{0};
+        bool pending{false};
+    };
+
+    std::vector<Group> groups_;
+    std::vector<CloneGroupId> freeIds_;
+    size_t numPending_{0};
 };
 
 } // namespace quic
@@ -8,6 +8,8 @@
 #include "common/TimeUtil.h"
 #include "quic_ack_frequency_function.h"
 
+#include <algorithm>
+
 namespace quic {
 
 bool canSendAckControlFrames(const QuicConnectionStateBase& conn) {
@@ -31,6 +33,57 @@ std::chrono::microseconds clampMaxAckDelay(const QuicConnectionStateBase& conn,
     return timeMax(maxAckDelay, conn.peerMinAckDelay.value());
 }
 
+namespace {
+
+// Whether newValue is more than 1/divisor away from oldValue.
+template <typename T>
+bool movedBeyond(const folly::Optional<T>& oldValue, T newValue, uint64_t divisor) {
+    if (!oldValue) {
+        return true;
+    }
+    auto diff = newValue > *oldValue ? newValue - *oldValue : *oldValue - newValue;
+    return diff * divisor > *oldValue;
+}
+
+} // namespace
+
+void updatePeerAckFrequency(QuicConnectionStateBase& conn, TimePoint ackTime) {
+    const auto& config = conn.transportSettings.ackFrequencyControllerConfig;
+    if (!config || !canSendAckControlFrames(conn) || !conn.congestionController ||
+        conn.lossState.srtt == 0us) {
+        return;
+    }
+    auto& state = conn.ackFrequencyControllerState;
+    const auto srtt = conn.lossState.srtt;
+    if (state.lastUpdateTime && ackTime - *state.lastUpdateTime < srtt) {
+        return;
+    }
+
+    // Bytes we send per RTT: the pacing rate is the bandwidth estimate for
+    // model based controllers and cwnd / srtt for the others.
+    uint64_t bytesPerRtt = conn.congestionController->getCongestionWindow();
+    auto bandwidth = conn.congestionController->getBandwidth();
+    if (bandwidth && *bandwidth && bandwidth->unitType == Bandwidth::UnitType::BYTES) {
+        bytesPerRtt = std::min(bytesPerRtt, *bandwidth * srtt);
+    }
+    const uint64_t targetAcksPerRtt = std::max<uint64_t>(config->targetAcksPerRtt, 1);
+    const uint64_t packetsPerRtt = bytesPerRtt / conn.udpSendPacketLen;
+    const uint64_t ackElicitingThreshold = std::clamp(packetsPerRtt / targetAcksPerRtt,
+        config->minAckElicitingThreshold, std::max(config->minAckElicitingThreshold, config->maxAckElicitingThreshold));
+    // The delay only bounds how long the peer sits on an ACK when we send less
+    // than a threshold's worth of packets.
+    const auto maxAckDelay = clampMaxAckDelay(conn, srtt / targetAcksPerRtt);
+
+    if (!movedBeyond(state.ackElicitingThreshold, ackElicitingThreshold, config->changeDivisor) &&
+        !movedBeyond(state.maxAckDelay, maxAckDelay, config->changeDivisor)) {
+        return;
+    }
+    requestPeerAckFrequencyChange(conn, ackElicitingThreshold, maxAckDelay, config->reorderingThreshold);
+    state.ackElicitingThreshold = ackElicitingThreshold;
+    state.maxAckDelay = maxAckDelay;
+    state.lastUpdateTime = ackTime;
+}
+
 /**
  * Send an IMMEDIATE_ACK frame to request the peer to send an ACK immediately
  */
@@ -25,6 +25,13 @@ void requestPeerAckFrequencyChange(QuicConnectionStateBase& conn, uint64_t ackEl
 
 std::chrono::microseconds clampMaxAckDelay(const QuicConnectionStateBase& conn, std::chrono::microseconds maxAckDelay);
 
+/**
+ * Request a new ACK_FREQUENCY from the peer if our sending rate moved enough
+ * since the last request, per transportSettings.ackFrequencyControllerConfig.
+ * Called after each AppData ACK is processed.
+ */
+void updatePeerAckFrequency(QuicConnectionStateBase& conn, TimePoint ackTime);
+
 /**
  * Send an IMMEDIATE_ACK frame to request the peer to send an ACK immediately
  */
@@ -6,32 +6,11 @@
  */
 
 #include "quic_state_function.h"
+#include "congestion_control/congestion_controller_calls.h"
 #include "state/quic_stream_function.h"
+#include "state/stream/stream_send_handlers.h"
 #include "common/TimeUtil.h"
 
-namespace {
-std::deque<quic::OutstandingPacketWrapper>::reverse_iterator
-getPreviousOutstandingPacket(quic::QuicConnectionStateBase& conn,
-    quic::PacketNumberSpace packetNumberSpace,
-    std::deque<quic::OutstandingPacketWrapper>::reverse_iterator from) {
-    
-    return std::find_if(from, conn.outstandings.packets.rend(), [=](const auto& op) {
-        return !op.declaredLost && packetNumberSpace == op.packet.header.getPacketNumberSpace();
-    });
-}
-
-std::deque<quic::OutstandingPacketWrapper>::reverse_iterator
-getPreviousOutstandingPacketIncludingLost(quic::QuicConnectionStateBase& conn,
-    quic::PacketNumberSpace packetNumberSpace,
-    std::deque<quic::OutstandingPacketWrapper>::reverse_iterator from) {
-
-    return std::find_if(from, conn.outstandings.packets.rend(), [=](const auto& op) {
-        return packetNumberSpace == op.packet.header.getPacketNumberSpace();
-    });
-}
-
-} // namespace
-
 namespace quic {
 
 void updateRtt(QuicConnectionStateBase& conn, const std::chrono::microseconds rttSample,
@@ -242,29 +221,29 @@ void increaseNextPacketNum(QuicConnectionStateBase& conn, PacketNumberSpace pnSp
     }
 }
 
-std::deque<OutstandingPacketWrapper>::iterator getFirstOutstandingPacket(
+OutstandingPacketRing::iterator getFirstOutstandingPacket(
     QuicConnectionStateBase& conn, PacketNumberSpace packetNumberSpace) {
-    return getNextOutstandingPacket(conn, packetNumberSpace, conn.outstandings.packets.begin());
+    return getNextOutstandingPacket(conn, packetNumberSpace,
+        conn.outstandings.packets[packetNumberSpace].lowerBound(conn.outstandings.lossScanStart[packetNumberSpace]));
 }
 
-std::deque<OutstandingPacketWrapper>::reverse_iterator getLastOutstandingPacket(
+OutstandingPacketRing::reverse_iterator getLastOutstandingPacket(
     QuicConnectionStateBase& conn, PacketNumberSpace packetNumberSpace) {
-    return getPreviousOutstandingPacket(conn, packetNumberSpace, conn.outstandings.packets.rbegin());
+    auto& packets = conn.outstandings.packets[packetNumberSpace];
+    return std::find_if(packets.rbegin(), packets.rend(), [](const auto& op) { return !op.declaredLost; });
 }
 
-std::deque<OutstandingPacketWrapper>::reverse_iterator
+OutstandingPacketRing::reverse_iterator
 getLastOutstandingPacketIncludingLost(QuicConnectionStateBase& conn, PacketNumberSpace packetNumberSpace) {
-    return getPreviousOutstandingPacketIncludingLost(conn, packetNumberSpace, conn.outstandings.packets.rbegin());
+    return conn.outstandings.packets[packetNumberSpace].rbegin();
 }
 
-std::deque<OutstandingPacketWrapper>::iterator getNextOutstandingPacket(
+OutstandingPacketRing::iterator getNextOutstandingPacket(
     QuicConnectionStateBase& conn, PacketNumberSpace packetNumberSpace,
-    std::deque<OutstandingPacketWrapper>::iterator from) {
+    OutstandingPacketRing::iterator from) {
 
     return std::find_if(
-        from, conn.outstandings.packets.end(), [=](const auto& op) {
-            return !op.declaredLost && packetNumberSpace == op.packet.header.getPacketNumberSpace();
-        });
+        from, conn.outstandings.packets[packetNumberSpace].end(), [](const auto& op) { return !op.declaredLost; });
 }
 
 bool hasReceivedPacketsAtLastCloseSent(const QuicConnectionStateBase& conn) noexcept {
@@ -406,4 +385,161 @@ bool streamRetransmissionDisabled(QuicConnectionStateBase& conn, const QuicStrea
     return noRetransmissions;
 }
 
+bool streamDataExpired(const QuicStreamState& stream, TimePoint now) {
+    return stream.expiryTime && now >= *stream.expiryTime;
+}
+
+std::vector<StreamId> getExpiredLossStreams(QuicConnectionStateBase& conn, TimePoint now) {
+    std::vector<StreamId> expiredStreams;
+    auto& streamManager = *conn.streamManager;
+    auto collect = [&](const auto& lossStreams) {
+        for (auto id : lossStreams) {
+            auto stream = streamManager.findStream(id);
+            if (stream && stream->sendState == StreamSendState::Open && streamDataExpired(*stream, now) &&
+                std::find(expiredStreams.begin(), expiredStreams.end(), id) == expiredStreams.end()) {
+                expiredStreams.push_back(id);
+            }
+        }
+    };
+    collect(streamManager.lossStreams());
+    collect(streamManager.lossDSRStreams());
+    return expiredStreams;
+}
+
+bool isCongestionLimitingWrites(const QuicConnectionStateBase& conn) {
+    return conn.congestionController &&
+        congestionControllerWritableBytes(conn) < conn.flowControlState.sumCurStreamBufferLen;
+}
+
+void updateBandwidthEstimate(QuicConnectionStateBase& conn, TimePoint ackTime) {
+    auto& state = conn.bandwidthEstimateState;
+    if (!state.interval || !conn.congestionController) {
+        return;
+    }
+    const auto& lossState = conn.lossState;
+    auto startInterval = [&]() {
+        state.intervalStart = ackTime;
+        state.totalBytesAckedAtStart = lossState.totalBytesAcked;
+        state.totalPacketsSentAtStart = lossState.totalPacketsSent;
+        state.totalPacketsMarkedLostAtStart = lossState.totalPacketsMarkedLost;
+        state.cwndLimited = false;
+    };
+    if (!state.intervalStart) {
+        startInterval();
+        return;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(ackTime - *state.intervalStart);
+    if (elapsed < *state.interval || elapsed <= 0us) {
+        return;
+    }
+
+    auto deliveryRate = static_cast<double>(lossState.totalBytesAcked - state.totalBytesAckedAtStart) * 1e6 /
+        static_cast<double>(elapsed.count());
+    auto type = conn.congestionController->type();
+    if (type == CongestionControlType::BBR || type == CongestionControlType::BBRTesting ||
+        type == CongestionControlType::BBR2) {
+        // Their samplers already filter out ACK compression and app-limited
+        // samples, so use them rather than the ACK rate.
+        auto bandwidth = conn.congestionController->getBandwidth();
+        if (bandwidth && *bandwidth && bandwidth->unitType == Bandwidth::UnitType::BYTES) {
+            deliveryRate = static_cast<double>(bandwidth->normalize());
+        }
+    }
+    // BBR's estimate jumps with its probing gain cycle, so it is smoothed too.
+    state.smoothedDeliveryRate = state.smoothedDeliveryRate == 0
+        ? deliveryRate
+        : (1 - kBandwidthEstimateSmoothing) * state.smoothedDeliveryRate + kBandwidthEstimateSmoothing * deliveryRate;
+
+    BandwidthEstimate estimate;
+    estimate.deliveryRateBitsPerSec = static_cast<uint64_t>(state.smoothedDeliveryRate) * 8;
+    if (lossState.mrtt != kDefaultMinRtt) {
+        estimate.minRtt = lossState.mrtt;
+    }
+    estimate.congestionWindow = congestionControllerWindow(conn);
+    estimate.cwndLimited = state.cwndLimited || isCongestionLimitingWrites(conn);
+    estimate.appLimited = conn.congestionController->isAppLimited();
+    auto sentPackets = lossState.totalPacketsSent - state.totalPacketsSentAtStart;
+    if (sentPackets > 0) {
+        estimate.lossRate = std::min(1.0,
+            static_cast<double>(lossState.totalPacketsMarkedLost - state.totalPacketsMarkedLostAtStart) /
+                static_cast<double>(sentPackets));
+    }
+    conn.pendingEvents.bandwidthEstimate = estimate;
+    startInterval();
+}
+
+void updateEcnState(
+    QuicConnectionStateBase& conn, PacketNumberSpace pnSpace, const ReadAckFrame& frame, AckEvent& ack) {
+    auto& ecn = conn.ecnState;
+    // Only ACKs that raise the largest acked are used, older ones may carry
+    // older counts.
+    if (!ecn.isMarking() || frame.implicit || !ack.largestNewlyAckedPacket ||
+        *ack.largestNewlyAckedPacket != frame.largestAcked) {
+        return;
+    }
+    auto newlyAcked = static_cast<uint64_t>(ack.ackedPackets.size());
+    auto& ackState = getAckState(conn, pnSpace);
+    if (frame.frameType != FrameType::ACK_ECN || frame.ecnECT0Count < ackState.ecnECT0CountEchoed ||
+        frame.ecnECT1Count < ackState.ecnECT1CountEchoed || frame.ecnCECount < ackState.ecnCECountEchoed) {
+        // Marked packets acked without counts: something on the path cleared
+        // the marks, or the peer doesn't report them.
+        ecn.state = ECNState::FailedValidation;
+        return;
+    }
+    auto ect0 = frame.ecnECT0Count - ackState.ecnECT0CountEchoed;
+    auto ect1 = frame.ecnECT1Count - ackState.ecnECT1CountEchoed;
+    auto ce = frame.ecnCECount - ackState.ecnCECountEchoed;
+    ackState.ecnECT0CountEchoed = frame.ecnECT0Count;
+    ackState.ecnECT1CountEchoed = frame.ecnECT1Count;
+    ackState.ecnCECountEchoed = frame.ecnCECount;
+    // Every newly acked packet has to be counted, with the codepoint it was
+    // sent with or CE, and the other codepoint must not show up.
+    auto sent = ecn.isL4s() ? ect1 : ect0;
+    auto other = ecn.isL4s() ? ect0 : ect1;
+    if (sent + ce < newlyAcked || other > 0) {
+        ecn.state = ECNState::FailedValidation;
+        return;
+    }
+    if (ecn.state == ECNState::AttemptingECN || ecn.state == ECNState::AttemptingL4S) {
+        ecn.validatedPackets += newlyAcked;
+        if (ecn.validatedPackets >= kEcnValidationPackets) {
+            ecn.state = ecn.isL4s() ? ECNState::ValidatedL4S : ECNState::ValidatedECN;
+        }
+    }
+    ack.ecnCEMarkedPackets = std::min(ce, newlyAcked);
+
+    if (ecn.isL4s() && pnSpace == PacketNumberSpace::AppData) {
+        ack.ecnCEMarkedPackets = ecn.updateL4sAlpha(newlyAcked, ack.ecnCEMarkedPackets, *ack.largestNewlyAckedPacket,
+            conn.ackStates.appDataAckState.nextPacketNum - 1);
+    }
+}
+
+std::vector<StreamId> getDroppableMediaStreams(QuicConnectionStateBase& conn) {
+    std::vector<StreamId> droppableStreams;
+    auto& streamManager = *conn.streamManager;
+    if (streamManager.mediaStreams().empty() || !isCongestionLimitingWrites(conn)) {
+        return droppableStreams;
+    }
+    auto& mediaStreams = streamManager.mediaStreams();
+    for (auto it = mediaStreams.begin(); it != mediaStreams.end();) {
+        // Advance first, the current id may be removed from the set below.
+        auto streamId = *it++;
+        auto stream = streamManager.findStream(streamId);
+        if (!stream || stream->sendState != StreamSendState::Open ||
+            stream->mediaRanges.empty() ||
+            stream->mediaRanges.back().end() <= stream->currentWriteOffset) {
+            if (stream) {
+                stream->mediaRanges.clear();
+            }
+            streamManager.removeMediaStream(streamId);
+            continue;
+        }
+        if (stream->hasOnlyUnsentDroppableData()) {
+            droppableStreams.push_back(streamId);
+            streamManager.removeMediaStream(streamId);
+        }
+    }
+    return droppableStreams;
+}
+
 } // namespace quic
@@ -50,15 +50,15 @@ void increaseNextPacketNum(QuicConnectionStateBase& conn, PacketNumberSpace pnSp
 uint64_t updateLargestReceivedPacketNum(QuicConnectionStateBase& conn, AckState& ackState,
     PacketNum packetNum, TimePoint receivedTime);
 
-std::deque<OutstandingPacketWrapper>::iterator getNextOutstandingPacket(QuicConnectionStateBase& conn,
-    PacketNumberSpace packetNumberSpace, std::deque<OutstandingPacketWrapper>::iterator from);
-std::deque<OutstandingPacketWrapper>::iterator getFirstOutstandingPacket(QuicConnectionStateBase& conn,
+OutstandingPacketRing::iterator getNextOutstandingPacket(QuicConnectionStateBase& conn,
+    PacketNumberSpace packetNumberSpace, OutstandingPacketRing::iterator from);
+OutstandingPacketRing::iterator getFirstOutstandingPacket(QuicConnectionStateBase& conn,
     PacketNumberSpace packetNumberSpace);
 
-std::deque<OutstandingPacketWrapper>::reverse_iterator getLastOutstandingPacket(
+OutstandingPacketRing::reverse_iterator getLastOutstandingPacket(
     QuicConnectionStateBase& conn, PacketNumberSpace packetNumberSpace);
 
-std::deque<OutstandingPacketWrapper>::reverse_iterator
+OutstandingPacketRing::reverse_iterator
 getLastOutstandingPacketIncludingLost(QuicConnectionStateBase& conn, PacketNumberSpace packetNumberSpace);
 
 bool hasReceivedPackets(const QuicConnectionStateBase& conn) noexcept;
@@ -88,4 +88,49 @@ bool checkCustomRetransmissionProfilesEnabled(const QuicConnectionStateBase& con
  */
 bool streamRetransmissionDisabled(QuicConnectionStateBase& conn, const QuicStreamState& stream);
 
+/**
+ * Checks if the data on the stream is past its expiry deadline at time now.
+ */
+bool streamDataExpired(const QuicStreamState& stream, TimePoint now);
+
+/**
+ * Returns the open streams with lost data waiting to be retransmitted that are
+ * past their expiry deadline at time now. The transport resets them instead,
+ * so the peer skips the stale data instead of waiting for it.
+ */
+std::vector<StreamId> getExpiredLossStreams(QuicConnectionStateBase& conn, TimePoint now);
+
+/**
+ * Checks if the congestion window is too small to send all the stream data
+ * currently buffered. Media tags on stream data only take effect then.
+ */
+bool isCongestionLimitingWrites(const QuicConnectionStateBase& conn);
+
+/**
+ * Once the bandwidth estimate interval has passed, sets
+ * pendingEvents.bandwidthEstimate from the counters since its start and starts
+ * the next one. Does nothing unless the app subscribed to the estimates.
+ * Called after each AppData ACK is processed.
+ */
+void updateBandwidthEstimate(QuicConnectionStateBase& conn, TimePoint ackTime);
+
+/**
+ * Validates the ECN counts of frame against the packets it newly acks, and
+ * stops marking on a mismatch or if they are missing. Sets
+ * ack.ecnCEMarkedPackets to the newly acked packets marked CE, and for L4S
+ * updates conn.ecnState.l4sAlpha once per round and leaves out the marks of
+ * the first AppData flight. Called for each ACK before the congestion
+ * controller sees it.
+ */
+void updateEcnState(
+    QuicConnectionStateBase& conn, PacketNumberSpace pnSpace, const ReadAckFrame& frame, AckEvent& ack);
+
+/**
+ * While writes are congestion limited, returns the media streams whose
+ * buffered data is all droppable and unsent, for the transport to reset with
+ * their droppableErrorCode. Also stops tracking media streams that have no
+ * tagged data left to send.
+ */
+std::vector<StreamId> getDroppableMediaStreams(QuicConnectionStateBase& conn);
+
 } // namespace quic
@@ -51,6 +51,27 @@ void writeDataToQuicStream(QuicStreamState& stream, Buf data, bool eof) {
     stream.conn.streamManager->updateWritableStreams(stream);
 }
 
+void writeDataToQuicStream(QuicStreamState& stream, Buf data, bool eof, MediaDataType type) {
+    uint64_t len = data ? data->computeChainDataLength() : 0;
+    if (len > 0 && type != MediaDataType::Unspecified) {
+        auto& ranges = stream.mediaRanges;
+        while (!ranges.empty() && ranges.front().end() <= stream.currentWriteOffset) {
+            ranges.pop_front();
+        }
+        auto offset = stream.currentWriteOffset + stream.writeBuffer.chainLength();
+        // Droppable writes stay separate so a frame that has not been sent
+        // can still be dropped after an earlier one went out.
+        if (!ranges.empty() && type != MediaDataType::Droppable && ranges.back().type == type &&
+            ranges.back().end() == offset) {
+            ranges.back().length += len;
+        } else {
+            ranges.emplace_back(offset, len, type);
+        }
+        stream.conn.streamManager->addMediaStream(stream.id);
+    }
+    writeDataToQuicStream(stream, std::move(data), eof);
+}
+
 void writeBufMetaToQuicStream(QuicStreamState& stream, const BufferMeta& data, bool eof) {
     if (data.length > 0) {
         maybeWriteBlockAfterAPIWrite(stream);
@@ -20,6 +20,14 @@ namespace quic {
  */
 void writeDataToQuicStream(QuicStreamState& stream, Buf data, bool eof);
 
+/**
+ * Same as above, and tags the data with its media type so the scheduler can
+ * favour or drop it when the congestion window is limited.
+ *
+ * @throws QuicTransportException on error.
+ */
+void writeDataToQuicStream(QuicStreamState& stream, Buf data, bool eof, MediaDataType type);
+
 /**
  * Adds data represented in the form of BufferMeta to the end of the Buffer
  * Meta queue of the stream.
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <folly/Optional.h>
 #include "protocol/quic_constants.hpp"
 
 namespace quic {
@@ -19,6 +20,12 @@ struct QuicStreamGroupRetransmissionPolicy {
 
     // Disables retransmission. completely.
     bool disableRetransmission{false};
+
+    // Lifetime of the data on streams created in this group, measured from
+    // stream creation. Once it has passed, lost data is dropped instead of
+    // retransmitted and the stream is reset with expiryErrorCode.
+    folly::Optional<std::chrono::microseconds> dataExpiry;
+    ApplicationErrorCode expiryErrorCode{GenericApplicationErrorCode::NO_ERROR};
 };
 
 } // namespace quic
@@ -134,7 +134,7 @@ QuicStreamState* QuicStreamManager::findStream(StreamId streamId) {
     if (lookup == streams_.end()) {
         return nullptr;
     } else {
-        return &lookup->second;
+        return lookup->second.get();
     }
 }
 
@@ -236,13 +236,10 @@ QuicStreamManager::getOrCreateOpenedLocalStream(StreamId streamId) {
     auto& openLocalStreams = isUnidirectionalStream(streamId) ? openUnidirectionalLocalStreams_ : openBidirectionalLocalStreams_;
     if (openLocalStreams.count(streamId)) {
         // Open a lazily created stream.
-        auto it = streams_.emplace(std::piecewise_construct, std::forward_as_tuple(streamId), std::forward_as_tuple(streamId, conn_));
+        auto stream = emplaceStreamState(streamId, folly::none);
         QUIC_STATS(conn_.statsCallback, onNewQuicStream);
-        if (!it.second) {
-            throw QuicTransportException("Creating an active stream", TransportErrorCode::STREAM_STATE_ERROR);
-        }
-        addToStreamPriorityMap(it.first->second);
-        return &it.first->second;
+        addToStreamPriorityMap(*stream);
+        return stream;
     }
     return nullptr;
 }
@@ -257,7 +254,7 @@ QuicStreamState* QuicStreamManager::getStream(StreamId streamId,
     }
     auto it = streams_.find(streamId);
     if (it != streams_.end()) {
-        return &it->second;
+        return it->second.get();
     }
     auto stream = getOrCreateOpenedLocalStream(streamId);
     auto nextAcceptableStreamId = isUnidirectionalStream(streamId) ? nextAcceptableLocalUnidirectionalStreamId_ : nextAcceptableLocalBidirectionalStreamId_;
@@ -291,6 +288,40 @@ QuicStreamManager::createNextUnidirectionalStream(folly::Optional<StreamGroupId>
     return stream;
 }
 
+folly::Expected<std::vector<QuicStreamState*>, LocalErrorCode>
+QuicStreamManager::createNextBidirectionalStreams(uint64_t numStreams, folly::Optional<StreamGroupId> streamGroupId) {
+    return createNextStreams(nextBidirectionalStreamId_, openableLocalBidirectionalStreams(), numStreams, streamGroupId);
+}
+
+folly::Expected<std::vector<QuicStreamState*>, LocalErrorCode>
+QuicStreamManager::createNextUnidirectionalStreams(uint64_t numStreams, folly::Optional<StreamGroupId> streamGroupId) {
+    return createNextStreams(nextUnidirectionalStreamId_, openableLocalUnidirectionalStreams(), numStreams, streamGroupId);
+}
+
+folly::Expected<std::vector<QuicStreamState*>, LocalErrorCode>
+QuicStreamManager::createNextStreams(StreamId& nextStreamId, uint64_t openableStreams, uint64_t numStreams,
+    const folly::Optional<StreamGroupId>& streamGroupId) {
+    // Check the limit up front so that we never leave a partially opened batch.
+    if (numStreams > openableStreams) {
+        return folly::makeUnexpected(LocalErrorCode::STREAM_LIMIT_EXCEEDED);
+    }
+    std::vector<QuicStreamState*> result;
+    result.reserve(numStreams);
+    streams_.reserve(streams_.size() + numStreams);
+    streamPriorityLevelsNoCtrl_.reserve(streamPriorityLevelsNoCtrl_.size() + numStreams);
+    auto& openLocalStreams = isUnidirectionalStream(nextStreamId) ? openUnidirectionalLocalStreams_ : openBidirectionalLocalStreams_;
+    openLocalStreams.reserve(openLocalStreams.size() + numStreams);
+    for (uint64_t i = 0; i < numStreams; ++i) {
+        auto stream = createStream(nextStreamId, streamGroupId);
+        if (stream.hasError()) {
+            return folly::makeUnexpected(stream.error());
+        }
+        nextStreamId += detail::kStreamIncrement;
+        result.push_back(stream.value());
+    }
+    return result;
+}
+
 QuicStreamState* FOLLY_NULLABLE QuicStreamManager::instantiatePeerStream(
     StreamId streamId, folly::Optional<StreamGroupId> groupId) {
     if (groupId && (peerStreamGroupsSeen_.find(*groupId) == peerStreamGroupsSeen_.cend())) {
@@ -305,10 +336,36 @@ QuicStreamState* FOLLY_NULLABLE QuicStreamManager::instantiatePeerStream(
             newGroupedPeerStreams_.push_back(streamId);
         }
     }
-    auto it = streams_.emplace(std::piecewise_construct, std::forward_as_tuple(streamId), std::forward_as_tuple(streamId, groupId, conn_));
-    addToStreamPriorityMap(it.first->second);
+    auto stream = emplaceStreamState(streamId, groupId);
+    addToStreamPriorityMap(*stream);
     QUIC_STATS(conn_.statsCallback, onNewQuicStream);
-    return &it.first->second;
+    return stream;
+}
+
+QuicStreamState* FOLLY_NONNULL QuicStreamManager::emplaceStreamState(
+    StreamId streamId, const folly::Optional<StreamGroupId>& groupId) {
+    auto it = streams_.try_emplace(streamId);
+    if (!it.second) {
+        throw QuicTransportException("Creating an active stream", TransportErrorCode::STREAM_STATE_ERROR);
+    }
+    auto& stream = it.first->second;
+    if (!streamStatePool_.empty()) {
+        stream = std::move(streamStatePool_.back());
+        streamStatePool_.pop_back();
+        stream->reinitialize(streamId, groupId);
+    } else {
+        stream = std::make_unique<QuicStreamState>(streamId, groupId, conn_);
+    }
+    if (groupId) {
+        // Streams inherit the data expiry of their group's retransmission
+        // policy, if any.
+        const auto policyIt = conn_.retransmissionPolicies.find(*groupId);
+        if (policyIt != conn_.retransmissionPolicies.cend() && policyIt->second.dataExpiry) {
+            stream->expiryTime = Clock::now() + *policyIt->second.dataExpiry;
+            stream->expiryErrorCode = policyIt->second.expiryErrorCode;
+        }
+    }
+    return stream.get();
 }
 
 folly::Expected<StreamGroupId, LocalErrorCode>
@@ -365,7 +422,7 @@ QuicStreamState* FOLLY_NULLABLE QuicStreamManager::getOrCreatePeerStream(
     // TODO when we can rely on C++17, this is a good candidate for try_emplace.
     auto peerStream = streams_.find(streamId);
     if (peerStream != streams_.end()) {
-        return &peerStream->second;
+        return peerStream->second.get();
     }
     auto& openPeerStreams = isUnidirectionalStream(streamId) ? openUnidirectionalPeerStreams_ : openBidirectionalPeerStreams_;
     if (openPeerStreams.count(streamId)) {
@@ -429,14 +486,31 @@ QuicStreamManager::createStream(StreamId streamId, folly::Optional<StreamGroupId
     if (openedResult != LocalErrorCode::NO_ERROR) {
         return folly::makeUnexpected(openedResult);
     }
-    auto it = streams_.emplace(std::piecewise_construct, std::forward_as_tuple(streamId), std::forward_as_tuple(streamId, streamGroupId, conn_));
-    addToStreamPriorityMap(it.first->second);
+    auto stream = emplaceStreamState(streamId, streamGroupId);
+    addToStreamPriorityMap(*stream);
     QUIC_STATS(conn_.statsCallback, onNewQuicStream);
     updateAppIdleState();
-    return &it.first->second;
+    return stream;
 }
 
 void QuicStreamManager::removeClosedStream(StreamId streamId) {
+    removeClosedStreamImpl(streamId);
+    updateAppIdleState();
+    notifyStreamPriorityChanges();
+}
+
+void QuicStreamManager::removeClosedStreams(const std::vector<StreamId>& streamIds) {
+    if (streamIds.empty()) {
+        return;
+    }
+    for (auto streamId : streamIds) {
+        removeClosedStreamImpl(streamId);
+    }
+    updateAppIdleState();
+    notifyStreamPriorityChanges();
+}
+
+void QuicStreamManager::removeClosedStreamImpl(StreamId streamId) {
     auto it = streams_.find(streamId);
     if (it == streams_.end()) {
         //VLOG(10) << "Trying to remove already closed stream=" << streamId;
@@ -446,24 +520,31 @@ void QuicStreamManager::removeClosedStream(StreamId streamId) {
     //DCHECK(it->second.inTerminalStates());
     readableStreams_.erase(streamId);
     peekableStreams_.erase(streamId);
-    removeWritable(it->second);
+    removeWritable(*it->second);
     blockedStreams_.erase(streamId);
     deliverableStreams_.erase(streamId);
     txStreams_.erase(streamId);
     windowUpdates_.erase(streamId);
     stopSendingStreams_.erase(streamId);
     flowControlUpdated_.erase(streamId);
-    if (!it->second.isControl) {
+    mediaStreams_.erase(streamId);
+    if (!it->second->isControl) {
         const auto streamPriorityIt = streamPriorityLevelsNoCtrl_.find(streamId);
         if (streamPriorityIt == streamPriorityLevelsNoCtrl_.end()) {
             throw QuicTransportException("Removed stream is not in the priority map", TransportErrorCode::STREAM_STATE_ERROR);
         }
         streamPriorityLevelsNoCtrl_.erase(streamPriorityIt);
     }
-    if (it->second.isControl) {
+    if (it->second->isControl) {
         //DCHECK_GT(numControlStreams_, 0);
         numControlStreams_--;
     }
+    if (streamStatePool_.size() < transportSettings_->maxPooledStreamStates) {
+        // Drop the buffered data now, but keep the containers around for the
+        // next stream that gets created on this connection.
+        it->second->reinitialize(streamId, folly::none);
+        streamStatePool_.push_back(std::move(it->second));
+    }
     streams_.erase(it);
     QUIC_STATS(conn_.statsCallback, onQuicStreamClosed);
     if (isRemoteStream(nodeType_, streamId)) {
@@ -493,9 +574,6 @@ void QuicStreamManager::removeClosedStream(StreamId streamId) {
         auto& openLocalStreams = isUnidirectionalStream(streamId) ? openUnidirectionalLocalStreams_ : openBidirectionalLocalStreams_;
         openLocalStreams.erase(streamId);
     }
-
-    updateAppIdleState();
-    notifyStreamPriorityChanges();
 }
 
 void QuicStreamManager::updateReadableStreams(QuicStreamState& stream) {
@@ -116,6 +116,7 @@ public:
         txStreams_ = std::move(other.txStreams_);
         deliverableStreams_ = std::move(other.deliverableStreams_);
         closedStreams_ = std::move(other.closedStreams_);
+        mediaStreams_ = std::move(other.mediaStreams_);
         isAppIdle_ = other.isAppIdle_;
         maxLocalBidirectionalStreamIdIncreased_ = other.maxLocalBidirectionalStreamIdIncreased_;
         maxLocalUnidirectionalStreamIdIncreased_ = other.maxLocalUnidirectionalStreamIdIncreased_;
@@ -125,8 +126,8 @@ public:
          * QuicStreamState(s) hold a reference to the other.conn_.
          */
         for (auto& pair : other.streams_) {
-            streams_.emplace(std::piecewise_construct, std::forward_as_tuple(pair.first),
-                std::forward_as_tuple(/* migrate state to new conn ref */ conn_, std::move(pair.second)));
+            streams_.emplace(pair.first,
+                std::make_unique<QuicStreamState>(/* migrate state to new conn ref */ conn_, std::move(*pair.second)));
         }
     }
     /*
@@ -158,6 +159,22 @@ public:
     folly::Expected<QuicStreamState*, LocalErrorCode>
     createNextUnidirectionalStream(folly::Optional<StreamGroupId> streamGroupId = folly::none);
 
+    /*
+    * Create the next numStreams bidirectional streams at once. Either all of
+    * the streams are created, or none are and STREAM_LIMIT_EXCEEDED is
+    * returned.
+    */
+    folly::Expected<std::vector<QuicStreamState*>, LocalErrorCode>
+    createNextBidirectionalStreams(uint64_t numStreams, folly::Optional<StreamGroupId> streamGroupId = folly::none);
+
+    /*
+    * Create the next numStreams unidirectional streams at once. Either all of
+    * the streams are created, or none are and STREAM_LIMIT_EXCEEDED is
+    * returned.
+    */
+    folly::Expected<std::vector<QuicStreamState*>, LocalErrorCode>
+    createNextUnidirectionalStreams(uint64_t numStreams, folly::Optional<StreamGroupId> streamGroupId = folly::none);
+
     /*
     * Return the stream state or create it if the state has not yet been created.
     * Note that this is only valid for streams that are currently open.
@@ -169,6 +186,13 @@ public:
     */
     void removeClosedStream(StreamId streamId);
 
+    /*
+    * Remove all the state for a batch of streams that are being closed. The
+    * app-idle state and the priority observer are only updated once for the
+    * whole batch.
+    */
+    void removeClosedStreams(const std::vector<StreamId>& streamIds);
+
     /*
     * Update the current readable streams for the given stream state. This will
     * either add or remove it from the collection of currently readable streams.
@@ -291,6 +315,8 @@ public:
         openUnidirectionalLocalStreamGroups_.clear();
         peerStreamGroupsSeen_.clear();
         streams_.clear();
+        streamStatePool_.clear();
+        mediaStreams_.clear();
     }
 
     /*
@@ -306,7 +332,7 @@ public:
     */
     void streamStateForEach(const std::function<void(QuicStreamState&)>& f) {
         for (auto& s : streams_) {
-            f(s.second);
+            f(*s.second);
         }
     }
 
@@ -325,6 +351,14 @@ public:
         return !lossDSRStreams_.empty();
     }
 
+    [[nodiscard]] const auto& lossStreams() const {
+        return lossStreams_;
+    }
+
+    [[nodiscard]] const auto& lossDSRStreams() const {
+        return lossDSRStreams_;
+    }
+
     // Should only used directly by tests.
     void removeLoss(StreamId id) {
         lossStreams_.erase(id);
@@ -656,6 +690,27 @@ public:
         txStreams_.erase(streamId);
     }
 
+    /*
+    * Returns the streams that have media tagged data, ordered by stream id.
+    */
+    [[nodiscard]] const auto& mediaStreams() const {
+        return mediaStreams_;
+    }
+
+    /*
+    * Add a stream to the streams that have media tagged data.
+    */
+    void addMediaStream(StreamId streamId) {
+        mediaStreams_.insert(streamId);
+    }
+
+    /*
+    * Remove a stream from the streams that have media tagged data.
+    */
+    void removeMediaStream(StreamId streamId) {
+        mediaStreams_.erase(streamId);
+    }
+
     /*
     * Pop a TX stream id and return it.
     */
@@ -837,6 +892,13 @@ public:
         return streams_.size();
     }
 
+    /*
+    * Returns the number of closed stream states kept for reuse.
+    */
+    [[nodiscard]] size_t pooledStreamStateCount() const {
+        return streamStatePool_.size();
+    }
+
     /*
     * Returns a const reference to the container of streams with pending
     * StopSending events.
@@ -964,6 +1026,18 @@ private:
     // helper to create a new peer stream.
     QuicStreamState* FOLLY_NULLABLE instantiatePeerStream(StreamId streamId, folly::Optional<StreamGroupId> groupId);
 
+    // Inserts the state for a new stream into streams_, reusing a pooled state
+    // if one is available.
+    QuicStreamState* FOLLY_NONNULL emplaceStreamState(StreamId streamId, const folly::Optional<StreamGroupId>& groupId);
+
+    // Removes the stream from all the bookkeeping structures without updating
+    // the app-idle state or notifying the priority observer.
+    void removeClosedStreamImpl(StreamId streamId);
+
+    folly::Expected<std::vector<QuicStreamState*>, LocalErrorCode> createNextStreams(
+        StreamId& nextStreamId, uint64_t openableStreams, uint64_t numStreams,
+        const folly::Optional<StreamGroupId>& streamGroupId);
+
     folly::Expected<StreamGroupId, LocalErrorCode> createNextStreamGroup(StreamGroupId& groupId,
         folly::F14FastSet<StreamGroupId>& streamGroups);
 
@@ -1058,8 +1132,13 @@ private:
     // Unidirectional stream groups that are opened locally on the connection.
     folly::F14FastSet<StreamGroupId> openUnidirectionalLocalStreamGroups_;
 
-    // A map of streams that are active.
-    folly::F14FastMap<StreamId, QuicStreamState> streams_;
+    // A map of streams that are active. The states are heap allocated so that
+    // they can be recycled through streamStatePool_.
+    folly::F14FastMap<StreamId, std::unique_ptr<QuicStreamState>> streams_;
+
+    // States of removed streams, kept with their buffers' capacity for reuse by
+    // the next created stream. Bounded by TransportSettings::maxPooledStreamStates.
+    std::vector<std::unique_ptr<QuicStreamState>> streamStatePool_;
 
     // Recently opened peer streams.
     std::vector<StreamId> newPeerStreams_;
@@ -1119,6 +1198,10 @@ private:
     // Streams that are closed but we still have state for
     folly::F14FastSet<StreamId> closedStreams_;
 
+    // Streams written with media tags, looked at by the scheduler when the
+    // congestion window is too small for all the buffered data
+    std::set<StreamId> mediaStreams_;
+
     // Observer to notify on changes in the streamPriorityLevels_ map
     QuicStreamPrioritiesObserver* priorityChangesObserver_{nullptr};
 
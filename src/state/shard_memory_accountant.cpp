@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "shard_memory_accountant.h"
+
+namespace quic {
+
+ShardMemoryAccountant& ShardMemoryAccountant::getThreadLocalInstance() {
+    static thread_local ShardMemoryAccountant sAccountant;
+    return sAccountant;
+}
+
+double ShardMemoryAccountant::pressure() const noexcept {
+    if (limit_ == 0) {
+        return bytesUsed_ ? std::numeric_limits<double>::max() : 0.0;
+    }
+    return static_cast<double>(bytesUsed_) / static_cast<double>(limit_);
+}
+
+ShardMemoryAccountant::PressureLevel ShardMemoryAccountant::pressureLevel() const noexcept {
+    auto currentPressure = pressure();
+    if (currentPressure >= severeThreshold_) {
+        return PressureLevel::Severe;
+    }
+    if (currentPressure >= moderateThreshold_) {
+        return PressureLevel::Moderate;
+    }
+    return PressureLevel::None;
+}
+
+uint64_t ShardMemoryAccountant::scaleReceiveWindow(uint64_t windowSize) const noexcept {
+    // Keep some window even under severe pressure so that peers can still
+    // make progress and the memory they hold gets drained by our reads.
+    switch (pressureLevel()) {
+    case PressureLevel::None:
+        return windowSize;
+    case PressureLevel::Moderate:
+        return windowSize / 2;
+    case PressureLevel::Severe:
+        return windowSize / 8;
+    }
+    return windowSize;
+}
+
+uint64_t ShardMemoryAccountant::writeHeadroom() const noexcept {
+    auto severeBytes = static_cast<long double>(limit_) * severeThreshold_;
+    if (severeBytes >= static_cast<long double>(std::numeric_limits<uint64_t>::max())) {
+        return std::numeric_limits<uint64_t>::max() - bytesUsed_;
+    }
+    auto severeLimit = static_cast<uint64_t>(severeBytes);
+    return bytesUsed_ >= severeLimit ? 0 : severeLimit - bytesUsed_;
+}
+
+uint64_t connectionBufferedBytes(const QuicConnectionStateBase& conn) {
+    const auto& flowControlState = conn.flowControlState;
+    uint64_t bufferedBytes = flowControlState.sumCurStreamBufferLen + conn.lossState.inflightBytes;
+    if (flowControlState.sumMaxObservedOffset > flowControlState.sumCurReadOffset) {
+        bufferedBytes += flowControlState.sumMaxObservedOffset - flowControlState.sumCurReadOffset;
+    }
+    for (const auto& datagram : conn.datagramState.readBuffer) {
+        bufferedBytes += datagram.bufQueue().chainLength();
+    }
+    for (const auto& datagram : conn.datagramState.writeBuffer) {
+        bufferedBytes += datagram.chainLength();
+    }
+    return bufferedBytes;
+}
+
+void updateShardMemoryAccounting(QuicConnectionStateBase& conn) {
+    auto bufferedBytes = connectionBufferedBytes(conn);
+    auto& accountant = ShardMemoryAccountant::getThreadLocalInstance();
+    if (bufferedBytes > conn.shardAccountedBytes) {
+        accountant.add(bufferedBytes - conn.shardAccountedBytes);
+    } else {
+        accountant.remove(conn.shardAccountedBytes - bufferedBytes);
+    }
+    conn.shardAccountedBytes = bufferedBytes;
+}
+
+void releaseShardMemoryAccounting(QuicConnectionStateBase& conn) {
+    ShardMemoryAccountant::getThreadLocalInstance().remove(conn.shardAccountedBytes);
+    conn.shardAccountedBytes = 0;
+}
+
+} // namespace quic
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+#include "protocol/quic_constants.hpp"
+#include "state/state_data.h"
+
+namespace quic {
+
+/**
+ * Tracks the bytes held in stream and datagram buffers by all the connections
+ * on a shard, so that a burst of slow peers cannot grow them until the shard
+ * runs out of memory. Per connection limits such as totalBufferSpaceAvailable
+ * still apply on top of this.
+ *
+ * As usage crosses the moderate threshold the receive windows we advertise
+ * shrink, and past the severe threshold applications get no more buffer space
+ * for writes until usage drops again. The limit and thresholds come from
+ * TransportSettings::shardMemoryConfig.
+ */
+class ShardMemoryAccountant {
+public:
+    enum class PressureLevel : uint8_t {
+        None,
+        Moderate,
+        Severe,
+    };
+
+    static ShardMemoryAccountant& getThreadLocalInstance();
+
+    void setLimit(uint64_t limitBytes) noexcept {
+        limit_ = limitBytes;
+    }
+
+    [[nodiscard]] uint64_t limit() const noexcept {
+        return limit_;
+    }
+
+    /**
+     * Thresholds are fractions of the limit, moderate should be below severe.
+     */
+    void setPressureThresholds(double moderate, double severe) noexcept {
+        moderateThreshold_ = moderate;
+        severeThreshold_ = severe;
+    }
+
+    void add(uint64_t bytes) noexcept {
+        bytesUsed_ += bytes;
+    }
+
+    void remove(uint64_t bytes) noexcept {
+        bytesUsed_ -= std::min(bytes, bytesUsed_);
+    }
+
+    [[nodiscard]] uint64_t bytesUsed() const noexcept {
+        return bytesUsed_;
+    }
+
+    /**
+     * Fraction of the limit in use, the shard's memory pressure metric. It can
+     * go above 1 since data already in flight keeps arriving.
+     */
+    [[nodiscard]] double pressure() const noexcept;
+
+    [[nodiscard]] PressureLevel pressureLevel() const noexcept;
+
+    /**
+     * The receive window to advertise instead of windowSize at the current
+     * pressure.
+     */
+    [[nodiscard]] uint64_t scaleReceiveWindow(uint64_t windowSize) const noexcept;
+
+    /**
+     * Bytes applications may still buffer for writing before the severe
+     * threshold is reached.
+     */
+    [[nodiscard]] uint64_t writeHeadroom() const noexcept;
+
+private:
+    uint64_t limit_{kDefaultShardMemoryLimit};
+    double moderateThreshold_{kDefaultShardMemoryModeratePressure};
+    double severeThreshold_{kDefaultShardMemorySeverePressure};
+    uint64_t bytesUsed_{0};
+};
+
+/**
+ * Bytes the connection holds in stream and datagram buffers. Data sent and
+ * waiting for an ACK is counted by the connection's inflight bytes, and
+ * received data by how far the peer has sent past what the application read,
+ * so this is an estimate that costs no more than walking the datagram queues.
+ */
+uint64_t connectionBufferedBytes(const QuicConnectionStateBase& conn);
+
+/**
+ * Reports the change in the connection's buffered bytes since its last update
+ * to the shard's accountant.
+ */
+void updateShardMemoryAccounting(QuicConnectionStateBase& conn);
+
+/**
+ * Removes everything the connection has reported from the shard's accountant.
+ */
+void releaseShardMemoryAccounting(QuicConnectionStateBase& conn);
+
+} // namespace quic
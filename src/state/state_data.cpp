@@ -13,27 +13,31 @@
 namespace quic {
 QuicStreamState::QuicStreamState(StreamId idIn, QuicConnectionStateBase& connIn)
     : conn(connIn), id(idIn) {
+    applyInitialState();
+}
+
+// Sets the flow control windows, directional states and priority that depend
+// on the stream id and the connection's settings.
+void QuicStreamState::applyInitialState() {
     // Note: this will set a windowSize for a locally-initiated unidirectional
     // stream even though that value is meaningless.
-    flowControlState.windowSize = isUnidirectionalStream(idIn)
-        ? conn.transportSettings.advertisedInitialUniStreamWindowSize : isLocalStream(connIn.nodeType, idIn)
-        ? conn.transportSettings.advertisedInitialBidiLocalStreamWindowSize : conn.transportSettings.advertisedInitialBidiRemoteStreamWindowSize;
-    flowControlState.advertisedMaxOffset = isUnidirectionalStream(idIn)
-        ? conn.transportSettings.advertisedInitialUniStreamWindowSize : isLocalStream(connIn.nodeType, idIn)
+    flowControlState.windowSize = isUnidirectionalStream(id)
+        ? conn.transportSettings.advertisedInitialUniStreamWindowSize : isLocalStream(conn.nodeType, id)
         ? conn.transportSettings.advertisedInitialBidiLocalStreamWindowSize : conn.transportSettings.advertisedInitialBidiRemoteStreamWindowSize;
+    flowControlState.advertisedMaxOffset = flowControlState.windowSize;
     // Note: this will set a peerAdvertisedMaxOffset for a peer-initiated
     // unidirectional stream even though that value is meaningless.
-    flowControlState.peerAdvertisedMaxOffset = isUnidirectionalStream(idIn)
-        ? conn.flowControlState.peerAdvertisedInitialMaxStreamOffsetUni : isLocalStream(connIn.nodeType, idIn)
+    flowControlState.peerAdvertisedMaxOffset = isUnidirectionalStream(id)
+        ? conn.flowControlState.peerAdvertisedInitialMaxStreamOffsetUni : isLocalStream(conn.nodeType, id)
         ? conn.flowControlState.peerAdvertisedInitialMaxStreamOffsetBidiRemote : conn.flowControlState.peerAdvertisedInitialMaxStreamOffsetBidiLocal;
-    if (isUnidirectionalStream(idIn)) {
-        if (isLocalStream(connIn.nodeType, idIn)) {
+    if (isUnidirectionalStream(id)) {
+        if (isLocalStream(conn.nodeType, id)) {
             recvState = StreamRecvState::Invalid;
         } else {
             sendState = StreamSendState::Invalid;
         }
     }
-    priority = connIn.transportSettings.defaultPriority;
+    priority = conn.transportSettings.defaultPriority;
 }
 
 QuicStreamState::QuicStreamState(StreamId idIn, const folly::Optional<StreamGroupId>& groupIdIn, QuicConnectionStateBase& connIn)
@@ -41,6 +45,47 @@ QuicStreamState::QuicStreamState(StreamId idIn, const folly::Optional<StreamGrou
     groupId = groupIdIn;
 }
 
+void QuicStreamState::reinitialize(StreamId idIn, const folly::Optional<StreamGroupId>& groupIdIn) {
+    // QuicStreamLike fields
+    readBuffer.clear();
+    writeBuffer.move();
+    retransmissionBuffer.clear();
+    ackedIntervals.clear();
+    lossBuffer.clear();
+    currentWriteOffset = 0;
+    minimumRetransmittableOffset = 0;
+    currentReadOffset = 0;
+    currentReceiveOffset = 0;
+    maxOffsetObserved = 0;
+    finalReadOffset.reset();
+    numPacketsTxWithNewData = 0;
+
+    // QuicStreamState fields
+    id = idIn;
+    groupId = groupIdIn;
+    finalWriteOffset.reset();
+    flowControlState = StreamFlowControlState();
+    streamReadError.reset();
+    streamWriteError.reset();
+    sendState = StreamSendState::Open;
+    recvState = StreamRecvState::Open;
+    isControl = false;
+    lastHolbTime.reset();
+    totalHolbTime = 0us;
+    holbCount = 0;
+    streamPacketIdx = 0;
+    dsrSender.reset();
+    writeBufMeta = WriteBufferMeta();
+    retransmissionBufMetas.clear();
+    lossBufMetas.clear();
+    streamLossCount = 0;
+    expiryTime.reset();
+    expiryErrorCode = GenericApplicationErrorCode::NO_ERROR;
+    mediaRanges.clear();
+    droppableErrorCode = GenericApplicationErrorCode::NO_ERROR;
+    applyInitialState();
+}
+
 std::ostream& operator<<(std::ostream& os, const QuicConnectionStateBase& st) {
     if (st.clientConnectionId) {
         os << "client CID=" << *st.clientConnectionId;
@@ -127,4 +172,25 @@ bool QuicConnectionStateBase::retireAndSwitchPeerConnectionIds() {
   return true;
 }
 
+void OutstandingsInfo::moveZeroRttPacketsTo(OutstandingsInfo& to) {
+    for (auto space : {PacketNumberSpace::Initial, PacketNumberSpace::Handshake, PacketNumberSpace::AppData}) {
+        for (auto& outstandingPacket : packets[space]) {
+            auto& packetHeader = outstandingPacket.packet.header;
+            if (packetHeader.getProtectionType() != ProtectionType::ZeroRtt) {
+                if (outstandingPacket.associatedEvent) {
+                    cloneGroups.release(*outstandingPacket.associatedEvent);
+                }
+                continue;
+            }
+            if (outstandingPacket.associatedEvent) {
+                to.clonedPacketCount[space]++;
+            }
+            to.packets[space].emplace(packetHeader.getPacketSequenceNum(), std::move(outstandingPacket));
+            to.packetCount[space]++;
+        }
+    }
+    to.cloneGroups = std::move(cloneGroups);
+    cloneGroups.clear();
+}
+
 } // namespace quic
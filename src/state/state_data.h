@@ -19,14 +19,20 @@
 
 #include "common/BufAccessor.h"
 #include "congestion_control/congestion_controller.h"
+#include "congestion_control/congestion_controller_dispatch.h"
 #include "congestion_control/packet_processor.h"
 #include "handshake/handshake_layer.hpp"
 #include "observer/SocketObserverTypes.h"
 #include "state/ack_event.h"
+#include "state/ack_receive_timestamps.h"
+#include "state/bandwidth_estimate.h"
+#include "state/congestion_snapshot.h"
+#include "state/ecn_state.h"
 #include "state/loss_state.h"
 #include "logging/qlogger.h"
 #include "state/ack_states.h"
 #include "state/outstanding_packet.h"
+#include "state/outstanding_packet_ring.h"
 #include "state/packet_event.h"
 #include "state/quic_connection_stats.h"
 #include "state/transport_setting.h"
@@ -38,6 +44,7 @@
 
 
 
+#include <folly/Function.h>
 #include <folly/Optional.h>
 #include <folly/io/IOBuf.h>
 #include <folly/io/async/AsyncUDPSocket.h>
@@ -99,13 +106,14 @@ struct NetworkDataSingle {
 };
 
 struct OutstandingsInfo {
-    // Sent packets which have not been acked. These are sorted by PacketNum.
-    std::deque<OutstandingPacketWrapper> packets;
+    // Sent packets which have not been acked, one PacketNum-indexed ring per
+    // packet number space.
+    OutstandingPacketRings packets;
 
-    // All PacketEvents of this connection. If a OutstandingPacketWrapper doesn't
-    // have an associatedEvent or if it's not in this set, there is no need to
-    // process its frames upon ack or loss.
-    folly::F14FastSet<PacketEvent, PacketEventHash> packetEvents;
+    // Clone groups of this connection. If a OutstandingPacketWrapper doesn't
+    // have an associatedEvent or if its group is no longer pending, there is
+    // no need to process its frames upon ack or loss.
+    CloneGroupTable cloneGroups;
 
     // Number of outstanding packets not including cloned
     EnumArray<PacketNumberSpace, uint64_t> packetCount{};
@@ -116,14 +124,31 @@ struct OutstandingsInfo {
     // Number of packets currently declared lost.
     uint64_t declaredLostCount{0};
 
+    // Per space, every outstanding packet numbered below this is declared lost.
+    // Only moves forward as packets are declared lost in order, so loss
+    // detection and getFirstOutstandingPacket() start here instead of walking
+    // over the lost packets awaiting reaping.
+    EnumArray<PacketNumberSpace, PacketNum> lossScanStart{};
+
     // Number of outstanding inflight DSR packet. That is, when a DSR packet is
     // declared lost, this counter will be decreased.
     uint64_t dsrCount{0};
 
+    // Number of packets held across all packet number spaces, including the
+    // ones declared lost.
+    [[nodiscard]] uint64_t numPackets() const {
+        return packets[PacketNumberSpace::Initial].size() + packets[PacketNumberSpace::Handshake].size() +
+            packets[PacketNumberSpace::AppData].size();
+    }
+
+    [[nodiscard]] bool empty() const {
+        return numPackets() == 0;
+    }
+
     // Number of packets outstanding and not declared lost.
     uint64_t numOutstanding() {
-        //CHECK_GE(packets.size(), declaredLostCount);
-        return packets.size() - declaredLostCount;
+        //CHECK_GE(numPackets(), declaredLostCount);
+        return numPackets() - declaredLostCount;
     }
 
     // Total number of cloned packets.
@@ -132,12 +157,23 @@ struct OutstandingsInfo {
             clonedPacketCount[PacketNumberSpace::AppData];
     }
 
+    /**
+     * Moves the zero rtt packets into to, a fresh connection state's
+     * outstandings, along with the clone groups they carry. Clone group ids
+     * are only meaningful in the table they were opened in, so the table goes
+     * with them, minus the references of the packets left behind.
+     */
+    void moveZeroRttPacketsTo(OutstandingsInfo& to);
+
     void reset() {
-        packets.clear();
-        packetEvents.clear();
+        for (auto& ring : packets) {
+            ring.clear();
+        }
+        cloneGroups.clear();
         packetCount = {};
         clonedPacketCount = {};
         declaredLostCount = 0;
+        lossScanStart = {};
         dsrCount = 0;
     }
 };
@@ -260,6 +296,22 @@ struct Pacer {
     virtual void onPacketsLoss() = 0;
 
     virtual void setExperimental(bool experimental) = 0;
+
+    /**
+     * The pacing rate to restore() another pacer with, or none if the pacer
+     * doesn't support it.
+     */
+    [[nodiscard]] virtual folly::Optional<PacerSnapshot> snapshot() const {
+        return folly::none;
+    }
+
+    /**
+     * Paces at the rate of snapshot. Returns false if the pacer was left as it
+     * was.
+     */
+    virtual bool restore(const PacerSnapshot& /*snapshot*/) {
+        return false;
+    }
 };
 
 struct PacingRate {
@@ -358,8 +410,9 @@ struct QuicConnectionStateBase : public folly::DelayedDestruction {
     // Crypto stream
     std::unique_ptr<QuicCryptoState> cryptoState;
 
-    // Connection Congestion controller
-    std::unique_ptr<CongestionController> congestionController;
+    // Connection Congestion controller, which also keeps its concrete type
+    // for the per packet calls in congestion_control/congestion_controller_calls.h.
+    CongestionControllerPtr congestionController;
 
     std::vector<std::shared_ptr<PacketProcessor>> packetProcessors;
 
@@ -475,6 +528,13 @@ struct QuicConnectionStateBase : public folly::DelayedDestruction {
 
         std::vector<KnobFrame> knobs;
 
+        // Target bitrate, in bits per second, set by the congestion controller
+        // for the app's next ConnectionCallback::onTargetBitrateChange.
+        folly::Optional<uint64_t> targetBitrate;
+
+        // Bandwidth estimate for the app's BandwidthEstimateCallback.
+        folly::Optional<BandwidthEstimate> bandwidthEstimate;
+
         // Number of probing packets to send after PTO
         EnumArray<PacketNumberSpace, uint8_t> numProbePackets{};
 
@@ -552,6 +612,9 @@ struct QuicConnectionStateBase : public folly::DelayedDestruction {
         uint64_t peerAdvertisedInitialMaxStreamOffsetUni{0};
         // Time at which the last flow control update was sent by the transport.
         folly::Optional<TimePoint> timeOfLastFlowControlUpdate;
+        // sumMaxObservedOffset when the last flow control update was sent, used
+        // to estimate the peer's send rate for window autotuning.
+        uint64_t sumMaxObservedOffsetAtLastUpdate{0};
     };
 
     // Current state of flow control.
@@ -651,6 +714,15 @@ struct QuicConnectionStateBase : public folly::DelayedDestruction {
     // Holds the ACK events generated during the last round of ACK processing.
     std::vector<AckEvent> lastProcessedAckEvents;
 
+    // Storage of AckEvent::ackedPackets from ACK events already handled, kept
+    // cleared but with its capacity so that processing the next ACK doesn't
+    // allocate. See recycleAckEvent().
+    std::vector<std::vector<AckEvent::AckPacket>> recycledAckedPackets;
+
+    // Peer receive timestamps of the ACK being processed, kept across ACKs to
+    // reuse its storage. See parseAckReceiveTimestamps().
+    AckReceiveTimestamps ackReceiveTimestamps;
+
     // Type of node owning this connection (client or server).
     QuicNodeType nodeType;
 
@@ -695,12 +767,31 @@ struct QuicConnectionStateBase : public folly::DelayedDestruction {
 
     DatagramState datagramState;
 
+    // Buffered bytes of this connection last reported to the shard's
+    // ShardMemoryAccountant.
+    uint64_t shardAccountedBytes{0};
+
     // Peer max stream groups advertised.
     folly::Optional<uint64_t> peerAdvertisedMaxStreamGroups;
 
     // Sequence number to use for the next ACK_FREQUENCY frame
     uint64_t nextAckFrequencyFrameSequenceNumber{0};
 
+    // The ACK_FREQUENCY parameters last requested by
+    // updatePeerAckFrequency().
+    struct AckFrequencyControllerState {
+        folly::Optional<uint64_t> ackElicitingThreshold;
+        folly::Optional<std::chrono::microseconds> maxAckDelay;
+        folly::Optional<TimePoint> lastUpdateTime;
+    };
+    AckFrequencyControllerState ackFrequencyControllerState;
+
+    // See updateBandwidthEstimate().
+    BandwidthEstimateState bandwidthEstimateState;
+
+    // See updateEcnState().
+    EcnState ecnState;
+
     // GSO supported on conn.
     folly::Optional<bool> gsoSupported;
 
@@ -735,6 +826,8 @@ struct AckStateVersion {
     bool operator!=(const AckStateVersion& other) const;
 };
 
-using LossVisitor = std::function<void(QuicConnectionStateBase&, RegularQuicWritePacket&, bool)>;
+// Non-owning: loss visitors are only invoked for the duration of the call they
+// are passed to, so there is no need to type-erase them into a std::function.
+using LossVisitor = folly::FunctionRef<void(QuicConnectionStateBase&, RegularQuicWritePacket&, bool)>;
 
 } // namespace quic
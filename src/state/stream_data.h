@@ -95,6 +95,34 @@ struct StreamBuffer {
     StreamBuffer& operator=(StreamBuffer&& other) = default;
 };
 
+/**
+ * What the application says a range of written stream data is, so the
+ * scheduler can favour or shed it when the congestion window cannot fit
+ * everything that is buffered.
+ */
+enum class MediaDataType : uint8_t {
+    Unspecified,
+    // Needed to start or recover decoding; sent ahead of other data.
+    Keyframe,
+    // Referenced by later frames; never dropped.
+    Reference,
+    // Nothing depends on it; may be discarded if not sent yet.
+    Droppable,
+};
+
+struct MediaDataRange {
+    uint64_t offset;
+    uint64_t length;
+    MediaDataType type;
+
+    MediaDataRange(uint64_t offsetIn, uint64_t lengthIn, MediaDataType typeIn)
+        : offset(offsetIn), length(lengthIn), type(typeIn) {}
+
+    [[nodiscard]] uint64_t end() const {
+        return offset + length;
+    }
+};
+
 struct QuicStreamLike {
     QuicStreamLike() = default;
 
@@ -285,6 +313,14 @@ struct QuicStreamState : public QuicStreamLike {
 
     QuicStreamState(QuicStreamState&&) = default;
 
+    /**
+     * Re-initialize a stream state that has been removed from the stream
+     * manager so that it can be reused for a new stream on the same
+     * connection. Containers are cleared in place so their allocations are
+     * kept. Any new field added to this struct must also be reset here.
+     */
+    void reinitialize(StreamId idIn, const folly::Optional<StreamGroupId>& groupIdIn);
+
     /**
      * Constructor to migrate QuicStreamState to another
      * QuicConnectionStateBase.
@@ -308,6 +344,10 @@ struct QuicStreamState : public QuicStreamLike {
         retransmissionBufMetas = std::move(other.retransmissionBufMetas);
         lossBufMetas = std::move(other.lossBufMetas);
         streamLossCount = other.streamLossCount;
+        expiryTime = other.expiryTime;
+        expiryErrorCode = other.expiryErrorCode;
+        mediaRanges = std::move(other.mediaRanges);
+        droppableErrorCode = other.droppableErrorCode;
     }
 
     // Connection that this stream is associated with.
@@ -328,6 +368,9 @@ struct QuicStreamState : public QuicStreamLike {
         uint64_t peerAdvertisedMaxOffset{0};
         // Time at which the last flow control update was sent by the transport.
         folly::Optional<TimePoint> timeOfLastFlowControlUpdate;
+        // maxOffsetObserved when the last flow control update was sent, used to
+        // estimate the peer's send rate for window autotuning.
+        uint64_t maxOffsetObservedAtLastUpdate{0};
     };
 
     StreamFlowControlState flowControlState;
@@ -472,6 +515,52 @@ struct QuicStreamState : public QuicStreamLike {
 
     uint64_t streamLossCount{0};
 
+    // Playout deadline of the data on this stream. Once it has passed, a
+    // stream with lost data is reset with expiryErrorCode before the data is
+    // retransmitted, so the peer can skip ahead.
+    folly::Optional<TimePoint> expiryTime;
+    ApplicationErrorCode expiryErrorCode{GenericApplicationErrorCode::NO_ERROR};
+
+    // Media tags of the written data, in ascending offset order and never
+    // overlapping. Ranges that have been fully sent are trimmed when new ones
+    // are added.
+    std::deque<MediaDataRange> mediaRanges;
+    // Error code of the reset that discards unsent droppable data.
+    ApplicationErrorCode droppableErrorCode{GenericApplicationErrorCode::NO_ERROR};
+
+    // Whether any data tagged as a keyframe is still in the write buffer.
+    [[nodiscard]] bool hasUnsentKeyframeData() const {
+        for (const auto& range : mediaRanges) {
+            if (range.end() > currentWriteOffset && range.type == MediaDataType::Keyframe) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Whether the whole write buffer is droppable data none of which has been
+    // sent yet, so it can be discarded without cutting a frame short.
+    [[nodiscard]] bool hasOnlyUnsentDroppableData() const {
+        if (writeBuffer.empty() || writeBufMeta.offset != 0) {
+            return false;
+        }
+        auto unsentEnd = currentWriteOffset + writeBuffer.chainLength();
+        auto covered = currentWriteOffset;
+        for (const auto& range : mediaRanges) {
+            if (range.end() <= covered) {
+                continue;
+            }
+            if (range.offset != covered || range.type != MediaDataType::Droppable) {
+                return false;
+            }
+            covered = range.end();
+            if (covered >= unsentEnd) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     /**
      * Insert a new WriteBufferMeta into lossBufMetas. If the new WriteBufferMeta
      * can be append to an existing WriteBufferMeta, it will be appended. Note
@@ -495,6 +584,9 @@ struct QuicStreamState : public QuicStreamLike {
             lossBufMetas.insert(lossItr, bufMeta);
         }
     }
+
+private:
+    void applyInitialState();
 };
 
 } // namespace quic
@@ -55,6 +55,73 @@ struct BbrConfig {
     folly::Optional<AckFrequencyConfig> ackFrequencyConfig;
 };
 
+struct CubicConfig {
+    // Leave slow start per HyStart++ (RFC 9406): once the RTT grows, slow
+    // start continues at a quarter of the rate for kCssRounds rounds, and
+    // resumes if the RTT increase turns out spurious, rather than switching to
+    // congestion avoidance right away. Off by default: it only pays off when
+    // the RTT jitters. Its larger RTT threshold notices the queue later than
+    // classic HyStart does, and CSS then fills deep buffers.
+    bool hystartPlusPlus{false};
+};
+
+// Controls ACK_FREQUENCY frames sent from the transport, independently of the
+// congestion controller. The peer is asked to ACK about targetAcksPerRtt times
+// per RTT at our current sending rate, so its ACK eliciting threshold grows
+// with the bandwidth and the number of ACKs we process stays flat. A new
+// ACK_FREQUENCY is sent when the threshold or max ack delay moves by more than
+// 1/changeDivisor, at most once per RTT. Supersedes BbrConfig's
+// ackFrequencyConfig when set.
+struct AckFrequencyControllerConfig {
+    uint64_t targetAcksPerRtt{4};
+    uint64_t minAckElicitingThreshold{2};
+    uint64_t maxAckElicitingThreshold{64};
+    uint64_t reorderingThreshold{kReorderingThreshold};
+    uint64_t changeDivisor{4};
+};
+
+// Connections on a shard whose peers share an address prefix pool their
+// bandwidth and min RTT estimates in a CongestionGroup, and new connections
+// start from their share of the group's bandwidth. Only used by BBR2.
+struct CongestionGroupConfig {
+    uint8_t v4PrefixLen{kDefaultCongestionGroupV4PrefixLen};
+    uint8_t v6PrefixLen{kDefaultCongestionGroupV6PrefixLen};
+    std::chrono::microseconds estimateTtl{kDefaultCongestionGroupEstimateTtl};
+};
+
+// A new connection from a client seen recently on the shard starts from a
+// fraction (cwndGain) of the previous connection's BDP as initial cwnd, capped
+// at maxInitCwndInMss, and from its min RTT as initial RTT, floored at
+// minInitialRtt. Hints from paths that lost more than maxLossPerMille packets
+// per thousand are ignored.
+struct CongestionHintConfig {
+    std::chrono::microseconds ttl{kDefaultCongestionHintTtl};
+    double cwndGain{0.5};
+    uint64_t maxInitCwndInMss{kDefaultMaxCwndInMss / 4};
+    std::chrono::microseconds minInitialRtt{10ms};
+    uint16_t maxLossPerMille{50};
+};
+
+// Limits of the bytes all the connections on a shard may hold in stream and
+// datagram buffers, see ShardMemoryAccountant. The thresholds are fractions of
+// limitBytes. The accountant is shared by the shard, so every connection on it
+// should be given the same config; the last one set applies.
+struct ShardMemoryConfig {
+    uint64_t limitBytes{kDefaultShardMemoryLimit};
+    double moderatePressure{kDefaultShardMemoryModeratePressure};
+    double severePressure{kDefaultShardMemorySeverePressure};
+};
+
+struct MediaCongestionControllerConfig {
+    // Bounds of the target bitrate, in bits per second.
+    uint64_t minBitrate{150'000};
+    uint64_t startBitrate{1'000'000};
+    uint64_t maxBitrate{50'000'000};
+    // The app is told of a new target bitrate once it moved by this fraction
+    // of the last one reported.
+    double reportThreshold{0.05};
+};
+
 struct DatagramConfig {
     bool enabled{false};
     bool framePerPacket{true};
@@ -115,8 +182,10 @@ struct TransportSettings {
     uint16_t maxNumMigrationsAllowed{kMaxNumMigrationsAllowed};
     // Whether to listen to socket error
     bool enableSocketErrMsgCallback{true};
-    // Whether pacing is enabled.
-    bool pacingEnabled{false};
+    // Whether pacing is enabled. On by default so that slow start doesn't send
+    // its doubled cwnd in bursts. It is turned off if the transport has no
+    // pacing timer.
+    bool pacingEnabled{true};
     // Whether pacing should be enabled for the first flight before the 1-RTT
     // cipher is available. Turning this on paces 0-rtt packets.
     bool pacingEnabledFirstFlight{false};
@@ -128,6 +197,10 @@ struct TransportSettings {
     // callbacks. For pacing to work accurately, this should be reasonably smaller
     // than kDefaultPacingTickInterval.
     std::chrono::microseconds pacingTimerResolution{kDefaultPacingTimerResolution};
+    // Whether paced writes are woken by the shard's pacing calendar, one
+    // pacing timer callback for all the connections due in a timer tick,
+    // rather than a pacing timer callback per connection.
+    bool useShardPacingCalendar{false};
     ZeroRttSourceTokenMatchingPolicy zeroRttSourceTokenMatchingPolicy{ZeroRttSourceTokenMatchingPolicy::REJECT_IF_NO_EXACT_MATCH};
     // Scale pacing rate for CC, non-empty indicates override via transport knobs
     std::pair<uint8_t, uint8_t> startupRttFactor{1, 2};
@@ -174,6 +247,10 @@ struct TransportSettings {
     // Setting a value here also indicates to the peer that it can send
     // ACK_FREQUENCY and IMMEDIATE_ACK frames
     folly::Optional<std::chrono::microseconds> minAckDelay;
+    // Adapts the peer's ACK frequency to our sending rate, see
+    // AckFrequencyControllerConfig. Only used if the peer supports
+    // ACK_FREQUENCY.
+    folly::Optional<AckFrequencyControllerConfig> ackFrequencyControllerConfig;
     // Limits the amount of data that should be buffered in a QuicSocket.
     // If the amount of data in the buffer equals or exceeds this amount, then
     // the callback registered through notifyPendingWriteOnConnection() will
@@ -200,6 +277,27 @@ struct TransportSettings {
     bool shouldUseRecvmmsgForBatchRecv{false};
     // Config struct for BBR
     BbrConfig bbrConfig;
+    // Config struct for Cubic
+    CubicConfig cubicConfig;
+    // Pools estimates across connections to the same peer prefix, see
+    // CongestionGroupConfig.
+    folly::Optional<CongestionGroupConfig> congestionGroupConfig;
+    // Seeds new connections from the last one to the same client, see
+    // CongestionHintConfig.
+    folly::Optional<CongestionHintConfig> congestionHintConfig;
+    // Limits of the shard's buffer memory, see ShardMemoryConfig. Unlimited if
+    // no connection on the shard sets it.
+    folly::Optional<ShardMemoryConfig> shardMemoryConfig;
+    // Config for CongestionControlType::Media
+    MediaCongestionControllerConfig mediaCongestionControllerConfig;
+    // Whether to mark outgoing packets ECN capable. Marking stops if the peer's
+    // ECN counts fail validation, see EcnState. The peer has to echo them: this
+    // stack doesn't read the ECN bits of incoming packets or send ACK_ECN, so
+    // between two of its endpoints marking stops at the first ACK.
+    bool enableEcnOnEgress{false};
+    // Whether to mark ECT(1) rather than ECT(0), for L4S. Cubic and BBR2 then
+    // respond to CE marks in proportion to their fraction instead of as loss.
+    bool useL4sEcn{false};
     // A packet is considered loss when a packet that's sent later by at least
     // timeReorderingThreshold * RTT is acked by peer.
     DurationRep timeReorderingThreshDividend{kDefaultTimeReorderingThreshDividend};
@@ -230,11 +328,14 @@ struct TransportSettings {
     // Whether to use adaptive loss thresholds for reodering and timeout
     bool useAdaptiveLossReorderingThresholds{false};
     bool useAdaptiveLossTimeThresholds{false};
-    // Whether to automatically increase receive conn flow control. The
-    // determination is based on the frequency we are sending flow control
-    // updates. If there has been less than 2SRTTs between flow control updates
-    // this will double the target window.
+    // Whether to automatically increase receive conn flow control. On each
+    // flow control update the peer's send rate since the previous update is
+    // multiplied by srtt, and the window grows to twice that BDP, capped at
+    // totalBufferSpaceAvailable.
     bool autotuneReceiveConnFlowControl{false};
+    // Same as above for each stream's receive window, which is additionally
+    // capped at the connection window.
+    bool autotuneReceiveStreamFlowControl{false};
     // Enable a keepalive timer. This schedules a timer to send a PING ~15%
     // before an idle timeout. To work effectively this means the idle timer
     // has to be set to something >> the RTT of the connection.
@@ -265,6 +366,10 @@ struct TransportSettings {
     // Whether to include ACKs whenever we have data to write and packets to ACK.
     bool opportunisticAcking{true};
 
+    // Maximum number of closed stream states a connection keeps around to be
+    // reused by newly created streams. 0 disables the pooling.
+    uint64_t maxPooledStreamStates{kDefaultMaxPooledStreamStates};
+
     // Local configuration for ACK receive timestamps.
     //
     // Determines the ACK receive timestamp configuration sent to peer,
@@ -0,0 +1,156 @@
+#include "src/congestion_control/congestion_control_factory.h"
+#include "src/congestion_control/congestion_controller_calls.h"
+#include "src/congestion_control/tokenless_pacer.h"
+#include "src/state/state_data.h"
+#include <fmt/core.h>
+
+#include <chrono>
+#include <string>
+
+using namespace quic;
+
+/*
+    Measures the per packet cost of the congestion controller calls on the
+    write and ack paths, onPacketSent, getWritableBytes, getCongestionWindow
+    and onPacketAckOrLoss, made through the vtable and through
+    CongestionControllerPtr. Every packet is acked on its own one RTT
+    later, so both paths see the same sequence of events and only the dispatch
+    differs. Building the ACKs dominates that loop, so the getters the write
+    path calls per packet are also timed on their own.
+
+    usage: congestion_control_dispatch_bench [packets] [rounds]
+*/
+
+namespace {
+
+constexpr uint64_t kPacketSize = kDefaultUDPSendPacketLen;
+constexpr std::chrono::microseconds kRtt{20000};
+
+struct Virtual {
+    static void onPacketSent(QuicConnectionStateBase& conn, const OutstandingPacketWrapper& packet) {
+        conn.congestionController->onPacketSent(packet);
+    }
+    static void onPacketAck(QuicConnectionStateBase& conn, const CongestionController::AckEvent& ack) {
+        conn.congestionController->onPacketAckOrLoss(&ack, nullptr);
+    }
+    static uint64_t writableBytes(const QuicConnectionStateBase& conn) {
+        return conn.congestionController->getWritableBytes();
+    }
+    static uint64_t window(const QuicConnectionStateBase& conn) {
+        return conn.congestionController->getCongestionWindow();
+    }
+};
+
+struct Dispatched {
+    static void onPacketSent(QuicConnectionStateBase& conn, const OutstandingPacketWrapper& packet) {
+        conn.congestionController.visit([&packet](auto& controller) { controller.onPacketSent(packet); });
+    }
+    static void onPacketAck(QuicConnectionStateBase& conn, const CongestionController::AckEvent& ack) {
+        conn.congestionController.visit([&ack](auto& controller) { controller.onPacketAckOrLoss(&ack, nullptr); });
+    }
+    static uint64_t writableBytes(const QuicConnectionStateBase& conn) {
+        return conn.congestionController.visit([](const auto& controller) { return controller.getWritableBytes(); });
+    }
+    static uint64_t window(const QuicConnectionStateBase& conn) {
+        return conn.congestionController.visit([](const auto& controller) { return controller.getCongestionWindow(); });
+    }
+};
+
+template <typename Calls>
+double timeNsPerPacket(CongestionControlType type, uint64_t numPackets, uint64_t rounds, uint64_t& checksum) {
+    std::chrono::nanoseconds total{0};
+    auto connId = ConnectionId::createWithoutChecks({1, 2, 3, 4, 5, 6, 7, 8});
+    for (uint64_t round = 0; round < rounds; round++) {
+        QuicConnectionStateBase conn(QuicNodeType::Server);
+        conn.udpSendPacketLen = kPacketSize;
+        // BBR2 sets its pacing rate on every ack.
+        conn.pacer = std::make_unique<TokenlessPacer>(conn, conn.transportSettings.minCwndInMss);
+        conn.congestionController = DefaultCongestionControllerFactory().makeCongestionController(conn, type);
+        auto& lossState = conn.lossState;
+        auto start = Clock::now();
+
+        auto begin = std::chrono::steady_clock::now();
+        for (PacketNum packetNum = 0; packetNum < numPackets; packetNum++) {
+            auto sentTime = start + packetNum * std::chrono::microseconds(10);
+            checksum += Calls::writableBytes(conn);
+
+            lossState.totalBytesSent += kPacketSize;
+            lossState.totalBodyBytesSent += kPacketSize;
+            lossState.totalPacketsSent++;
+            lossState.inflightBytes += kPacketSize;
+            RegularQuicWritePacket packet(ShortHeader(ProtectionType::KeyPhaseZero, connId, packetNum));
+            OutstandingPacketWrapper outstanding(std::move(packet), sentTime, kPacketSize, kPacketSize,
+                false /* isHandshake */, lossState.totalBytesSent, lossState.totalBodyBytesSent,
+                lossState.inflightBytes, 1 /* packetsInflight */, lossState, packetNum /* writeCount */,
+                OutstandingPacketMetadata::DetailsPerStream());
+            Calls::onPacketSent(conn, outstanding);
+
+            auto ackTime = sentTime + kRtt;
+            auto ack = AckEvent::Builder()
+                           .setAckTime(ackTime)
+                           .setAdjustedAckTime(ackTime)
+                           .setAckDelay(0us)
+                           .setPacketNumberSpace(PacketNumberSpace::AppData)
+                           .setLargestAckedPacket(packetNum)
+                           .build();
+            ack.rttSample = kRtt;
+            ack.largestNewlyAckedPacket = packetNum;
+            ack.largestNewlyAckedPacketSentTime = sentTime;
+            ack.ackedBytes = kPacketSize;
+            lossState.totalBytesAcked += kPacketSize;
+            lossState.inflightBytes -= kPacketSize;
+            ack.ackedPackets.emplace_back(AckEvent::AckPacket::Builder()
+                                              .setPacketNum(packetNum)
+                                              .setNonDsrPacketSequenceNumber(packetNum)
+                                              .setOutstandingPacketMetadata(std::move(outstanding.metadata))
+                                              .setDetailsPerStream(AckEvent::AckPacket::DetailsPerStream())
+                                              .setLastAckedPacketInfo(std::move(outstanding.lastAckedPacketInfo))
+                                              .setAppLimited(false)
+                                              .build());
+            Calls::onPacketAck(conn, ack);
+            checksum += Calls::window(conn);
+        }
+        total += std::chrono::steady_clock::now() - begin;
+    }
+    return static_cast<double>(total.count()) / static_cast<double>(numPackets * rounds);
+}
+
+// Calls getWritableBytes and getCongestionWindow on a controller at rest.
+template <typename Calls>
+double timeGettersNsPerPacket(CongestionControlType type, uint64_t numPackets, uint64_t& checksum) {
+    QuicConnectionStateBase conn(QuicNodeType::Server);
+    conn.udpSendPacketLen = kPacketSize;
+    conn.pacer = std::make_unique<TokenlessPacer>(conn, conn.transportSettings.minCwndInMss);
+    conn.congestionController = DefaultCongestionControllerFactory().makeCongestionController(conn, type);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (uint64_t packet = 0; packet < numPackets; packet++) {
+        checksum += Calls::writableBytes(conn) + Calls::window(conn);
+        // Keeps the calls in the loop.
+        conn.lossState.inflightBytes = checksum & 1;
+    }
+    std::chrono::nanoseconds total = std::chrono::steady_clock::now() - begin;
+    return static_cast<double>(total.count()) / static_cast<double>(numPackets);
+}
+
+} // namespace
+
+int main(int ac, char** av) {
+    uint64_t numPackets = ac > 1 ? std::stoull(av[1]) : 100000;
+    uint64_t rounds = ac > 2 ? std::stoull(av[2]) : 20;
+    uint64_t checksum = 0;
+
+    fmt::print("packets: {}, rounds: {}\n", numPackets, rounds);
+    for (auto type : {CongestionControlType::BBR2, CongestionControlType::Cubic}) {
+        auto virtualNs = timeNsPerPacket<Virtual>(type, numPackets, rounds, checksum);
+        auto dispatchedNs = timeNsPerPacket<Dispatched>(type, numPackets, rounds, checksum);
+        fmt::print("{:<6} virtual: {:.2f} ns/packet, dispatched: {:.2f} ns/packet\n",
+            type == CongestionControlType::BBR2 ? "bbr2" : "cubic", virtualNs, dispatchedNs);
+        auto virtualGetterNs = timeGettersNsPerPacket<Virtual>(type, numPackets * rounds, checksum);
+        auto dispatchedGetterNs = timeGettersNsPerPacket<Dispatched>(type, numPackets * rounds, checksum);
+        fmt::print("{:<6} getters virtual: {:.2f} ns/packet, dispatched: {:.2f} ns/packet\n",
+            type == CongestionControlType::BBR2 ? "bbr2" : "cubic", virtualGetterNs, dispatchedGetterNs);
+    }
+    fmt::print("checksum: {}\n", checksum);
+    return 0;
+}
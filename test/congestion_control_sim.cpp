@@ -0,0 +1,832 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "src/congestion_control/congestion_control_factory.h"
+#include "src/congestion_control/congestion_control_functions.h"
+#include "src/congestion_control/congestion_controller.h"
+#include "src/congestion_control/static_cwnd_congestion_controller.h"
+#include "src/congestion_control/tokenless_pacer.h"
+#include "src/state/state_data.h"
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <queue>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace quic;
+
+/*
+    Deterministic network emulation for the congestion controllers. Bulk flows
+    share one bottleneck link and every controller is driven through the same
+    AckEvent / LossEvent interface as in the transport, on a virtual clock
+    (built with QUIC_VIRTUAL_CLOCK, so the controllers' own Clock::now() calls
+    see simulated time too). A scenario takes as long as its event count, not
+    its simulated duration, and the same arguments always give the same
+    results.
+
+    Link model:
+    - a FIFO bottleneck of the given rate, with a drop-tail buffer sized in
+      BDPs of the base RTT,
+    - base RTT split evenly between the forward and return paths,
+    - random loss after the bottleneck, either independent or in bursts
+      (Gilbert-Elliott with the given mean burst length),
+    - ACK aggregation: the receiver ACKs everything received within each
+      aggregation interval at its end, otherwise it ACKs every packet,
+    - jitter: each ACK takes up to the given extra time on the return path,
+      uniformly at random, but never overtakes the one before it,
+    - with ECN, the bottleneck marks CE the packets that queue for longer than
+      5ms (classic, a CoDel like target) or 1ms (L4S, the step of DualPI2's
+      L4S queue), and the receiver reports the marks in its ACKs.
+
+    With migrate, every flow's connection state is rebuilt halfway through,
+    as when a connection moves to another shard: its outstanding packets are
+    forgotten and a new controller takes over, from scratch (reset) or from a
+    snapshot of the old one's state (restore).
+
+    The sender declares a packet lost once 3 later packets are acked, or when a
+    PTO fires with nothing acked. Lost data isn't retransmitted, every packet
+    carries new data.
+
+    One CSV line is printed per scenario with the summed goodput, link
+    utilization, mean and p95 queueing delay, loss rate, Jain's fairness
+    index over the flows' goodput and the time to full rate: how long after
+    its start the slowest flow first got 90% of its fair share of the link
+    over a base RTT, or -1 if one never did.
+
+    usage: congestion_control_sim [key=value[,value...]]...
+      cc=cubic,newreno,copa,copa2,bbr,bbr2,static,media
+                                         flows of one scenario are
+                                         joined with '+', e.g. cc=cubic+bbr2
+      rate=<Mbps> rtt=<ms> buffer=<BDPs> loss=<percent> burst=<packets>
+      agg=<ms> jitter=<ms> duration=<s> stagger=<ms between flow starts>
+      pacing=<0|1>
+      hystart=<classic|plusplus> ecn=<off|classic|l4s>
+      migrate=<off|reset|restore> seed=<n>
+    Every key takes a comma separated list and the scenarios are their
+    cartesian product. Exits with 1 if a flow of any scenario acked nothing.
+
+    seed only drives the link's random loss and jitter. BBR2 picks its
+    probing times with folly::Random, so its results vary between runs of the
+    same scenario and are best compared over several runs.
+*/
+
+namespace {
+
+constexpr uint64_t kPacketSize = kDefaultUDPSendPacketLen;
+constexpr uint64_t kReorderThreshold = 3;
+constexpr std::chrono::microseconds kClassicEcnMarkThreshold = 5ms;
+constexpr std::chrono::microseconds kL4sEcnMarkThreshold = 1ms;
+
+struct Scenario {
+    std::vector<CongestionControlType> flows;
+    double rateMbps{0};
+    std::chrono::microseconds rtt{0us};
+    double bufferBdp{0};
+    double lossPercent{0};
+    double burstPackets{0};
+    std::chrono::microseconds aggregation{0us};
+    std::chrono::microseconds jitter{0us};
+    std::chrono::microseconds duration{0us};
+    std::chrono::microseconds stagger{0us};
+    bool pacing{true};
+    bool hystartPlusPlus{false};
+    ECNState ecn{ECNState::NotAttempted};
+    enum class Migrate : uint8_t { Off, Reset, Restore } migrate{Migrate::Off};
+    uint64_t seed{0};
+};
+
+struct FlowResult {
+    uint64_t ackedBytes{0};
+    uint64_t sentPackets{0};
+    uint64_t lostPackets{0};
+    std::vector<std::chrono::microseconds> queueDelays;
+    folly::Optional<std::chrono::microseconds> timeToFullRate;
+};
+
+struct Result {
+    double goodputMbps{0};
+    double utilization{0};
+    double meanQueueDelayMs{0};
+    double p95QueueDelayMs{0};
+    double lossRate{0};
+    double jainIndex{0};
+    double timeToFullRateMs{-1};
+    bool allFlowsProgressed{true};
+};
+
+std::string_view ccName(CongestionControlType type) {
+    switch (type) {
+        case CongestionControlType::Cubic:
+            return "cubic";
+        case CongestionControlType::NewReno:
+            return "newreno";
+        case CongestionControlType::Copa:
+            return "copa";
+        case CongestionControlType::Copa2:
+            return "copa2";
+        case CongestionControlType::BBR:
+            return "bbr";
+        case CongestionControlType::BBR2:
+            return "bbr2";
+        case CongestionControlType::StaticCwnd:
+            return "static";
+        case CongestionControlType::Media:
+            return "media";
+        default:
+            return "none";
+    }
+}
+
+folly::Optional<CongestionControlType> ccFromName(std::string_view name) {
+    for (auto type : {CongestionControlType::Cubic, CongestionControlType::NewReno, CongestionControlType::Copa,
+             CongestionControlType::Copa2, CongestionControlType::BBR, CongestionControlType::BBR2,
+             CongestionControlType::StaticCwnd, CongestionControlType::Media}) {
+        if (ccName(type) == name) {
+            return type;
+        }
+    }
+    return folly::none;
+}
+
+class Simulation {
+public:
+    explicit Simulation(const Scenario& scenario)
+        : scenario_(scenario),
+          start_(TimePoint() + std::chrono::hours(1)),
+          oneWayDelay_(scenario.rtt / 2),
+          bytesPerSec_(scenario.rateMbps * 1e6 / 8),
+          bufferBytes_(static_cast<uint64_t>(
+              std::max(scenario.bufferBdp * bytesPerSec_ * static_cast<double>(scenario.rtt.count()) / 1e6,
+                  static_cast<double>(kPacketSize)))),
+          linkFreeAt_(start_),
+          rng_(scenario.seed) {
+        Clock::current = start_;
+        for (size_t i = 0; i < scenario.flows.size(); i++) {
+            flows_.push_back(std::make_unique<Flow>(scenario, scenario.flows[i]));
+            flows_.back()->startTime = start_ + scenario.stagger * static_cast<int64_t>(i);
+            scheduleSend(i, flows_.back()->startTime);
+            if (scenario.migrate != Scenario::Migrate::Off) {
+                schedule(start_ + scenario.duration / 2, EventType::Migrate, i);
+            }
+        }
+    }
+
+    Result run() {
+        const auto end = start_ + scenario_.duration;
+        while (!events_.empty() && events_.top().time <= end) {
+            auto event = events_.top();
+            events_.pop();
+            Clock::current = event.time;
+            auto& flow = *flows_[event.flow];
+            switch (event.type) {
+                case EventType::Send:
+                    if (flow.nextSendTime == event.time) {
+                        flow.nextSendTime.reset();
+                        send(event.flow);
+                    }
+                    break;
+                case EventType::Receive:
+                    receive(event.flow, event.arg);
+                    break;
+                case EventType::AckFlush:
+                    flushAck(event.flow);
+                    break;
+                case EventType::AckArrive:
+                    onAck(event.flow);
+                    break;
+                case EventType::Pto:
+                    if (event.arg == flow.ptoGeneration) {
+                        onPto(event.flow);
+                    }
+                    break;
+                case EventType::Migrate:
+                    migrate(event.flow);
+                    break;
+            }
+        }
+        return summarize();
+    }
+
+private:
+    enum class EventType : uint8_t { Send, Receive, AckFlush, AckArrive, Pto, Migrate };
+
+    struct Event {
+        TimePoint time;
+        uint64_t seq;
+        EventType type;
+        size_t flow;
+        uint64_t arg;
+
+        bool operator>(const Event& other) const {
+            return time != other.time ? time > other.time : seq > other.seq;
+        }
+    };
+
+    struct AckFrame {
+        std::vector<PacketNum> packetNums;
+        std::chrono::microseconds ackDelay;
+        uint64_t ceMarked{0};
+    };
+
+    struct Flow {
+        Flow(const Scenario& scenario, CongestionControlType type) : conn(QuicNodeType::Server) {
+            // Room for the BDP and a full buffer twice over. A larger window
+            // only floods the bottleneck.
+            const auto linkBytes = scenario.rateMbps * 1e6 / 8 * static_cast<double>(scenario.rtt.count()) / 1e6 *
+                (1 + scenario.bufferBdp);
+            conn.transportSettings.maxCwndInMss =
+                std::max(kDefaultMaxCwndInMss, static_cast<uint64_t>(2 * linkBytes) / kPacketSize);
+            conn.transportSettings.pacingEnabled = scenario.pacing;
+            conn.transportSettings.cubicConfig.hystartPlusPlus = scenario.hystartPlusPlus;
+            conn.canBePaced = scenario.pacing;
+            // The link never clears the marks, so validation is skipped.
+            conn.ecnState.state = scenario.ecn;
+            conn.udpSendPacketLen = kPacketSize;
+            if (scenario.pacing) {
+                conn.pacer = std::make_unique<TokenlessPacer>(conn, conn.transportSettings.minCwndInMss);
+            }
+            if (type == CongestionControlType::StaticCwnd) {
+                // A window of one BDP, i.e. what a perfect controller would settle on.
+                auto bdp = static_cast<uint64_t>(
+                    scenario.rateMbps * 1e6 / 8 * static_cast<double>(scenario.rtt.count()) / 1e6);
+                conn.congestionController = std::make_unique<StaticCwndCongestionController>(
+                    StaticCwndCongestionController::CwndInBytes(std::max(bdp, kPacketSize)));
+            } else {
+                conn.congestionController = DefaultCongestionControllerFactory().makeCongestionController(conn, type);
+            }
+        }
+
+        QuicConnectionStateBase conn;
+        // Outstanding packets from basePacketNum on, in packet number order. Acked
+        // and lost ones are left as nullopt until they reach the front.
+        std::deque<folly::Optional<OutstandingPacketWrapper>> outstandings;
+        // Packets neither acked nor lost. lossState.inflightBytes is the
+        // congestion controller's to keep, as in the transport.
+        uint64_t numOutstanding{0};
+        PacketNum basePacketNum{0};
+        PacketNum nextPacketNum{0};
+        folly::Optional<PacketNum> largestAcked;
+        folly::Optional<TimePoint> nextSendTime;
+        uint64_t ptoGeneration{0};
+        // Receiver side.
+        std::vector<PacketNum> pendingAck;
+        uint64_t pendingCe{0};
+        // Whether each packet on its way to the receiver is CE marked. The
+        // link doesn't reorder, so they arrive in this order.
+        std::deque<bool> ceInFlight;
+        TimePoint largestReceivedTime;
+        std::deque<AckFrame> acksInFlight;
+        TimePoint lastAckArrival;
+        // Acked bytes since rateWindowStart, for the time to full rate.
+        TimePoint startTime;
+        folly::Optional<TimePoint> rateWindowStart;
+        uint64_t rateWindowBytes{0};
+        FlowResult result;
+    };
+
+    void schedule(TimePoint time, EventType type, size_t flow, uint64_t arg = 0) {
+        events_.push(Event{time, nextSeq_++, type, flow, arg});
+    }
+
+    double uniform() {
+        return std::uniform_real_distribution<double>(0, 1)(rng_);
+    }
+
+    bool dropOnLink() {
+        if (scenario_.lossPercent <= 0) {
+            return false;
+        }
+        const double p = scenario_.lossPercent / 100;
+        if (scenario_.burstPackets <= 1) {
+            return uniform() < p;
+        }
+        // Gilbert-Elliott: every packet in the bad state is lost, the bad state
+        // lasts burstPackets on average and the long run loss rate is p.
+        const double badToGood = 1 / scenario_.burstPackets;
+        const double goodToBad = p * badToGood / (1 - p);
+        linkBad_ = uniform() < (linkBad_ ? 1 - badToGood : goodToBad);
+        return linkBad_;
+    }
+
+    std::chrono::microseconds serializationTime(uint64_t bytes) const {
+        return std::chrono::microseconds(static_cast<int64_t>(static_cast<double>(bytes) * 1e6 / bytesPerSec_));
+    }
+
+    std::chrono::microseconds pto(const Flow& flow) const {
+        const auto& lossState = flow.conn.lossState;
+        if (lossState.srtt == 0us) {
+            return 2 * scenario_.rtt + 10ms;
+        }
+        return lossState.srtt + std::max(4 * lossState.rttvar, 1000us) + scenario_.aggregation;
+    }
+
+    void armPto(size_t index) {
+        auto& flow = *flows_[index];
+        schedule(Clock::now() + pto(flow), EventType::Pto, index, ++flow.ptoGeneration);
+    }
+
+    void scheduleSend(size_t index, TimePoint time) {
+        auto& flow = *flows_[index];
+        if (!flow.nextSendTime || time < *flow.nextSendTime) {
+            flow.nextSendTime = time;
+            schedule(time, EventType::Send, index);
+        }
+    }
+
+    void send(size_t index) {
+        auto& flow = *flows_[index];
+        auto& conn = flow.conn;
+        const auto now = Clock::now();
+        uint64_t batch = std::numeric_limits<uint64_t>::max();
+        if (conn.pacer) {
+            auto wait = conn.pacer->getTimeUntilNextWrite(now);
+            if (wait > 0us) {
+                scheduleSend(index, now + wait);
+                return;
+            }
+            batch = conn.pacer->updateAndGetWriteBatchSize(now);
+        }
+        const bool hadOutstanding = flow.numOutstanding > 0;
+        uint64_t sent = 0;
+        while (sent < batch && conn.congestionController->getWritableBytes() >= kPacketSize) {
+            sendPacket(index);
+            sent++;
+        }
+        if (sent > 0 && !hadOutstanding) {
+            armPto(index);
+        }
+        if (conn.pacer && conn.congestionController->getWritableBytes() >= kPacketSize) {
+            scheduleSend(index, now + std::max(conn.pacer->getTimeUntilNextWrite(now), 1us));
+        }
+    }
+
+    void sendPacket(size_t index) {
+        auto& flow = *flows_[index];
+        auto& conn = flow.conn;
+        auto& lossState = conn.lossState;
+        const auto now = Clock::now();
+        const PacketNum packetNum = flow.nextPacketNum++;
+
+        lossState.totalBytesSent += kPacketSize;
+        lossState.totalBodyBytesSent += kPacketSize;
+        lossState.totalPacketsSent++;
+        lossState.totalAckElicitingPacketsSent++;
+        lossState.maybeLastPacketSentTime = now;
+        lossState.lastRetransmittablePacketSentTime = now;
+
+        RegularQuicWritePacket packet(ShortHeader(ProtectionType::KeyPhaseZero, connId_, packetNum));
+        OutstandingPacketWrapper outstanding(std::move(packet), now, kPacketSize, kPacketSize, false /* isHandshake */,
+            lossState.totalBytesSent, lossState.totalBodyBytesSent, lossState.inflightBytes + kPacketSize,
+            flow.numOutstanding + 1, lossState, lossState.totalPacketsSent /* writeCount */,
+            OutstandingPacketMetadata::DetailsPerStream());
+        if (conn.congestionController) {
+            outstanding.isAppLimited = conn.congestionController->isAppLimited();
+        }
+        if (lossState.lastAckedTime && lossState.lastAckedPacketSentTime) {
+            outstanding.lastAckedPacketInfo.emplace(*lossState.lastAckedPacketSentTime, *lossState.lastAckedTime,
+                *lossState.adjustedLastAckedTime, lossState.totalBytesSentAtLastAck,
+                lossState.totalBytesAckedAtLastAck);
+        }
+        conn.congestionController->onPacketSent(outstanding);
+        if (conn.pacer) {
+            conn.pacer->onPacketSent();
+        }
+        flow.outstandings.emplace_back(std::move(outstanding));
+        flow.numOutstanding++;
+        flow.result.sentPackets++;
+
+        // Through the bottleneck: drop-tail when the queue is full, then random
+        // loss on the way to the receiver.
+        const auto queueStart = std::max(now, linkFreeAt_);
+        const auto queuedBytes = static_cast<uint64_t>(
+            static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(queueStart - now).count()) *
+            bytesPerSec_ / 1e6);
+        if (queuedBytes + kPacketSize > bufferBytes_) {
+            return;
+        }
+        linkFreeAt_ = queueStart + serializationTime(kPacketSize);
+        if (dropOnLink()) {
+            return;
+        }
+        const auto queueDelay = std::chrono::duration_cast<std::chrono::microseconds>(queueStart - now);
+        flow.result.queueDelays.push_back(queueDelay);
+        flow.ceInFlight.push_back(conn.ecnState.isMarking() &&
+            queueDelay > (conn.ecnState.isL4s() ? kL4sEcnMarkThreshold : kClassicEcnMarkThreshold));
+        schedule(linkFreeAt_ + oneWayDelay_, EventType::Receive, index, packetNum);
+    }
+
+    void receive(size_t index, PacketNum packetNum) {
+        auto& flow = *flows_[index];
+        flow.pendingAck.push_back(packetNum);
+        flow.pendingCe += flow.ceInFlight.front() ? 1 : 0;
+        flow.ceInFlight.pop_front();
+        flow.largestReceivedTime = Clock::now();
+        if (scenario_.aggregation == 0us) {
+            flushAck(index);
+        } else if (flow.pendingAck.size() == 1) {
+            const auto sinceStart = Clock::now() - start_;
+            const auto intervals = sinceStart / scenario_.aggregation + 1;
+            schedule(start_ + intervals * scenario_.aggregation, EventType::AckFlush, index);
+        }
+    }
+
+    void flushAck(size_t index) {
+        auto& flow = *flows_[index];
+        if (flow.pendingAck.empty()) {
+            return;
+        }
+        AckFrame frame;
+        frame.packetNums.swap(flow.pendingAck);
+        frame.ceMarked = std::exchange(flow.pendingCe, 0);
+        frame.ackDelay = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - flow.largestReceivedTime);
+        flow.acksInFlight.push_back(std::move(frame));
+        auto arrival = Clock::now() + oneWayDelay_;
+        if (scenario_.jitter > 0us) {
+            arrival += std::chrono::microseconds(
+                static_cast<int64_t>(uniform() * static_cast<double>(scenario_.jitter.count())));
+            arrival = std::max(arrival, flow.lastAckArrival);
+        }
+        flow.lastAckArrival = arrival;
+        schedule(arrival, EventType::AckArrive, index);
+    }
+
+    OutstandingPacketWrapper* findOutstanding(Flow& flow, PacketNum packetNum) {
+        if (packetNum < flow.basePacketNum || packetNum - flow.basePacketNum >= flow.outstandings.size()) {
+            return nullptr;
+        }
+        auto& slot = flow.outstandings[packetNum - flow.basePacketNum];
+        return slot ? slot.get_pointer() : nullptr;
+    }
+
+    void eraseOutstanding(Flow& flow, PacketNum packetNum) {
+        auto& slot = flow.outstandings[packetNum - flow.basePacketNum];
+        if (slot) {
+            slot.reset();
+            flow.numOutstanding--;
+        }
+        while (!flow.outstandings.empty() && !flow.outstandings.front()) {
+            flow.outstandings.pop_front();
+            flow.basePacketNum++;
+        }
+    }
+
+    void updateRtt(LossState& lossState, std::chrono::microseconds rttSample, std::chrono::microseconds ackDelay) {
+        lossState.mrtt = std::min(lossState.mrtt, rttSample);
+        lossState.maybeLrtt = rttSample;
+        lossState.maybeLrttAckDelay = ackDelay;
+        const auto adjusted = rttSample > lossState.mrtt + ackDelay ? rttSample - ackDelay : rttSample;
+        lossState.lrtt = adjusted;
+        if (lossState.srtt == 0us) {
+            lossState.srtt = adjusted;
+            lossState.rttvar = adjusted / 2;
+        } else {
+            const auto diff = lossState.srtt > adjusted ? lossState.srtt - adjusted : adjusted - lossState.srtt;
+            lossState.rttvar = (3 * lossState.rttvar + diff) / 4;
+            lossState.srtt = (7 * lossState.srtt + adjusted) / 8;
+        }
+    }
+
+    void onAck(size_t index) {
+        auto& flow = *flows_[index];
+        auto& conn = flow.conn;
+        auto& lossState = conn.lossState;
+        const auto now = Clock::now();
+        auto frame = std::move(flow.acksInFlight.front());
+        flow.acksInFlight.pop_front();
+        const PacketNum largest = *std::max_element(frame.packetNums.begin(), frame.packetNums.end());
+
+        auto ack = AckEvent::Builder()
+                       .setAckTime(now)
+                       .setAdjustedAckTime(now - frame.ackDelay)
+                       .setAckDelay(frame.ackDelay)
+                       .setPacketNumberSpace(PacketNumberSpace::AppData)
+                       .setLargestAckedPacket(largest)
+                       .build();
+        // Largest first, as processAckFrame visits them.
+        std::sort(frame.packetNums.rbegin(), frame.packetNums.rend());
+        for (auto packetNum : frame.packetNums) {
+            auto* packet = findOutstanding(flow, packetNum);
+            if (!packet) {
+                continue;
+            }
+            if (packetNum == largest) {
+                auto rttSample = std::chrono::duration_cast<std::chrono::microseconds>(now - packet->metadata.time);
+                updateRtt(lossState, rttSample, frame.ackDelay);
+                ack.rttSample = rttSample;
+                ack.rttSampleNoAckDelay = rttSample >= frame.ackDelay ? folly::make_optional(rttSample - frame.ackDelay)
+                                                                      : folly::none;
+            }
+            if (!ack.largestNewlyAckedPacket) {
+                ack.largestNewlyAckedPacket = packetNum;
+                ack.largestNewlyAckedPacketSentTime = packet->metadata.time;
+                ack.largestNewlyAckedPacketAppLimited = packet->isAppLimited;
+                lossState.lastAckedPacketSentTime = packet->metadata.time;
+            }
+            lossState.totalBytesAcked += kPacketSize;
+            lossState.totalBodyBytesAcked += kPacketSize;
+            ack.ackedBytes += kPacketSize;
+            ack.ackedPackets.emplace_back(AckEvent::AckPacket::Builder()
+                                              .setPacketNum(packetNum)
+                                              .setNonDsrPacketSequenceNumber(packetNum)
+                                              .setOutstandingPacketMetadata(std::move(packet->metadata))
+                                              .setDetailsPerStream(AckEvent::AckPacket::DetailsPerStream())
+                                              .setLastAckedPacketInfo(std::move(packet->lastAckedPacketInfo))
+                                              .setAppLimited(packet->isAppLimited)
+                                              .build());
+            flow.result.ackedBytes += kPacketSize;
+            eraseOutstanding(flow, packetNum);
+        }
+        updateTimeToFullRate(flow, ack.ackedBytes, now);
+        if (ack.largestNewlyAckedPacket && conn.ecnState.isMarking()) {
+            ack.ecnCEMarkedPackets = std::min<uint64_t>(frame.ceMarked, ack.ackedPackets.size());
+            if (conn.ecnState.isL4s()) {
+                ack.ecnCEMarkedPackets = conn.ecnState.updateL4sAlpha(ack.ackedPackets.size(), ack.ecnCEMarkedPackets,
+                    *ack.largestNewlyAckedPacket, flow.nextPacketNum - 1);
+            }
+        }
+        if (ack.largestNewlyAckedPacket) {
+            lossState.totalBytesSentAtLastAck = lossState.totalBytesSent;
+            lossState.totalBytesAckedAtLastAck = lossState.totalBytesAcked;
+            lossState.lastAckedTime = now;
+            lossState.adjustedLastAckedTime = now - frame.ackDelay;
+            lossState.ptoCount = 0;
+        }
+        ack.totalBytesAcked = lossState.totalBytesAcked;
+        flow.largestAcked = std::max(largest, flow.largestAcked.value_or(largest));
+
+        // Packet threshold loss detection. The link never reorders, so a packet
+        // is only ever left behind when it was dropped.
+        folly::Optional<CongestionController::LossEvent> lossEvent;
+        while (!flow.outstandings.empty() && flow.basePacketNum + kReorderThreshold <= *flow.largestAcked) {
+            declareLost(flow, flow.basePacketNum, lossEvent, now);
+        }
+        if (ack.largestNewlyAckedPacket || lossEvent) {
+            conn.congestionController->onPacketAckOrLoss(&ack, lossEvent.get_pointer());
+        }
+        if (flow.numOutstanding > 0) {
+            armPto(index);
+        } else {
+            flow.ptoGeneration++;
+        }
+        send(index);
+    }
+
+    void declareLost(Flow& flow, PacketNum packetNum, folly::Optional<CongestionController::LossEvent>& lossEvent,
+        TimePoint now) {
+        auto* packet = findOutstanding(flow, packetNum);
+        if (!packet) {
+            eraseOutstanding(flow, packetNum);
+            return;
+        }
+        if (!lossEvent) {
+            lossEvent.emplace(now);
+        }
+        lossEvent->addLostPacket(*packet);
+        flow.conn.lossState.totalPacketsMarkedLost++;
+        flow.result.lostPackets++;
+        eraseOutstanding(flow, packetNum);
+    }
+
+    void onPto(size_t index) {
+        // No ACK for a PTO: everything outstanding is presumed lost, which frees
+        // the window for new data instead of sending probes.
+        auto& flow = *flows_[index];
+        const auto now = Clock::now();
+        flow.conn.lossState.ptoCount++;
+        folly::Optional<CongestionController::LossEvent> lossEvent;
+        while (!flow.outstandings.empty()) {
+            declareLost(flow, flow.basePacketNum, lossEvent, now);
+        }
+        if (lossEvent) {
+            flow.conn.congestionController->onPacketAckOrLoss(nullptr, lossEvent.get_pointer());
+        }
+        send(index);
+    }
+
+    void migrate(size_t index) {
+        auto& old = *flows_[index];
+        auto flow = std::make_unique<Flow>(scenario_, old.conn.congestionController->type());
+        if (scenario_.migrate == Scenario::Migrate::Restore) {
+            if (auto snapshot = snapshotCongestionState(old.conn)) {
+                restoreCongestionState(flow->conn, *snapshot);
+            }
+        }
+        // What's on the network and at the receiver stays; ACKs of the
+        // forgotten packets are ignored.
+        flow->basePacketNum = old.nextPacketNum;
+        flow->nextPacketNum = old.nextPacketNum;
+        flow->ptoGeneration = old.ptoGeneration + 1;
+        flow->pendingAck = std::move(old.pendingAck);
+        flow->pendingCe = old.pendingCe;
+        flow->ceInFlight = std::move(old.ceInFlight);
+        flow->largestReceivedTime = old.largestReceivedTime;
+        flow->acksInFlight = std::move(old.acksInFlight);
+        flow->lastAckArrival = old.lastAckArrival;
+        flow->startTime = old.startTime;
+        flow->rateWindowStart = old.rateWindowStart;
+        flow->rateWindowBytes = old.rateWindowBytes;
+        flow->result = std::move(old.result);
+        flows_[index] = std::move(flow);
+        send(index);
+    }
+
+    void updateTimeToFullRate(Flow& flow, uint64_t ackedBytes, TimePoint now) {
+        if (flow.result.timeToFullRate) {
+            return;
+        }
+        if (!flow.rateWindowStart) {
+            flow.rateWindowStart = now;
+        }
+        flow.rateWindowBytes += ackedBytes;
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - *flow.rateWindowStart);
+        if (elapsed < scenario_.rtt) {
+            return;
+        }
+        const double rate = static_cast<double>(flow.rateWindowBytes) * 1e6 / static_cast<double>(elapsed.count());
+        if (rate >= 0.9 * bytesPerSec_ / static_cast<double>(flows_.size())) {
+            flow.result.timeToFullRate = std::chrono::duration_cast<std::chrono::microseconds>(now - flow.startTime);
+        }
+        flow.rateWindowStart = now;
+        flow.rateWindowBytes = 0;
+    }
+
+    Result summarize() {
+        Result result;
+        const double seconds = static_cast<double>(scenario_.duration.count()) / 1e6;
+        double sum = 0;
+        double sumSquares = 0;
+        uint64_t sent = 0;
+        uint64_t lost = 0;
+        std::vector<std::chrono::microseconds> delays;
+        folly::Optional<std::chrono::microseconds> timeToFullRate{0us};
+        for (auto& flow : flows_) {
+            timeToFullRate = flow->result.timeToFullRate && timeToFullRate
+                ? folly::make_optional(std::max(*timeToFullRate, *flow->result.timeToFullRate))
+                : folly::none;
+            const double goodput = static_cast<double>(flow->result.ackedBytes) * 8 / seconds / 1e6;
+            sum += goodput;
+            sumSquares += goodput * goodput;
+            sent += flow->result.sentPackets;
+            lost += flow->result.lostPackets;
+            result.allFlowsProgressed &= flow->result.ackedBytes > 0;
+            delays.insert(delays.end(), flow->result.queueDelays.begin(), flow->result.queueDelays.end());
+        }
+        result.goodputMbps = sum;
+        result.utilization = sum / scenario_.rateMbps;
+        result.jainIndex = sumSquares > 0 ? sum * sum / (static_cast<double>(flows_.size()) * sumSquares) : 0;
+        result.lossRate = sent > 0 ? static_cast<double>(lost) / static_cast<double>(sent) : 0;
+        if (timeToFullRate) {
+            result.timeToFullRateMs = static_cast<double>(timeToFullRate->count()) / 1e3;
+        }
+        if (!delays.empty()) {
+            std::chrono::microseconds total{0};
+            for (auto delay : delays) {
+                total += delay;
+            }
+            result.meanQueueDelayMs = static_cast<double>(total.count()) / static_cast<double>(delays.size()) / 1e3;
+            auto p95 = delays.begin() + static_cast<std::ptrdiff_t>(delays.size() * 95 / 100);
+            std::nth_element(delays.begin(), p95, delays.end());
+            result.p95QueueDelayMs = static_cast<double>(p95->count()) / 1e3;
+        }
+        return result;
+    }
+
+    const Scenario& scenario_;
+    const TimePoint start_;
+    const std::chrono::microseconds oneWayDelay_;
+    const double bytesPerSec_;
+    const uint64_t bufferBytes_;
+    TimePoint linkFreeAt_;
+    bool linkBad_{false};
+    std::mt19937_64 rng_;
+    ConnectionId connId_{ConnectionId::createWithoutChecks({1, 2, 3, 4, 5, 6, 7, 8})};
+    std::vector<std::unique_ptr<Flow>> flows_;
+    std::priority_queue<Event, std::vector<Event>, std::greater<>> events_;
+    uint64_t nextSeq_{0};
+};
+
+std::vector<std::string> split(const std::string& str, char sep) {
+    std::vector<std::string> parts;
+    size_t begin = 0;
+    while (true) {
+        auto end = str.find(sep, begin);
+        parts.push_back(str.substr(begin, end - begin));
+        if (end == std::string::npos) {
+            return parts;
+        }
+        begin = end + 1;
+    }
+}
+
+} // namespace
+
+int main(int ac, char** av) {
+    std::map<std::string, std::vector<std::string>> args = {
+        {"cc", {"cubic", "newreno", "copa", "bbr", "bbr2"}},
+        {"rate", {"10", "100"}},
+        {"rtt", {"10", "100"}},
+        {"buffer", {"0.5", "2"}},
+        {"loss", {"0", "1"}},
+        {"burst", {"0"}},
+        {"agg", {"0"}},
+        {"jitter", {"0"}},
+        {"duration", {"10"}},
+        {"stagger", {"0"}},
+        {"pacing", {"1"}},
+        {"hystart", {"classic"}},
+        {"ecn", {"off"}},
+        {"migrate", {"off"}},
+        {"seed", {"1"}},
+    };
+    for (int i = 1; i < ac; i++) {
+        std::string arg(av[i]);
+        auto eq = arg.find('=');
+        if (eq == std::string::npos || !args.count(arg.substr(0, eq))) {
+            fmt::print(stderr, "unknown argument {}\n", arg);
+            return 2;
+        }
+        args[arg.substr(0, eq)] = split(arg.substr(eq + 1), ',');
+    }
+
+    // Cartesian product of all the value lists, the last key varying fastest.
+    std::vector<std::map<std::string, std::string>> combos(1);
+    for (const auto& [key, values] : args) {
+        std::vector<std::map<std::string, std::string>> next;
+        for (const auto& combo : combos) {
+            for (const auto& value : values) {
+                next.push_back(combo);
+                next.back()[key] = value;
+            }
+        }
+        combos.swap(next);
+    }
+
+    fmt::print("cc,rate_mbps,rtt_ms,buffer_bdp,loss_pct,burst,agg_ms,jitter_ms,pacing,hystart,ecn,migrate,seed,"
+               "goodput_mbps,utilization,mean_qdelay_ms,p95_qdelay_ms,loss_rate,jain,full_rate_ms\n");
+    bool ok = true;
+    for (auto& combo : combos) {
+        Scenario scenario;
+        for (const auto& name : split(combo["cc"], '+')) {
+            auto type = ccFromName(name);
+            if (!type) {
+                fmt::print(stderr, "unknown congestion controller {}\n", name);
+                return 2;
+            }
+            scenario.flows.push_back(*type);
+        }
+        auto ms = [](const std::string& value) {
+            return std::chrono::microseconds(static_cast<int64_t>(std::stod(value) * 1e3));
+        };
+        scenario.rateMbps = std::stod(combo["rate"]);
+        scenario.rtt = ms(combo["rtt"]);
+        scenario.bufferBdp = std::stod(combo["buffer"]);
+        scenario.lossPercent = std::stod(combo["loss"]);
+        scenario.burstPackets = std::stod(combo["burst"]);
+        scenario.aggregation = ms(combo["agg"]);
+        scenario.jitter = ms(combo["jitter"]);
+        scenario.duration = ms(combo["duration"]) * 1000;
+        scenario.stagger = ms(combo["stagger"]);
+        scenario.pacing = combo["pacing"] != "0";
+        if (combo["hystart"] != "classic" && combo["hystart"] != "plusplus") {
+            fmt::print(stderr, "unknown hystart {}\n", combo["hystart"]);
+            return 2;
+        }
+        scenario.hystartPlusPlus = combo["hystart"] == "plusplus";
+        if (combo["ecn"] == "classic") {
+            scenario.ecn = ECNState::ValidatedECN;
+        } else if (combo["ecn"] == "l4s") {
+            scenario.ecn = ECNState::ValidatedL4S;
+        } else if (combo["ecn"] != "off") {
+            fmt::print(stderr, "unknown ecn {}\n", combo["ecn"]);
+            return 2;
+        }
+        if (combo["migrate"] == "reset") {
+            scenario.migrate = Scenario::Migrate::Reset;
+        } else if (combo["migrate"] == "restore") {
+            scenario.migrate = Scenario::Migrate::Restore;
+        } else if (combo["migrate"] != "off") {
+            fmt::print(stderr, "unknown migrate {}\n", combo["migrate"]);
+            return 2;
+        }
+        scenario.seed = std::stoull(combo["seed"]);
+
+        auto result = Simulation(scenario).run();
+        ok &= result.allFlowsProgressed;
+        fmt::print("{},{},{},{},{},{},{},{},{},{},{},{},{},{:.2f},{:.3f},{:.2f},{:.2f},{:.4f},{:.3f},{:.1f}\n", combo["cc"],
+            combo["rate"], combo["rtt"], combo["buffer"], combo["loss"], combo["burst"], combo["agg"],
+            combo["jitter"], combo["pacing"], combo["hystart"], combo["ecn"], combo["migrate"], combo["seed"],
+            result.goodputMbps, result.utilization, result.meanQueueDelayMs, result.p95QueueDelayMs,
+            result.lossRate, result.jainIndex, result.timeToFullRateMs);
+    }
+    return ok ? 0 : 1;
+}
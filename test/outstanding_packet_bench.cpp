@@ -0,0 +1,189 @@
+#include "src/state/outstanding_packet_ring.h"
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace quic;
+
+/*
+    Measures the footprint of an outstanding packet, the cost of recording
+    packets as they are sent and of the two hot walks over the outstanding
+    packets: the loss detection scan, which reads the send time and size of
+    every packet, and ack processing, which looks up and erases the acked
+    packet numbers. Caches are flushed before each timed walk, as on a busy
+    shard the outstanding packets of a connection are rarely still cached when
+    its next ACK arrives. Each packet carries a frame of new data for each of
+    [streams per packet] streams; the per stream details keep two streams
+    inline, so more streams than that cost an allocation per packet.
+
+    Before timing anything it checks that hasRetransmittedStreamData is set
+    for every packet in which ack processing finds a retransmitted frame, and
+    exits with 1 otherwise.
+
+    Before the metadata was split into hot fields and a cold block,
+    sizeof(OutstandingPacketMetadata) was 568 and
+    sizeof(OutstandingPacketWrapper) 848.
+
+    usage: outstanding_packet_bench [packets in flight] [rounds] [streams per packet]
+*/
+
+namespace {
+
+constexpr uint64_t kPacketSize = 1252;
+
+void fillRing(OutstandingPacketRing& ring, uint64_t numPackets, uint64_t streamsPerPacket, TimePoint start) {
+    LossState lossState;
+    auto connId = ConnectionId::createWithoutChecks({1, 2, 3, 4, 5, 6, 7, 8});
+    const uint64_t frameLen = kPacketSize / streamsPerPacket;
+    for (PacketNum packetNum = 0; packetNum < numPackets; packetNum++) {
+        RegularQuicWritePacket packet(ShortHeader(ProtectionType::KeyPhaseZero, connId, packetNum));
+        OutstandingPacketMetadata::DetailsPerStream detailsPerStream;
+        for (uint64_t stream = 0; stream < streamsPerPacket; stream++) {
+            WriteStreamFrame frame(4 * (stream + 1) /* streamId */, packetNum * frameLen, frameLen, false /* fin */);
+            detailsPerStream.addFrame(frame, true /* newData */);
+            packet.frames.emplace_back(frame);
+        }
+        lossState.totalPacketsSent++;
+        lossState.totalAckElicitingPacketsSent++;
+        ring.emplace(packetNum, std::move(packet), start + std::chrono::microseconds(packetNum), kPacketSize,
+            kPacketSize - 30, false /* isHandshake */, (packetNum + 1) * kPacketSize, (packetNum + 1) * kPacketSize,
+            (packetNum + 1) * kPacketSize, packetNum + 1, lossState, packetNum /* writeCount */,
+            std::move(detailsPerStream));
+    }
+}
+
+// Whether ack processing counts any frame of the packet as a retransmission,
+// going by the per stream details as it does.
+bool anyFrameRetransmitted(const std::vector<std::pair<WriteStreamFrame, bool>>& frames,
+    const OutstandingPacketMetadata::DetailsPerStream& detailsPerStream) {
+    for (const auto& [frame, newData] : frames) {
+        const auto& firstNewOffset = detailsPerStream.at(frame.streamId).maybeFirstNewStreamByteOffset;
+        if (!firstNewOffset.has_value() || *firstNewOffset > frame.offset) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool checkRetransmittedStreamDataFlag() {
+    struct Case {
+        const char* name;
+        std::vector<std::pair<WriteStreamFrame, bool /* newData */>> frames;
+    };
+    const std::vector<Case> cases = {
+        {"new data", {{WriteStreamFrame(4, 0, 100, false), true}}},
+        {"retransmitted data", {{WriteStreamFrame(4, 0, 100, false), false}}},
+        {"new fin only", {{WriteStreamFrame(4, 100, 0, true), true}}},
+        {"retransmitted fin only", {{WriteStreamFrame(4, 100, 0, true), false}}},
+        {"new data and fin only", {{WriteStreamFrame(4, 0, 100, false), true}, {WriteStreamFrame(4, 100, 0, true), true}}},
+        {"new and retransmitted streams", {{WriteStreamFrame(4, 0, 100, false), true}, {WriteStreamFrame(8, 0, 100, false), false}}},
+        {"new data and retransmitted fin only stream",
+            {{WriteStreamFrame(4, 0, 100, false), true}, {WriteStreamFrame(8, 100, 0, true), false}}},
+    };
+    bool ok = true;
+    for (const auto& testCase : cases) {
+        OutstandingPacketMetadata::DetailsPerStream detailsPerStream;
+        for (const auto& [frame, newData] : testCase.frames) {
+            detailsPerStream.addFrame(frame, newData);
+        }
+        const bool expected = anyFrameRetransmitted(testCase.frames, detailsPerStream);
+        OutstandingPacketMetadata metadata(Clock::now(), kPacketSize, kPacketSize - 30, false /* isHandshake */,
+            kPacketSize, kPacketSize, kPacketSize, 1, LossState(), 0 /* writeCount */, std::move(detailsPerStream));
+        if (metadata.hasRetransmittedStreamData != expected) {
+            fmt::print("hasRetransmittedStreamData is {} for {}, expected {}\n", metadata.hasRetransmittedStreamData,
+                testCase.name, expected);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+void evictCaches() {
+    static std::vector<uint8_t> buffer(64 << 20);
+    for (size_t i = 0; i < buffer.size(); i += 64) {
+        buffer[i]++;
+    }
+}
+
+template <typename Fn>
+double timeNsPerPacket(uint64_t numPackets, uint64_t rounds, Fn&& fn) {
+    std::chrono::nanoseconds total{0};
+    for (uint64_t round = 0; round < rounds; round++) {
+        total += fn();
+    }
+    return static_cast<double>(total.count()) / static_cast<double>(numPackets * rounds);
+}
+
+} // namespace
+
+int main(int ac, char** av) {
+    uint64_t numPackets = ac > 1 ? std::stoull(av[1]) : 10000;
+    uint64_t rounds = ac > 2 ? std::stoull(av[2]) : 20;
+    uint64_t streamsPerPacket = std::max<uint64_t>(ac > 3 ? std::stoull(av[3]) : 1, 1);
+
+    if (!checkRetransmittedStreamDataFlag()) {
+        return 1;
+    }
+
+    fmt::print("sizeof(OutstandingPacketMetadata)       = {}\n", sizeof(OutstandingPacketMetadata));
+    fmt::print("sizeof(OutstandingPacketMetadata::Cold) = {}\n", sizeof(OutstandingPacketMetadata::Cold));
+    fmt::print("sizeof(OutstandingPacketWrapper)        = {}\n", sizeof(OutstandingPacketWrapper));
+
+    auto start = Clock::now();
+    uint64_t checksum = 0;
+
+    // Send path: record every packet, with its per stream details.
+    auto fillNs = timeNsPerPacket(numPackets, rounds, [&]() {
+        OutstandingPacketRing ring;
+        auto begin = std::chrono::steady_clock::now();
+        fillRing(ring, numPackets, streamsPerPacket, start);
+        auto elapsed = std::chrono::steady_clock::now() - begin;
+        checksum += ring.size();
+        return elapsed;
+    });
+
+    // Loss detection style scan: visit every packet and read its hot fields.
+    auto scanNs = timeNsPerPacket(numPackets, rounds, [&]() {
+        OutstandingPacketRing ring;
+        fillRing(ring, numPackets, streamsPerPacket, start);
+        evictCaches();
+        auto begin = std::chrono::steady_clock::now();
+        for (const auto& packet : ring) {
+            if (!packet.declaredLost && packet.metadata.time > start) {
+                checksum += packet.metadata.encodedSize;
+            }
+        }
+        return std::chrono::steady_clock::now() - begin;
+    });
+
+    // Ack processing style walk: every other packet is acked, in ranges of one,
+    // which is the worst case for range based processing.
+    auto ackNs = timeNsPerPacket(numPackets, rounds, [&]() {
+        OutstandingPacketRing ring;
+        fillRing(ring, numPackets, streamsPerPacket, start);
+        evictCaches();
+        auto begin = std::chrono::steady_clock::now();
+        for (PacketNum packetNum = numPackets; packetNum-- > 0;) {
+            if (packetNum % 2) {
+                continue;
+            }
+            if (auto packet = ring.find(packetNum)) {
+                checksum += packet->metadata.inflightBytes;
+                if (packet->metadata.hasRetransmittedStreamData) {
+                    checksum += packet->metadata.detailsPerStream.size();
+                }
+                ring.erase(packetNum);
+            }
+        }
+        return std::chrono::steady_clock::now() - begin;
+    });
+
+    fmt::print("packets in flight: {}, rounds: {}, streams per packet: {}\n", numPackets, rounds, streamsPerPacket);
+    fmt::print("send:      {:.2f} ns/packet\n", fillNs);
+    fmt::print("loss scan: {:.2f} ns/packet\n", scanNs);
+    fmt::print("ack walk:  {:.2f} ns/packet\n", ackNs);
+    fmt::print("checksum:  {}\n", checksum);
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "src/common/FunctionLooper.h"
+#include <fmt/core.h>
+
+#include <folly/Random.h>
+#include <time.h>
+
+#include <chrono>
+#include <vector>
+
+using namespace quic;
+
+/*
+    Paces many write loopers on one event base, each with its own pacing
+    timeout on the pacing timer and then through the ShardPacingCalendar, and
+    compares what the event base thread spends per paced write, how often it
+    wakes up and how late the writes go out. The writes do nothing, so the
+    thread time is the cost of timing them. Each looper starts at a random
+    point of its write interval.
+
+    usage: pacing_calendar_bench [connections] [write interval us] [seconds]
+*/
+
+namespace {
+
+struct PacedConnection {
+    FunctionLooper::Ptr looper;
+    std::chrono::microseconds writeInterval{0};
+    bool started{false};
+    folly::Optional<TimePoint> due;
+    uint64_t writes{0};
+    std::chrono::microseconds lateness{0};
+};
+
+struct Result {
+    uint64_t writes{0};
+    uint64_t loops{0};
+    std::chrono::nanoseconds threadTime{0};
+    std::chrono::microseconds lateness{0};
+};
+
+std::chrono::nanoseconds threadCpuTime() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+Result runPaced(bool usePacingCalendar, uint64_t numConnections, std::chrono::microseconds writeInterval,
+    std::chrono::seconds duration) {
+    folly::EventBase evb;
+    QuicEventBase qevb(&evb);
+    TimerHighRes::SharedPtr pacingTimer = TimerHighRes::newTimer(&evb, kDefaultPacingTimerResolution);
+
+    std::vector<PacedConnection> connections(numConnections);
+    for (auto& connection : connections) {
+        connection.writeInterval = writeInterval;
+        connection.looper.reset(new FunctionLooper(
+            &qevb,
+            [&connection]() {
+                auto now = Clock::now();
+                if (connection.due && now > *connection.due) {
+                    connection.lateness += std::chrono::duration_cast<std::chrono::microseconds>(now - *connection.due);
+                }
+                connection.due.reset();
+                connection.writes++;
+            },
+            LooperType::WriteLooper));
+        connection.looper->setPacingTimer(pacingTimer);
+        connection.looper->setUsePacingCalendar(usePacingCalendar);
+        connection.looper->setPacingFunction([&connection]() {
+            auto timeUntilWrite = connection.writeInterval;
+            if (!connection.started) {
+                connection.started = true;
+                timeUntilWrite = std::chrono::microseconds(folly::Random::rand64(1, connection.writeInterval.count() + 1));
+            }
+            connection.due = Clock::now() + timeUntilWrite;
+            return timeUntilWrite;
+        });
+    }
+
+    Result result;
+    const auto startThreadTime = threadCpuTime();
+    const auto end = Clock::now() + duration;
+    for (auto& connection : connections) {
+        connection.looper->run();
+    }
+    while (Clock::now() < end) {
+        evb.loopOnce();
+        result.loops++;
+    }
+    result.threadTime = threadCpuTime() - startThreadTime;
+
+    for (auto& connection : connections) {
+        connection.looper->stop();
+        result.writes += connection.writes;
+        result.lateness += connection.lateness;
+    }
+    connections.clear();
+    return result;
+}
+
+void printResult(const char* name, const Result& result, std::chrono::seconds duration) {
+    fmt::print("{:<9} writes: {:>9}  thread time: {:>6.1f} ms  per write: {:>6.1f} ns  wakeups/s: {:>7.0f}  "
+               "mean lateness: {:>5.1f} us\n",
+        name, result.writes, result.threadTime.count() / 1e6,
+        static_cast<double>(result.threadTime.count()) / static_cast<double>(std::max<uint64_t>(result.writes, 1)),
+        static_cast<double>(result.loops) / static_cast<double>(duration.count()),
+        static_cast<double>(result.lateness.count()) / static_cast<double>(std::max<uint64_t>(result.writes, 1)));
+}
+
+} // namespace
+
+int main(int ac, char** av) {
+    uint64_t numConnections = ac > 1 ? std::stoull(av[1]) : 1000;
+    std::chrono::microseconds writeInterval(ac > 2 ? std::stoull(av[2]) : 1000);
+    std::chrono::seconds duration(ac > 3 ? std::stoull(av[3]) : 2);
+
+    fmt::print("connections: {}, write interval: {} us, pacing timer tick: {} us, {} s each\n", numConnections,
+        writeInterval.count(), kDefaultPacingTimerResolution.count(), duration.count());
+    printResult("timer", runPaced(false, numConnections, writeInterval, duration), duration);
+    printResult("calendar", runPaced(true, numConnections, writeInterval, duration), duration);
+    return 0;
+}
@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// The congestion control test targets keep a connection state, which owns a
+// read codec, but never parse a packet. quic_read_codec.cpp doesn't build on
+// its own yet, so this provides the codec's out-of-line virtuals instead.
+
+#include "src/protocol/quic_read_codec.hpp"
+
+#include <cstdlib>
+
+namespace quic {
+
+CodecResult QuicReadCodec::parsePacket(BufQueue&, const AckStates&, size_t) {
+    std::abort();
+}
+
+CodecResult QuicReadCodec::parsePacket(const char*, size_t, const AckStates&, size_t) {
+    std::abort();
+}
+
+} // namespace quic
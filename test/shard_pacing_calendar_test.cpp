@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "src/common/ShardPacingCalendar.h"
+#include <fmt/core.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+using namespace quic;
+
+/*
+    Drives a ShardPacingCalendar without a pacing timer, through advance()
+    and nextWakeup() alone: around the ring several times, with write times
+    past its span parked in the last slot, with entries rescheduled, cancelled
+    and destroyed while it runs them, and with the occupied bits destroyed
+    entries leave behind. Exits with 1 if any check fails.
+*/
+
+namespace {
+
+bool failed = false;
+
+#define EXPECT_EQ(a, b)                                                                              \
+    do {                                                                                             \
+        const auto& lhs = (a);                                                                       \
+        const auto& rhs = (b);                                                                       \
+        if (!(lhs == rhs)) {                                                                         \
+            fmt::print("{}:{}: {} == {} failed ({} vs {})\n", __FILE__, __LINE__, #a, #b, lhs, rhs); \
+            failed = true;                                                                           \
+        }                                                                                            \
+    } while (0)
+
+#define EXPECT(cond)                                                                                 \
+    do {                                                                                             \
+        if (!(cond)) {                                                                               \
+            fmt::print("{}:{}: {} failed\n", __FILE__, __LINE__, #cond);                             \
+            failed = true;                                                                           \
+        }                                                                                            \
+    } while (0)
+
+class TestEntry : public ShardPacingCalendar::Entry {
+public:
+    size_t runs{0};
+    size_t cancels{0};
+    TimePoint lastRun;
+    std::function<void(TimePoint)> onRun;
+
+protected:
+    void pacingDeadlineReached(TimePoint now) noexcept override {
+        ++runs;
+        lastRun = now;
+        if (onRun) {
+            onRun(now);
+        }
+    }
+
+    void calendarCanceled() noexcept override {
+        ++cancels;
+    }
+};
+
+std::chrono::milliseconds ms(int64_t count) {
+    return std::chrono::milliseconds(count);
+}
+
+std::chrono::microseconds us(int64_t count) {
+    return std::chrono::microseconds(count);
+}
+
+// Whether wakeup is the start of the slot deadline falls in.
+bool isSlotOf(const ShardPacingCalendar& calendar, folly::Optional<TimePoint> wakeup, TimePoint deadline) {
+    return wakeup && *wakeup >= deadline && *wakeup < deadline + calendar.slotInterval();
+}
+
+// The calendar runs an entry at the first advance() to its slot, around the
+// ring as many times as it takes.
+void testWrap() {
+    ShardPacingCalendar calendar;
+    const auto base = Clock::now();
+    EXPECT(!calendar.nextWakeup());
+
+    // About two and a half times around the ring.
+    TestEntry entry;
+    for (int64_t t = 1; t <= 1000; t += 7) {
+        calendar.schedule(entry, base + ms(t));
+        const auto wakeup = calendar.nextWakeup();
+        EXPECT(isSlotOf(calendar, wakeup, base + ms(t)));
+        if (!wakeup) {
+            return;
+        }
+        EXPECT_EQ(calendar.advance(*wakeup - us(1)), 0u);
+        EXPECT_EQ(calendar.advance(*wakeup), 1u);
+        EXPECT(!entry.hasPacingDeadline());
+        EXPECT(entry.lastRun == *wakeup);
+    }
+    EXPECT_EQ(entry.runs, 143u);
+    EXPECT(!calendar.nextWakeup());
+
+    // Entries on both sides of the end of the ring array run in write time
+    // order. Slot 3 * kSlots starts 1228.8ms after the calendar.
+    std::vector<int> order;
+    TestEntry before;
+    TestEntry after;
+    TestEntry last;
+    before.onRun = [&](TimePoint) { order.push_back(1); };
+    after.onRun = [&](TimePoint) { order.push_back(2); };
+    last.onRun = [&](TimePoint) { order.push_back(3); };
+    calendar.schedule(last, base + ms(1300));
+    // Only filed ahead of the calendar's position in the array.
+    EXPECT(isSlotOf(calendar, calendar.nextWakeup(), base + ms(1300)));
+    calendar.schedule(after, base + ms(1232));
+    calendar.schedule(before, base + ms(1226));
+    EXPECT(isSlotOf(calendar, calendar.nextWakeup(), base + ms(1226)));
+    EXPECT_EQ(calendar.advance(base + ms(1400)), 3u);
+    EXPECT(order == (std::vector<int>{1, 2, 3}));
+}
+
+// Write times past the span of the ring wait in its last slot and are filed
+// again from there until they are in reach.
+void testLastSlot() {
+    ShardPacingCalendar calendar;
+    const auto base = Clock::now();
+    const auto span = ShardPacingCalendar::kSlots * calendar.slotInterval();
+
+    TestEntry far;
+    calendar.schedule(far, base + ms(1000));
+    auto wakeup = calendar.nextWakeup();
+    EXPECT(wakeup && *wakeup > base + span - ms(10) && *wakeup < base + span);
+    if (!wakeup) {
+        return;
+    }
+    // An entry actually due in that slot runs, the parked one moves on.
+    TestEntry near;
+    calendar.schedule(near, *wakeup);
+    EXPECT_EQ(calendar.advance(*wakeup), 1u);
+    EXPECT_EQ(near.runs, 1u);
+    EXPECT_EQ(far.runs, 0u);
+    EXPECT(far.hasPacingDeadline());
+    EXPECT(far.pacingDeadline() == folly::Optional<TimePoint>(base + ms(1000)));
+    const auto parkedAgain = calendar.nextWakeup();
+    EXPECT(parkedAgain && *parkedAgain > *wakeup + span - ms(1));
+
+    size_t advances = 1;
+    wakeup = parkedAgain;
+    while (wakeup && far.runs == 0 && advances < 10) {
+        calendar.advance(*wakeup);
+        ++advances;
+        wakeup = calendar.nextWakeup();
+    }
+    EXPECT_EQ(far.runs, 1u);
+    EXPECT(far.lastRun >= base + ms(1000) && far.lastRun < base + ms(1000) + calendar.slotInterval());
+    // Parked twice, then run.
+    EXPECT_EQ(advances, 3u);
+    EXPECT(!calendar.nextWakeup());
+}
+
+// Entries run by advance() may reschedule themselves and others, and cancel
+// or destroy the ones due after them in the same slot.
+void testRescheduleWhileAdvancing() {
+    ShardPacingCalendar calendar;
+    const auto base = Clock::now();
+
+    TestEntry first;
+    TestEntry moved;
+    TestEntry canceled;
+    auto destroyed = std::make_unique<TestEntry>();
+    first.onRun = [&](TimePoint now) {
+        if (first.runs > 1) {
+            return;
+        }
+        calendar.schedule(first, now + ms(20));
+        calendar.schedule(moved, now + ms(50));
+        calendar.cancel(canceled);
+        destroyed.reset();
+    };
+    calendar.schedule(first, base + ms(10));
+    calendar.schedule(moved, base + ms(10));
+    calendar.schedule(canceled, base + ms(10));
+    calendar.schedule(*destroyed, base + ms(10));
+
+    EXPECT_EQ(calendar.advance(base + ms(11)), 1u);
+    EXPECT_EQ(first.runs, 1u);
+    EXPECT_EQ(moved.runs, 0u);
+    EXPECT_EQ(canceled.runs, 0u);
+    EXPECT(!canceled.hasPacingDeadline());
+    // The earliest write time was set from within advance().
+    EXPECT(isSlotOf(calendar, calendar.nextWakeup(), base + ms(31)));
+
+    EXPECT_EQ(calendar.advance(base + ms(40)), 1u);
+    EXPECT_EQ(first.runs, 2u);
+    EXPECT_EQ(calendar.advance(base + ms(62)), 1u);
+    EXPECT_EQ(moved.runs, 1u);
+    EXPECT_EQ(canceled.runs, 0u);
+    EXPECT(!calendar.nextWakeup());
+
+    // Rescheduled for a time already gone by, an entry runs in the next slot
+    // rather than again in the one being run.
+    TestEntry overdue;
+    overdue.onRun = [&](TimePoint now) {
+        if (overdue.runs == 1) {
+            calendar.schedule(overdue, now - ms(1));
+        }
+    };
+    calendar.schedule(overdue, base + ms(100));
+    const auto wakeup = calendar.nextWakeup();
+    EXPECT(isSlotOf(calendar, wakeup, base + ms(100)));
+    if (!wakeup) {
+        return;
+    }
+    EXPECT_EQ(calendar.advance(*wakeup), 1u);
+    EXPECT(calendar.nextWakeup() == folly::Optional<TimePoint>(*wakeup + calendar.slotInterval()));
+    EXPECT_EQ(calendar.advance(*wakeup + calendar.slotInterval()), 1u);
+    EXPECT_EQ(overdue.runs, 2u);
+}
+
+// An entry destroyed while filed unlinks itself but leaves its slot's occupied
+// bit set. The calendar may wake up for that slot, and clears it then.
+void testStaleOccupiedBits() {
+    ShardPacingCalendar calendar;
+    const auto base = Clock::now();
+
+    auto destroyed = std::make_unique<TestEntry>();
+    calendar.schedule(*destroyed, base + ms(10));
+    const auto staleWakeup = calendar.nextWakeup();
+    EXPECT(isSlotOf(calendar, staleWakeup, base + ms(10)));
+    destroyed.reset();
+    EXPECT(calendar.nextWakeup() == staleWakeup);
+
+    TestEntry later;
+    calendar.schedule(later, base + ms(20));
+    EXPECT(calendar.nextWakeup() == staleWakeup);
+    if (!staleWakeup) {
+        return;
+    }
+    EXPECT_EQ(calendar.advance(*staleWakeup), 0u);
+    const auto wakeup = calendar.nextWakeup();
+    EXPECT(isSlotOf(calendar, wakeup, base + ms(20)));
+    if (!wakeup) {
+        return;
+    }
+    EXPECT_EQ(calendar.advance(*wakeup), 1u);
+    EXPECT(!calendar.nextWakeup());
+
+    // The same slot of the array a lap later holds only the new entry.
+    const auto lap = ShardPacingCalendar::kSlots * calendar.slotInterval();
+    auto stale = std::make_unique<TestEntry>();
+    calendar.schedule(*stale, base + ms(100));
+    stale.reset();
+    calendar.advance(base + ms(100) + lap - ms(1));
+    TestEntry nextLap;
+    calendar.schedule(nextLap, base + ms(100) + lap);
+    const auto nextLapWakeup = calendar.nextWakeup();
+    EXPECT(isSlotOf(calendar, nextLapWakeup, base + ms(100) + lap));
+    if (!nextLapWakeup) {
+        return;
+    }
+    EXPECT_EQ(calendar.advance(*nextLapWakeup), 1u);
+
+    // Cancelling the last entry of a slot clears its bit right away.
+    TestEntry canceled;
+    calendar.schedule(canceled, base + ms(1000));
+    calendar.cancel(canceled);
+    EXPECT(!calendar.nextWakeup());
+
+    TestEntry pending;
+    calendar.schedule(pending, base + ms(1100));
+    calendar.cancelAll();
+    EXPECT_EQ(pending.cancels, 1u);
+    EXPECT(!pending.hasPacingDeadline());
+    EXPECT(!calendar.nextWakeup());
+}
+
+} // namespace
+
+int main() {
+    testWrap();
+    testLastSlot();
+    testRescheduleWhileAdvancing();
+    testStaleOccupiedBits();
+    if (failed) {
+        return 1;
+    }
+    fmt::print("ok\n");
+    return 0;
+}
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "src/common/ShardTimerWheel.h"
+#include <fmt/core.h>
+
+#include <folly/io/async/EventBase.h>
+
+#include <functional>
+#include <memory>
+
+using namespace quic;
+
+/*
+    Drives ShardTimerWheel through advance() across all its levels, with
+    entries cancelled, moved and destroyed while filed, and then from the
+    timers of two event bases on one thread, one of which is destroyed with
+    entries still scheduled. Exits with 1 if any check fails.
+*/
+
+namespace {
+
+bool failed = false;
+
+#define EXPECT_EQ(a, b)                                                                              \
+    do {                                                                                             \
+        const auto& lhs = (a);                                                                       \
+        const auto& rhs = (b);                                                                       \
+        if (!(lhs == rhs)) {                                                                         \
+            fmt::print("{}:{}: {} == {} failed ({} vs {})\n", __FILE__, __LINE__, #a, #b, lhs, rhs); \
+            failed = true;                                                                           \
+        }                                                                                            \
+    } while (0)
+
+#define EXPECT(cond)                                                                                 \
+    do {                                                                                             \
+        if (!(cond)) {                                                                               \
+            fmt::print("{}:{}: {} failed\n", __FILE__, __LINE__, #cond);                             \
+            failed = true;                                                                           \
+        }                                                                                            \
+    } while (0)
+
+class TestEntry : public ShardTimerWheel::Entry {
+public:
+    size_t runs{0};
+    size_t cancels{0};
+    TimePoint lastRun;
+    std::function<void(TimePoint)> onRun;
+
+protected:
+    void deadlineReached(TimePoint now) noexcept override {
+        ++runs;
+        lastRun = now;
+        if (onRun) {
+            onRun(now);
+        }
+    }
+
+    void wheelCanceled() noexcept override {
+        ++cancels;
+    }
+};
+
+std::chrono::milliseconds ms(int64_t count) {
+    return std::chrono::milliseconds(count);
+}
+
+// Entries on every level run once, at the first advance() past their deadline.
+void testCascade() {
+    ShardTimerWheel wheel;
+    const auto base = Clock::now();
+    EXPECT(!wheel.nextWakeup());
+
+    // Level 0, 1, 2 and 3 of the wheel.
+    const int64_t deadlines[] = {5, 300, 70000, 20000000};
+    TestEntry entries[4];
+    for (size_t i = 0; i < 4; ++i) {
+        wheel.schedule(entries[i], base + ms(deadlines[i]));
+    }
+    EXPECT(wheel.nextWakeup().has_value());
+
+    for (size_t i = 0; i < 4; ++i) {
+        EXPECT_EQ(wheel.advance(base + ms(deadlines[i] - 1)), 0u);
+        EXPECT_EQ(entries[i].runs, 0u);
+        EXPECT_EQ(wheel.advance(base + ms(deadlines[i] + 1)), 1u);
+        EXPECT_EQ(entries[i].runs, 1u);
+        EXPECT(!entries[i].isScheduled());
+        EXPECT(entries[i].lastRun == base + ms(deadlines[i] + 1));
+    }
+    EXPECT(!wheel.nextWakeup());
+    EXPECT_EQ(wheel.advance(base + ms(40000000)), 0u);
+
+    // An entry filed on a higher level and cascading down is due by the time
+    // the wheel says to wake up.
+    TestEntry entry;
+    const auto now = base + ms(40000000);
+    wheel.schedule(entry, now + ms(1000));
+    auto wakeup = wheel.nextWakeup();
+    size_t steps = 0;
+    while (wakeup && entry.runs == 0 && steps++ < 100) {
+        wheel.advance(*wakeup);
+        wakeup = wheel.nextWakeup();
+    }
+    EXPECT_EQ(entry.runs, 1u);
+    EXPECT(entry.lastRun >= now + ms(1000));
+}
+
+void testCancel() {
+    ShardTimerWheel wheel;
+    const auto base = Clock::now();
+
+    TestEntry canceled;
+    wheel.schedule(canceled, base + ms(10));
+    wheel.cancel(canceled);
+    EXPECT(!canceled.isScheduled());
+    EXPECT_EQ(wheel.advance(base + ms(20)), 0u);
+    EXPECT_EQ(canceled.runs, 0u);
+
+    // Moving a deadline later leaves the entry in its slot until it comes up.
+    TestEntry later;
+    wheel.schedule(later, base + ms(30));
+    wheel.schedule(later, base + ms(600));
+    EXPECT_EQ(wheel.advance(base + ms(31)), 0u);
+    EXPECT(later.isScheduled());
+    EXPECT_EQ(wheel.advance(base + ms(599)), 0u);
+    EXPECT_EQ(wheel.advance(base + ms(601)), 1u);
+    EXPECT_EQ(later.runs, 1u);
+
+    // Moving it earlier relinks it.
+    TestEntry earlier;
+    wheel.schedule(earlier, base + ms(5000));
+    wheel.schedule(earlier, base + ms(610));
+    EXPECT_EQ(wheel.advance(base + ms(611)), 1u);
+    EXPECT_EQ(earlier.runs, 1u);
+    EXPECT_EQ(wheel.advance(base + ms(5001)), 0u);
+    EXPECT_EQ(earlier.runs, 1u);
+
+    TestEntry removed;
+    wheel.schedule(removed, base + ms(6020));
+    wheel.remove(removed);
+    EXPECT_EQ(wheel.advance(base + ms(6021)), 0u);
+
+    // An entry destroyed while filed unlinks itself.
+    auto destroyed = std::make_unique<TestEntry>();
+    wheel.schedule(*destroyed, base + ms(6100));
+    destroyed.reset();
+    EXPECT_EQ(wheel.advance(base + ms(6101)), 0u);
+
+    // Entries may reschedule themselves, or cancel others due on the same tick.
+    TestEntry repeating;
+    TestEntry victim;
+    repeating.onRun = [&](TimePoint now) {
+        wheel.cancel(victim);
+        if (repeating.runs < 3) {
+            wheel.schedule(repeating, now + ms(10));
+        }
+    };
+    wheel.schedule(repeating, base + ms(6200));
+    wheel.schedule(victim, base + ms(6200));
+    for (int64_t t = 6201; t < 6300; t += 5) {
+        wheel.advance(base + ms(t));
+    }
+    EXPECT_EQ(repeating.runs, 3u);
+    EXPECT_EQ(victim.runs, 0u);
+
+    TestEntry pending;
+    wheel.schedule(pending, base + ms(7000));
+    wheel.cancelAll();
+    EXPECT_EQ(pending.cancels, 1u);
+    EXPECT(!pending.isScheduled());
+    EXPECT(!wheel.nextWakeup());
+}
+
+// Runs evb until entry ran or a second has passed.
+void loopUntilRun(folly::EventBase& evb, const TestEntry& entry) {
+    const auto giveUp = Clock::now() + ms(1000);
+    while (entry.runs == 0 && Clock::now() < giveUp) {
+        evb.loopOnce();
+    }
+}
+
+void testEventBases() {
+    auto evb1 = std::make_unique<folly::EventBase>();
+    folly::EventBase evb2;
+    auto& wheel1 = ShardTimerWheel::get(*evb1);
+    auto& wheel2 = ShardTimerWheel::get(evb2);
+    EXPECT(&wheel1 != &wheel2);
+    EXPECT(&wheel1 == &ShardTimerWheel::get(*evb1));
+
+    // Each wheel runs from its own evb's timer.
+    TestEntry entry1;
+    TestEntry entry2;
+    wheel1.schedule(entry1, Clock::now() + ms(2));
+    wheel2.schedule(entry2, Clock::now() + ms(5));
+    loopUntilRun(evb2, entry2);
+    EXPECT_EQ(entry2.runs, 1u);
+    EXPECT_EQ(entry1.runs, 0u);
+    loopUntilRun(*evb1, entry1);
+    EXPECT_EQ(entry1.runs, 1u);
+
+    // Destroying an evb cancels what is still scheduled on its wheel.
+    TestEntry armed;
+    TestEntry filed;
+    wheel1.schedule(armed, Clock::now() + ms(3600000));
+    wheel1.schedule(filed, Clock::now() + ms(7200000));
+    evb1.reset();
+    EXPECT_EQ(armed.cancels, 1u);
+    EXPECT_EQ(filed.cancels, 1u);
+    EXPECT(!armed.isScheduled());
+
+    // A new evb gets a wheel of its own, even at the old one's address.
+    evb1 = std::make_unique<folly::EventBase>();
+    TestEntry again;
+    ShardTimerWheel::get(*evb1).schedule(again, Clock::now() + ms(2));
+    loopUntilRun(*evb1, again);
+    EXPECT_EQ(again.runs, 1u);
+
+    TestEntry leftover;
+    ShardTimerWheel::get(evb2).schedule(leftover, Clock::now() + ms(3600000));
+    evb1.reset();
+    EXPECT(leftover.isScheduled());
+    EXPECT_EQ(leftover.cancels, 0u);
+    ShardTimerWheel::get(evb2).cancel(leftover);
+}
+
+} // namespace
+
+int main() {
+    testCascade();
+    testCancel();
+    testEventBases();
+    if (failed) {
+        return 1;
+    }
+    fmt::print("ok\n");
+    return 0;
+}
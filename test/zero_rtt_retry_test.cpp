@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "src/state/state_data.h"
+#include <fmt/core.h>
+
+using namespace quic;
+
+/*
+    Carries the zero rtt packets of a client over to a fresh connection state,
+    as on a retry, with some of them and of the packets left behind cloned,
+    and checks their clone groups come along without aliasing the groups the
+    new state opens. Exits with 1 if any check fails.
+*/
+
+namespace {
+
+bool failed = false;
+
+#define EXPECT_EQ(a, b)                                                                              \
+    do {                                                                                             \
+        const auto& lhs = (a);                                                                       \
+        const auto& rhs = (b);                                                                       \
+        if (!(lhs == rhs)) {                                                                         \
+            fmt::print("{}:{}: {} == {} failed ({} vs {})\n", __FILE__, __LINE__, #a, #b, lhs, rhs); \
+            failed = true;                                                                           \
+        }                                                                                            \
+    } while (0)
+
+#define EXPECT(cond)                                                                                 \
+    do {                                                                                             \
+        if (!(cond)) {                                                                               \
+            fmt::print("{}:{}: {} failed\n", __FILE__, __LINE__, #cond);                             \
+            failed = true;                                                                           \
+        }                                                                                            \
+    } while (0)
+
+const ConnectionId kConnId = ConnectionId::createWithoutChecks({1, 2, 3, 4, 5, 6, 7, 8});
+
+// Sends packetNum in space, as a clone in group if there is one.
+void send(OutstandingsInfo& outstandings, PacketNumberSpace space, LongHeader::Types type, PacketNum packetNum,
+    const folly::Optional<PacketEvent>& group) {
+    RegularQuicWritePacket packet(LongHeader(type, kConnId, kConnId, packetNum, QuicVersion::MVFST));
+    LossState lossState;
+    auto& outstanding = outstandings.packets[space].emplace(packetNum, std::move(packet), Clock::now(), 1200, 1200,
+        false /* isHandshake */, 0, 0, 0, 0, lossState, 0, OutstandingPacketMetadata::DetailsPerStream());
+    outstandings.packetCount[space]++;
+    if (group) {
+        outstandings.cloneGroups.addRef(*group);
+        outstanding.associatedEvent = group;
+        outstandings.clonedPacketCount[space]++;
+    }
+}
+
+} // namespace
+
+int main() {
+    OutstandingsInfo oldOutstandings;
+    // A cloned initial packet, whose group goes away with it.
+    auto initialGroup = oldOutstandings.cloneGroups.open();
+    send(oldOutstandings, PacketNumberSpace::Initial, LongHeader::Types::Initial, 0, initialGroup);
+    oldOutstandings.cloneGroups.release(initialGroup);
+    // Zero rtt packets, two in one clone group and one on its own.
+    auto zeroRttGroup = oldOutstandings.cloneGroups.open();
+    send(oldOutstandings, PacketNumberSpace::AppData, LongHeader::Types::ZeroRtt, 0, zeroRttGroup);
+    send(oldOutstandings, PacketNumberSpace::AppData, LongHeader::Types::ZeroRtt, 1, zeroRttGroup);
+    oldOutstandings.cloneGroups.release(zeroRttGroup);
+    send(oldOutstandings, PacketNumberSpace::AppData, LongHeader::Types::ZeroRtt, 2, folly::none);
+    EXPECT_EQ(oldOutstandings.cloneGroups.numPending(), 2u);
+
+    OutstandingsInfo newOutstandings;
+    oldOutstandings.moveZeroRttPacketsTo(newOutstandings);
+
+    EXPECT_EQ(newOutstandings.packets[PacketNumberSpace::Initial].size(), 0u);
+    EXPECT_EQ(newOutstandings.packets[PacketNumberSpace::AppData].size(), 3u);
+    EXPECT_EQ(newOutstandings.packetCount[PacketNumberSpace::AppData], 3u);
+    EXPECT_EQ(newOutstandings.clonedPacketCount[PacketNumberSpace::AppData], 2u);
+    // Only the zero rtt group is left, still pending for the packets carrying
+    // it.
+    EXPECT_EQ(newOutstandings.cloneGroups.numPending(), 1u);
+    EXPECT(newOutstandings.cloneGroups.isPending(zeroRttGroup));
+    auto carried = newOutstandings.packets[PacketNumberSpace::AppData].find(0);
+    EXPECT(carried && carried->associatedEvent == folly::Optional<PacketEvent>(zeroRttGroup));
+
+    // Groups opened by the new state don't alias the carried one.
+    auto newGroup = newOutstandings.cloneGroups.open();
+    EXPECT(!(newGroup == zeroRttGroup));
+    newOutstandings.cloneGroups.markProcessed(newGroup);
+    EXPECT(newOutstandings.cloneGroups.isPending(zeroRttGroup));
+
+    // The group closes once both its packets are released.
+    newOutstandings.cloneGroups.release(zeroRttGroup);
+    EXPECT(newOutstandings.cloneGroups.isPending(zeroRttGroup));
+    newOutstandings.cloneGroups.release(zeroRttGroup);
+    EXPECT(!newOutstandings.cloneGroups.isPending(zeroRttGroup));
+
+    EXPECT(!oldOutstandings.cloneGroups.hasPending());
+    if (failed) {
+        return 1;
+    }
+    fmt::print("ok\n");
+    return 0;
+}